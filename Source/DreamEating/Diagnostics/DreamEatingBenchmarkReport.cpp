@@ -0,0 +1,255 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingBenchmarkReport.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProperties.h"
+#include "CoreGlobals.h"
+#include "DreamEating.h"
+
+static float GBenchmarkRegressionTolerance = 0.1f;
+static FAutoConsoleVariableRef CVarBenchmarkRegressionTolerance(
+	TEXT("DreamEating.Benchmark.RegressionTolerance"),
+	GBenchmarkRegressionTolerance,
+	TEXT("Fraction by which a scenario's p95 game thread time may exceed its baseline before it's reported as a regression."),
+	ECVF_Default);
+
+/** Adds the average and percentiles of a set of samples to a JSON object */
+static TSharedRef<FJsonObject> SummarizeSamples(const TArray<float>& Samples)
+{
+	TSharedRef<FJsonObject> Summary = MakeShared<FJsonObject>();
+
+	double Sum = 0.0;
+
+	for (float Sample : Samples)
+	{
+		Sum += Sample;
+	}
+
+	Summary->SetNumberField(TEXT("avg"), Samples.Num() > 0 ? Sum / Samples.Num() : 0.0);
+	Summary->SetNumberField(TEXT("p50"), FDreamEatingBenchmarkReport::Percentile(Samples, 0.5f));
+	Summary->SetNumberField(TEXT("p90"), FDreamEatingBenchmarkReport::Percentile(Samples, 0.9f));
+	Summary->SetNumberField(TEXT("p95"), FDreamEatingBenchmarkReport::Percentile(Samples, 0.95f));
+	Summary->SetNumberField(TEXT("p99"), FDreamEatingBenchmarkReport::Percentile(Samples, 0.99f));
+	Summary->SetNumberField(TEXT("max"), FDreamEatingBenchmarkReport::Percentile(Samples, 1.0f));
+
+	return Summary;
+}
+
+/** Converts samples to a JSON number array */
+static TArray<TSharedPtr<FJsonValue>> SamplesToJson(const TArray<float>& Samples)
+{
+	TArray<TSharedPtr<FJsonValue>> Values;
+	Values.Reserve(Samples.Num());
+
+	for (float Sample : Samples)
+	{
+		Values.Add(MakeShared<FJsonValueNumber>(Sample));
+	}
+
+	return Values;
+}
+
+void FDreamEatingBenchmarkScenario::SampleFrame()
+{
+	// use the real frame time so time dilation and fixed frame rates don't hide the cost
+	FrameTimes.Add(static_cast<float>(FApp::GetDeltaTime() * 1000.0));
+	GameThreadTimes.Add(static_cast<float>(FPlatformTime::ToMilliseconds(GGameThreadTime)));
+}
+
+void FDreamEatingBenchmarkScenario::SampleCounter(const FString& CounterName, float Value)
+{
+	Counters.FindOrAdd(CounterName).Add(Value);
+}
+
+void FDreamEatingBenchmarkScenario::LogSummary(const FString& ReportName) const
+{
+	UE_LOG(LogDreamEating, Display, TEXT("%s [%s]: %d frames, p50 game thread %.2f ms, p95 game thread %.2f ms, p95 frame %.2f ms"),
+		*ReportName,
+		*Name,
+		FrameTimes.Num(),
+		FDreamEatingBenchmarkReport::Percentile(GameThreadTimes, 0.5f),
+		FDreamEatingBenchmarkReport::Percentile(GameThreadTimes, 0.95f),
+		FDreamEatingBenchmarkReport::Percentile(FrameTimes, 0.95f));
+
+	for (const TPair<FString, double>& Metric : Metrics)
+	{
+		UE_LOG(LogDreamEating, Display, TEXT("    %s: %.3f"), *Metric.Key, Metric.Value);
+	}
+}
+
+TSharedRef<FJsonObject> FDreamEatingBenchmarkScenario::ToJson() const
+{
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+
+	Json->SetStringField(TEXT("name"), Name);
+	Json->SetNumberField(TEXT("frames"), FrameTimes.Num());
+	Json->SetObjectField(TEXT("frame_ms"), SummarizeSamples(FrameTimes));
+	Json->SetObjectField(TEXT("game_thread_ms"), SummarizeSamples(GameThreadTimes));
+
+	TSharedRef<FJsonObject> MetricsJson = MakeShared<FJsonObject>();
+
+	for (const TPair<FString, double>& Metric : Metrics)
+	{
+		MetricsJson->SetNumberField(Metric.Key, Metric.Value);
+	}
+
+	Json->SetObjectField(TEXT("metrics"), MetricsJson);
+
+	// raw samples so runs can be compared frame by frame
+	TSharedRef<FJsonObject> SamplesJson = MakeShared<FJsonObject>();
+	SamplesJson->SetArrayField(TEXT("frame_ms"), SamplesToJson(FrameTimes));
+	SamplesJson->SetArrayField(TEXT("game_thread_ms"), SamplesToJson(GameThreadTimes));
+
+	TSharedRef<FJsonObject> CountersJson = MakeShared<FJsonObject>();
+
+	for (const TPair<FString, TArray<float>>& Counter : Counters)
+	{
+		CountersJson->SetObjectField(Counter.Key, SummarizeSamples(Counter.Value));
+		SamplesJson->SetArrayField(Counter.Key, SamplesToJson(Counter.Value));
+	}
+
+	Json->SetObjectField(TEXT("counters"), CountersJson);
+	Json->SetObjectField(TEXT("samples"), SamplesJson);
+
+	return Json;
+}
+
+FDreamEatingBenchmarkReport::FDreamEatingBenchmarkReport(const FString& InName)
+	: Name(InName)
+{
+}
+
+FDreamEatingBenchmarkScenario& FDreamEatingBenchmarkReport::AddScenario(const FString& ScenarioName)
+{
+	FDreamEatingBenchmarkScenario& Scenario = Scenarios.AddDefaulted_GetRef();
+	Scenario.Name = ScenarioName;
+
+	return Scenario;
+}
+
+FString FDreamEatingBenchmarkReport::Finish() const
+{
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+
+	Json->SetStringField(TEXT("benchmark"), Name);
+	Json->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	Json->SetStringField(TEXT("build"), FApp::GetBuildVersion());
+	Json->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+	Json->SetStringField(TEXT("commandline"), FCommandLine::Get());
+
+	TArray<TSharedPtr<FJsonValue>> ScenariosJson;
+
+	for (const FDreamEatingBenchmarkScenario& Scenario : Scenarios)
+	{
+		Scenario.LogSummary(Name);
+		ScenariosJson.Add(MakeShared<FJsonValueObject>(Scenario.ToJson()));
+	}
+
+	Json->SetArrayField(TEXT("scenarios"), ScenariosJson);
+
+	FString Output;
+	FJsonSerializer::Serialize(Json, TJsonWriterFactory<>::Create(&Output));
+
+	const FString BenchmarkDir = FPaths::ProjectSavedDir() / TEXT("Benchmarks");
+	const FString Path = BenchmarkDir / FString::Printf(TEXT("%s-%s.json"), *Name, *FDateTime::Now().ToString());
+
+	if (FFileHelper::SaveStringToFile(Output, *Path))
+	{
+		UE_LOG(LogDreamEating, Display, TEXT("%s: report written to %s"), *Name, *FPaths::ConvertRelativePathToFull(Path));
+	}
+	else
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("%s: could not write report to %s"), *Name, *Path);
+	}
+
+	CompareToBaseline(BenchmarkDir / TEXT("Baselines") / (Name + TEXT(".json")));
+
+	// headless runs quit once the report is out
+	if (FParse::Param(FCommandLine::Get(), TEXT("BenchmarkExit")))
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+
+	return Path;
+}
+
+float FDreamEatingBenchmarkReport::Percentile(TArray<float> Samples, float Fraction)
+{
+	if (Samples.Num() == 0)
+	{
+		return 0.0f;
+	}
+
+	Samples.Sort();
+
+	return Samples[FMath::Clamp(FMath::FloorToInt32(Samples.Num() * Fraction), 0, Samples.Num() - 1)];
+}
+
+void FDreamEatingBenchmarkReport::CompareToBaseline(const FString& BaselinePath) const
+{
+	FString BaselineText;
+
+	if (!FFileHelper::LoadFileToString(BaselineText, *BaselinePath))
+	{
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Baseline;
+
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline) || !Baseline.IsValid())
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("%s: could not parse baseline %s"), *Name, *BaselinePath);
+		return;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* BaselineScenarios = nullptr;
+
+	if (!Baseline->TryGetArrayField(TEXT("scenarios"), BaselineScenarios))
+	{
+		return;
+	}
+
+	for (const FDreamEatingBenchmarkScenario& Scenario : Scenarios)
+	{
+		for (const TSharedPtr<FJsonValue>& Value : *BaselineScenarios)
+		{
+			const TSharedPtr<FJsonObject> BaselineScenario = Value->AsObject();
+
+			if (!BaselineScenario.IsValid() || BaselineScenario->GetStringField(TEXT("name")) != Scenario.Name)
+			{
+				continue;
+			}
+
+			const TSharedPtr<FJsonObject>* BaselineGameThread = nullptr;
+			double BaselineP95 = 0.0;
+
+			if (!BaselineScenario->TryGetObjectField(TEXT("game_thread_ms"), BaselineGameThread) || !(*BaselineGameThread)->TryGetNumberField(TEXT("p95"), BaselineP95))
+			{
+				continue;
+			}
+
+			const double CurrentP95 = Percentile(Scenario.GameThreadTimes, 0.95f);
+			const double Change = BaselineP95 > 0.0 ? (CurrentP95 - BaselineP95) / BaselineP95 : 0.0;
+
+			if (Change > GBenchmarkRegressionTolerance)
+			{
+				UE_LOG(LogDreamEating, Warning, TEXT("%s [%s]: p95 game thread %.2f ms is %.1f%% over the baseline %.2f ms"), *Name, *Scenario.Name, CurrentP95, Change * 100.0, BaselineP95);
+			}
+			else
+			{
+				UE_LOG(LogDreamEating, Display, TEXT("%s [%s]: p95 game thread %.2f ms, %+.1f%% against the baseline %.2f ms"), *Name, *Scenario.Name, CurrentP95, Change * 100.0, BaselineP95);
+			}
+		}
+	}
+}
@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+
+/**
+ *  Samples and results of a single benchmark scenario
+ */
+struct FDreamEatingBenchmarkScenario
+{
+	/** Scenario name, unique within its report */
+	FString Name;
+
+	/** Frame time samples, in milliseconds */
+	TArray<float> FrameTimes;
+
+	/** Game thread time samples, in milliseconds */
+	TArray<float> GameThreadTimes;
+
+	/** Named per-frame counters, such as live actor counts */
+	TMap<FString, TArray<float>> Counters;
+
+	/** Named scalar results, such as totals and latencies */
+	TMap<FString, double> Metrics;
+
+	/** Records the frame and game thread time of the current frame */
+	void SampleFrame();
+
+	/** Records a per-frame counter value */
+	void SampleCounter(const FString& CounterName, float Value);
+
+	/** Sets a scalar result */
+	void SetMetric(const FString& MetricName, double Value) { Metrics.Add(MetricName, Value); }
+
+	/** Logs a one line summary of the scenario */
+	void LogSummary(const FString& ReportName) const;
+
+	/** Serializes the scenario with its percentiles and raw samples */
+	TSharedRef<FJsonObject> ToJson() const;
+};
+
+/**
+ *  Benchmark report shared by the headless benchmarks.
+ *  Collects one or more scenarios and writes them as JSON to Saved/Benchmarks/<Name>-<Timestamp>.json.
+ *  If Saved/Benchmarks/Baselines/<Name>.json exists, the p95 game thread time of each scenario is compared against it.
+ *  Pass -BenchmarkExit on the command line to quit once the report is written.
+ */
+class FDreamEatingBenchmarkReport
+{
+public:
+
+	/** Constructor */
+	explicit FDreamEatingBenchmarkReport(const FString& InName);
+
+	/** Starts a new scenario and returns it. The reference is valid until the next scenario is added */
+	FDreamEatingBenchmarkScenario& AddScenario(const FString& ScenarioName);
+
+	/** Returns the scenario currently being sampled, if any */
+	FDreamEatingBenchmarkScenario* GetCurrentScenario() { return Scenarios.Num() > 0 ? &Scenarios.Last() : nullptr; }
+
+	/** Writes the report, compares it against the baseline and exits if requested. Returns the path written to */
+	FString Finish() const;
+
+	/** Returns the value at the given percentile of the samples, 0 to 1 */
+	static float Percentile(TArray<float> Samples, float Fraction);
+
+protected:
+
+	/** Logs the p95 game thread time change of every scenario present in the baseline */
+	void CompareToBaseline(const FString& BaselinePath) const;
+
+	/** Report name, used for the file name */
+	FString Name;
+
+	/** Scenarios in the order they were run */
+	TArray<FDreamEatingBenchmarkScenario> Scenarios;
+};
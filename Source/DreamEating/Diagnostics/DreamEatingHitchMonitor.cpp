@@ -0,0 +1,387 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingHitchMonitor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "ProfilingDebugging/TraceAuxiliary.h"
+#include "TimerManager.h"
+#include "CoreGlobals.h"
+#include "DreamEating.h"
+
+static bool GHitchMonitorEnabled = false;
+static FAutoConsoleVariableRef CVarHitchMonitorEnabled(
+	TEXT("DreamEating.Hitch.Enabled"),
+	GHitchMonitorEnabled,
+	TEXT("If true, frames over DreamEating.Hitch.ThresholdMs dump the recent gameplay timings and events to Saved/Hitches. Also enabled by -HitchMonitor."),
+	ECVF_Default);
+
+static float GHitchMonitorThresholdMs = 50.0f;
+static FAutoConsoleVariableRef CVarHitchMonitorThresholdMs(
+	TEXT("DreamEating.Hitch.ThresholdMs"),
+	GHitchMonitorThresholdMs,
+	TEXT("Frame time that counts as a hitch, in milliseconds."),
+	ECVF_Default);
+
+static int32 GHitchMonitorFrames = 120;
+static FAutoConsoleVariableRef CVarHitchMonitorFrames(
+	TEXT("DreamEating.Hitch.Frames"),
+	GHitchMonitorFrames,
+	TEXT("Number of frames kept and dumped on a hitch. Read when a world starts."),
+	ECVF_Default);
+
+static float GHitchMonitorCooldown = 5.0f;
+static FAutoConsoleVariableRef CVarHitchMonitorCooldown(
+	TEXT("DreamEating.Hitch.Cooldown"),
+	GHitchMonitorCooldown,
+	TEXT("Minimum time between two hitch dumps, in seconds."),
+	ECVF_Default);
+
+static bool GHitchMonitorCapture = false;
+static FAutoConsoleVariableRef CVarHitchMonitorCapture(
+	TEXT("DreamEating.Hitch.Capture"),
+	GHitchMonitorCapture,
+	TEXT("If true, a hitch also saves the Unreal Insights tail buffer and records a short capture of the frames that follow."),
+	ECVF_Default);
+
+static float GHitchMonitorCaptureSeconds = 5.0f;
+static FAutoConsoleVariableRef CVarHitchMonitorCaptureSeconds(
+	TEXT("DreamEating.Hitch.CaptureSeconds"),
+	GHitchMonitorCaptureSeconds,
+	TEXT("Length of the Unreal Insights capture started by a hitch, in seconds."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdHitchDump(
+	TEXT("DreamEating.Hitch.Dump"),
+	TEXT("Dumps the hitch monitor's recent frames and events now."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UDreamEatingHitchMonitor* HitchMonitor = World ? World->GetSubsystem<UDreamEatingHitchMonitor>() : nullptr)
+		{
+			HitchMonitor->DumpNow();
+		}
+	}));
+
+std::atomic<bool> FDreamEatingGameplayEvents::bRecording(false);
+std::atomic<uint32> FDreamEatingGameplayEvents::Cursor(0);
+std::atomic<uint32> FDreamEatingGameplayEvents::Counts[static_cast<int32>(EDreamEatingGameplayEvent::Num)] = {};
+FDreamEatingGameplayEventRecord FDreamEatingGameplayEvents::Events[FDreamEatingGameplayEvents::Capacity];
+
+void FDreamEatingGameplayEvents::Record(EDreamEatingGameplayEvent Type, int32 Value, const FVector& Location)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	// claim a slot. Old events are overwritten once the buffer wraps around
+	const uint32 Index = Cursor.fetch_add(1, std::memory_order_relaxed) % Capacity;
+
+	FDreamEatingGameplayEventRecord& Event = Events[Index];
+	Event.FrameNumber = GFrameCounter;
+	Event.Type = Type;
+	Event.Value = Value;
+	Event.Location = FVector3f(Location);
+
+	Counts[static_cast<int32>(Type)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void FDreamEatingGameplayEvents::TakeCounts(uint16 (&OutCounts)[static_cast<int32>(EDreamEatingGameplayEvent::Num)])
+{
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Counts); ++Index)
+	{
+		OutCounts[Index] = static_cast<uint16>(FMath::Min(Counts[Index].exchange(0, std::memory_order_relaxed), static_cast<uint32>(MAX_uint16)));
+	}
+}
+
+void FDreamEatingGameplayEvents::CopyEventsSince(uint64 FirstFrame, TArray<FDreamEatingGameplayEventRecord>& OutEvents)
+{
+	const uint32 End = Cursor.load(std::memory_order_relaxed);
+	const uint32 Start = End > Capacity ? End - Capacity : 0;
+
+	for (uint32 Index = Start; Index != End; ++Index)
+	{
+		const FDreamEatingGameplayEventRecord& Event = Events[Index % Capacity];
+
+		if (Event.FrameNumber >= FirstFrame)
+		{
+			OutEvents.Add(Event);
+		}
+	}
+}
+
+const TCHAR* FDreamEatingGameplayEvents::GetEventName(EDreamEatingGameplayEvent Type)
+{
+	switch (Type)
+	{
+		case EDreamEatingGameplayEvent::Kill:	return TEXT("kill");
+		case EDreamEatingGameplayEvent::Spawn:	return TEXT("spawn");
+		case EDreamEatingGameplayEvent::Order:	return TEXT("order");
+		case EDreamEatingGameplayEvent::AoE:	return TEXT("aoe");
+		default:								return TEXT("unknown");
+	}
+}
+
+bool UDreamEatingHitchMonitor::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingHitchMonitor::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PerfMonitor = Collection.InitializeDependency<UDreamEatingPerfMonitor>();
+
+	if (PerfMonitor)
+	{
+		FrameSampledHandle = PerfMonitor->OnFrameSampled.AddUObject(this, &UDreamEatingHitchMonitor::OnFrameSampled);
+	}
+
+	bEnabledFromCommandLine = FParse::Param(FCommandLine::Get(), TEXT("HitchMonitor"));
+
+	// allocate everything up front so sampling and dumping never have to
+	const int32 NumFrames = FMath::Max(GHitchMonitorFrames, 2);
+
+	Frames.SetNum(NumFrames);
+	DumpFrames.Reserve(NumFrames);
+	DumpEvents.Reserve(FDreamEatingGameplayEvents::Capacity);
+}
+
+void UDreamEatingHitchMonitor::Deinitialize()
+{
+	DumpTask.Wait();
+
+	if (bCapturing)
+	{
+		StopCapture();
+	}
+
+	if (PerfMonitor)
+	{
+		PerfMonitor->OnFrameSampled.Remove(FrameSampledHandle);
+		PerfMonitor->RequestSampling(false);
+	}
+
+	FDreamEatingGameplayEvents::SetRecording(false);
+
+	Super::Deinitialize();
+}
+
+void UDreamEatingHitchMonitor::Tick(float DeltaTime)
+{
+	const bool bEnabled = IsEnabled();
+
+	if (PerfMonitor)
+	{
+		PerfMonitor->RequestSampling(bEnabled);
+	}
+
+	FDreamEatingGameplayEvents::SetRecording(bEnabled);
+
+	if (!bEnabled)
+	{
+		FrameCount = 0;
+	}
+}
+
+TStatId UDreamEatingHitchMonitor::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDreamEatingHitchMonitor, STATGROUP_Tickables);
+}
+
+bool UDreamEatingHitchMonitor::IsEnabled() const
+{
+	return GHitchMonitorEnabled || bEnabledFromCommandLine;
+}
+
+void UDreamEatingHitchMonitor::DumpNow()
+{
+	if (FrameCount == 0)
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Hitch monitor: no frames recorded. Enable it with DreamEating.Hitch.Enabled 1"));
+		return;
+	}
+
+	Dump(Frames[(FrameHead - 1 + Frames.Num()) % Frames.Num()].Sample.FrameMs);
+}
+
+void UDreamEatingHitchMonitor::OnFrameSampled(const UDreamEatingPerfMonitor::FFrameSample& Sample)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	// add the frame to the ring buffer
+	FFrame& Frame = Frames[FrameHead];
+	FrameHead = (FrameHead + 1) % Frames.Num();
+	FrameCount = FMath::Min(FrameCount + 1, Frames.Num());
+
+	Frame.FrameNumber = GFrameCounter;
+	Frame.Sample = Sample;
+	FDreamEatingGameplayEvents::TakeCounts(Frame.EventCounts);
+
+	if (Sample.FrameMs < GHitchMonitorThresholdMs)
+	{
+		return;
+	}
+
+	// don't flood the disk when every frame is slow
+	const double Now = FPlatformTime::Seconds();
+
+	if (LastDumpTime > 0.0 && Now - LastDumpTime < GHitchMonitorCooldown)
+	{
+		return;
+	}
+
+	Dump(Sample.FrameMs);
+}
+
+void UDreamEatingHitchMonitor::Dump(float HitchMs)
+{
+	// the copy buffers are still being written out
+	if (!DumpTask.IsCompleted())
+	{
+		return;
+	}
+
+	LastDumpTime = FPlatformTime::Seconds();
+
+	// copy the frames oldest first. The arrays were sized for the whole buffer, so this doesn't allocate
+	DumpFrames.Reset();
+
+	for (int32 Age = FrameCount - 1; Age >= 0; --Age)
+	{
+		DumpFrames.Add(Frames[(FrameHead - 1 - Age + Frames.Num()) % Frames.Num()]);
+	}
+
+	const uint64 HitchFrame = DumpFrames.Last().FrameNumber;
+
+	DumpEvents.Reset();
+	FDreamEatingGameplayEvents::CopyEventsSince(DumpFrames[0].FrameNumber, DumpEvents);
+
+	// mark the hitch on any Insights capture in progress
+	TRACE_BOOKMARK(TEXT("DreamEating hitch: %.1f ms"), HitchMs);
+
+	const FString BasePath = FPaths::ProjectSavedDir() / TEXT("Hitches") / FString::Printf(TEXT("%s-%s-%llu"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString(), HitchFrame);
+
+	UE_LOG(LogDreamEating, Warning, TEXT("Hitch monitor: %.1f ms frame, %d frames and %d events written to %s.csv"),
+		HitchMs, DumpFrames.Num(), DumpEvents.Num(), *FPaths::ConvertRelativePathToFull(BasePath));
+
+	DumpTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Path = BasePath + TEXT(".csv"), HitchMs, HitchFrame]()
+	{
+		WriteDump(Path, HitchMs, HitchFrame);
+	});
+
+	if (GHitchMonitorCapture)
+	{
+		StartCapture(BasePath);
+	}
+}
+
+void UDreamEatingHitchMonitor::WriteDump(const FString& Path, float HitchMs, uint64 HitchFrame) const
+{
+	constexpr int32 NumCategories = static_cast<int32>(EDreamEatingPerfCategory::Num);
+	constexpr int32 NumEventTypes = static_cast<int32>(EDreamEatingGameplayEvent::Num);
+
+	FString Text;
+	Text.Reserve(256 + DumpFrames.Num() * 96 + DumpEvents.Num() * 48);
+
+	Text.Appendf(TEXT("# hitch %.2f ms on frame %llu, threshold %.1f ms\n"), HitchMs, HitchFrame, GHitchMonitorThresholdMs);
+
+	// frames section
+	Text += TEXT("frame,frame_ms,gc_ms");
+
+	for (int32 Category = 0; Category < NumCategories; ++Category)
+	{
+		Text.Appendf(TEXT(",%s_ms"), FDreamEatingPerfScope::GetCategoryName(static_cast<EDreamEatingPerfCategory>(Category)));
+	}
+
+	Text += TEXT(",actors_spawned,actors_destroyed");
+
+	for (int32 Type = 0; Type < NumEventTypes; ++Type)
+	{
+		Text.Appendf(TEXT(",%ss"), FDreamEatingGameplayEvents::GetEventName(static_cast<EDreamEatingGameplayEvent>(Type)));
+	}
+
+	Text += TEXT("\n");
+
+	for (const FFrame& Frame : DumpFrames)
+	{
+		Text.Appendf(TEXT("%llu,%.2f,%.2f"), Frame.FrameNumber, Frame.Sample.FrameMs, Frame.Sample.GCMs);
+
+		for (int32 Category = 0; Category < NumCategories; ++Category)
+		{
+			Text.Appendf(TEXT(",%.3f"), Frame.Sample.CategoryMs[Category]);
+		}
+
+		Text.Appendf(TEXT(",%d,%d"), Frame.Sample.Spawned, Frame.Sample.Destroyed);
+
+		for (int32 Type = 0; Type < NumEventTypes; ++Type)
+		{
+			Text.Appendf(TEXT(",%d"), Frame.EventCounts[Type]);
+		}
+
+		Text += TEXT("\n");
+	}
+
+	// events section
+	Text += TEXT("\nevent_frame,event,value,x,y,z\n");
+
+	for (const FDreamEatingGameplayEventRecord& Event : DumpEvents)
+	{
+		Text.Appendf(TEXT("%llu,%s,%d,%.0f,%.0f,%.0f\n"), Event.FrameNumber, FDreamEatingGameplayEvents::GetEventName(Event.Type), Event.Value, Event.Location.X, Event.Location.Y, Event.Location.Z);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Text, *Path))
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Hitch monitor: could not write %s"), *Path);
+	}
+}
+
+void UDreamEatingHitchMonitor::StartCapture(const FString& BasePath)
+{
+	// a capture that's already running records the hitch, and the bookmark marks it
+	if (bCapturing || FTraceAuxiliary::IsConnected())
+	{
+		return;
+	}
+
+	// the tail buffer holds the last few seconds of the enabled channels, which covers the hitch itself
+	const FString SnapshotPath = BasePath + TEXT("-before.utrace");
+
+	if (FTraceAuxiliary::WriteSnapshot(*SnapshotPath))
+	{
+		UE_LOG(LogDreamEating, Display, TEXT("Hitch monitor: saved the Insights tail buffer to %s"), *FPaths::ConvertRelativePathToFull(SnapshotPath));
+	}
+
+	// then record what follows, in case the stutter keeps going
+	const FString CapturePath = BasePath + TEXT("-after.utrace");
+
+	if (FTraceAuxiliary::Start(FTraceAuxiliary::EConnectionType::File, *CapturePath, TEXT("default,DreamEatingGameplay")))
+	{
+		bCapturing = true;
+
+		GetWorld()->GetTimerManager().SetTimer(CaptureTimer, this, &UDreamEatingHitchMonitor::StopCapture, FMath::Max(GHitchMonitorCaptureSeconds, 0.5f), false);
+
+		UE_LOG(LogDreamEating, Display, TEXT("Hitch monitor: recording %.1f s of Insights trace to %s"), GHitchMonitorCaptureSeconds, *FPaths::ConvertRelativePathToFull(CapturePath));
+	}
+}
+
+void UDreamEatingHitchMonitor::StopCapture()
+{
+	FTraceAuxiliary::Stop();
+	bCapturing = false;
+
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(CaptureTimer);
+	}
+}
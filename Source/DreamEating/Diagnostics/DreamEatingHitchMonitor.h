@@ -0,0 +1,189 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "DreamEatingPerfMonitor.h"
+#include <atomic>
+#include "DreamEatingHitchMonitor.generated.h"
+
+/** Gameplay events kept for hitch reports */
+enum class EDreamEatingGameplayEvent : uint8
+{
+	Kill,
+	Spawn,
+	Order,
+	AoE,
+	Num
+};
+
+/** A single recorded gameplay event */
+struct FDreamEatingGameplayEventRecord
+{
+	/** Engine frame the event happened on */
+	uint64 FrameNumber = 0;
+
+	/** Event type */
+	EDreamEatingGameplayEvent Type = EDreamEatingGameplayEvent::Kill;
+
+	/** Event specific value, e.g. the number of units given an order */
+	int32 Value = 0;
+
+	/** Where the event happened */
+	FVector3f Location = FVector3f::ZeroVector;
+};
+
+/**
+ *  Lock-free log of recent gameplay events.
+ *  Events go into a fixed size ring buffer through an atomic cursor, so recording never allocates or locks.
+ *  Nothing is recorded unless a hitch monitor is running.
+ */
+class FDreamEatingGameplayEvents
+{
+public:
+
+	/** Number of events kept */
+	static constexpr int32 Capacity = 2048;
+
+	/** Records an event */
+	static void Record(EDreamEatingGameplayEvent Type, int32 Value, const FVector& Location);
+
+	/** Enables or disables recording */
+	static void SetRecording(bool bInRecording) { bRecording.store(bInRecording, std::memory_order_relaxed); }
+
+	/** Returns true if events are being recorded */
+	static bool IsRecording() { return bRecording.load(std::memory_order_relaxed); }
+
+	/** Returns and resets the number of events of each type since the last call */
+	static void TakeCounts(uint16 (&OutCounts)[static_cast<int32>(EDreamEatingGameplayEvent::Num)]);
+
+	/** Appends the kept events from the given frame on, oldest first. Doesn't allocate if the array has room for Capacity events */
+	static void CopyEventsSince(uint64 FirstFrame, TArray<FDreamEatingGameplayEventRecord>& OutEvents);
+
+	/** Returns the display name of an event type */
+	static const TCHAR* GetEventName(EDreamEatingGameplayEvent Type);
+
+private:
+
+	/** If true, events are recorded */
+	static std::atomic<bool> bRecording;
+
+	/** Total number of events recorded. The next event goes in slot Cursor % Capacity */
+	static std::atomic<uint32> Cursor;
+
+	/** Events recorded per type since the last TakeCounts */
+	static std::atomic<uint32> Counts[static_cast<int32>(EDreamEatingGameplayEvent::Num)];
+
+	/** Event ring buffer */
+	static FDreamEatingGameplayEventRecord Events[Capacity];
+};
+
+/**
+ *  Catches stutters that can't be reproduced on demand.
+ *  Keeps a ring buffer of the last frames' gameplay timings and event counts, sampled by UDreamEatingPerfMonitor.
+ *  When a frame takes longer than the threshold, the buffer and the gameplay events it covers are copied into preallocated
+ *  arrays and written to Saved/Hitches as a compact CSV from a background task, so nothing is allocated while sampling.
+ *  Optionally saves the Unreal Insights tail buffer and records a short capture after the hitch.
+ *  Enable with DreamEating.Hitch.Enabled or -HitchMonitor.
+ */
+UCLASS()
+class UDreamEatingHitchMonitor : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Timings and event counts of a single frame */
+	struct FFrame
+	{
+		/** Engine frame number */
+		uint64 FrameNumber = 0;
+
+		/** Timings sampled by the performance monitor */
+		UDreamEatingPerfMonitor::FFrameSample Sample;
+
+		/** Gameplay events per type */
+		uint16 EventCounts[static_cast<int32>(EDreamEatingGameplayEvent::Num)] = {};
+	};
+
+	/** Performance monitor providing the frame samples */
+	UPROPERTY()
+	TObjectPtr<UDreamEatingPerfMonitor> PerfMonitor;
+
+	/** If true, the monitor was enabled on the command line */
+	bool bEnabledFromCommandLine = false;
+
+	/** Recent frames, used as a ring buffer */
+	TArray<FFrame> Frames;
+
+	/** Index the next frame is written to */
+	int32 FrameHead = 0;
+
+	/** Number of valid frames */
+	int32 FrameCount = 0;
+
+	/** Frames being written by the current dump */
+	TArray<FFrame> DumpFrames;
+
+	/** Events being written by the current dump */
+	TArray<FDreamEatingGameplayEventRecord> DumpEvents;
+
+	/** Background write of the last dump */
+	UE::Tasks::FTask DumpTask;
+
+	/** Time of the last dump, used for the cooldown */
+	double LastDumpTime = 0.0;
+
+	/** If true, an Insights capture started by a hitch is running */
+	bool bCapturing = false;
+
+	/** Stops the Insights capture started by a hitch */
+	FTimerHandle CaptureTimer;
+
+	/** Frame sample listener */
+	FDelegateHandle FrameSampledHandle;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Allocates the buffers and subscribes to the frame samples */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Waits for the last dump and stops any capture in progress */
+	virtual void Deinitialize() override;
+
+	/** Turns sampling and event recording on or off */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Returns true if the monitor is watching for hitches */
+	bool IsEnabled() const;
+
+	/** Dumps the buffer now, as if the last frame had hitched */
+	void DumpNow();
+
+protected:
+
+	/** Adds a frame to the ring buffer and checks it against the threshold */
+	void OnFrameSampled(const UDreamEatingPerfMonitor::FFrameSample& Sample);
+
+	/** Copies the ring buffer and the events it covers, and writes them out in the background */
+	void Dump(float HitchMs);
+
+	/** Writes the copied frames and events to a file. Runs on a background task */
+	void WriteDump(const FString& Path, float HitchMs, uint64 HitchFrame) const;
+
+	/** Saves the Insights tail buffer and starts a short capture */
+	void StartCapture(const FString& BasePath);
+
+	/** Stops the Insights capture started by a hitch */
+	void StopCapture();
+};
@@ -0,0 +1,307 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingPerfMonitor.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "Engine/Font.h"
+#include "Engine/World.h"
+#include "CanvasItem.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectGlobals.h"
+#include "DreamEating.h"
+
+static bool GDreamEatingPerfOverlay = false;
+static FAutoConsoleVariableRef CVarDreamEatingPerfOverlay(
+	TEXT("DreamEating.PerfOverlay"),
+	GDreamEatingPerfOverlay,
+	TEXT("If true, the Strategy and Twin Stick HUDs draw the gameplay performance overlay."),
+	ECVF_Default);
+
+/** Frame time at the top of the sparkline, in milliseconds */
+static constexpr float PerfOverlaySparklineMaxMs = 50.0f;
+
+std::atomic<bool> FDreamEatingPerfScope::bSampling(false);
+std::atomic<uint64> FDreamEatingPerfScope::Cycles[static_cast<int32>(EDreamEatingPerfCategory::Num)] = {};
+
+/** Category of the innermost timed scope on this thread */
+static thread_local int8 GPerfScopeCategory = INDEX_NONE;
+
+/** Cycle count the innermost timed scope on this thread last started or resumed at */
+static thread_local uint64 GPerfScopeSegmentStart = 0;
+
+FDreamEatingPerfScope::FDreamEatingPerfScope(EDreamEatingPerfCategory InCategory)
+{
+	if (!IsSampling())
+	{
+		return;
+	}
+
+	const uint64 Now = FPlatformTime::Cycles64();
+
+	// pause the enclosing scope so its category doesn't count our time
+	if (GPerfScopeCategory != INDEX_NONE && GPerfScopeCategory < static_cast<int8>(EDreamEatingPerfCategory::Num))
+	{
+		Cycles[GPerfScopeCategory].fetch_add(Now - GPerfScopeSegmentStart, std::memory_order_relaxed);
+	}
+
+	PreviousCategory = GPerfScopeCategory;
+	GPerfScopeCategory = static_cast<int8>(InCategory);
+	GPerfScopeSegmentStart = Now;
+	bActive = true;
+}
+
+FDreamEatingPerfScope::~FDreamEatingPerfScope()
+{
+	if (!bActive)
+	{
+		return;
+	}
+
+	const uint64 Now = FPlatformTime::Cycles64();
+
+	if (GPerfScopeCategory < static_cast<int8>(EDreamEatingPerfCategory::Num))
+	{
+		Cycles[GPerfScopeCategory].fetch_add(Now - GPerfScopeSegmentStart, std::memory_order_relaxed);
+	}
+
+	// resume the enclosing scope
+	GPerfScopeCategory = PreviousCategory;
+	GPerfScopeSegmentStart = Now;
+}
+
+void FDreamEatingPerfScope::Harvest(uint64 (&OutCycles)[static_cast<int32>(EDreamEatingPerfCategory::Num)])
+{
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Cycles); ++Index)
+	{
+		OutCycles[Index] = Cycles[Index].exchange(0, std::memory_order_relaxed);
+	}
+}
+
+const TCHAR* FDreamEatingPerfScope::GetCategoryName(EDreamEatingPerfCategory Category)
+{
+	switch (Category)
+	{
+		case EDreamEatingPerfCategory::AI:			return TEXT("AI");
+		case EDreamEatingPerfCategory::Movement:	return TEXT("Movement");
+		case EDreamEatingPerfCategory::Selection:	return TEXT("Selection");
+		case EDreamEatingPerfCategory::Spawning:	return TEXT("Spawning");
+		case EDreamEatingPerfCategory::Projectiles:	return TEXT("Projectiles");
+		case EDreamEatingPerfCategory::UI:			return TEXT("UI");
+		default:									return TEXT("Unknown");
+	}
+}
+
+bool UDreamEatingPerfMonitor::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingPerfMonitor::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UDreamEatingPerfMonitor::OnActorSpawned));
+	ActorDestroyedHandle = GetWorld()->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &UDreamEatingPerfMonitor::OnActorDestroyed));
+
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UDreamEatingPerfMonitor::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UDreamEatingPerfMonitor::OnPostGarbageCollect);
+}
+
+void UDreamEatingPerfMonitor::Deinitialize()
+{
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	GetWorld()->RemoveOnActorDestroyededHandler(ActorDestroyedHandle);
+
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	FDreamEatingPerfScope::SetSampling(false);
+
+	Super::Deinitialize();
+}
+
+void UDreamEatingPerfMonitor::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FDreamEatingPerfScope::SetSampling(IsOverlayEnabled() || bSamplingRequested);
+
+	if (!FDreamEatingPerfScope::IsSampling())
+	{
+		// start over from a clean history the next time sampling starts
+		HistoryCount = 0;
+		LastSampleTime = 0.0;
+		return;
+	}
+
+	uint64 CategoryCycles[static_cast<int32>(EDreamEatingPerfCategory::Num)];
+	FDreamEatingPerfScope::Harvest(CategoryCycles);
+
+	FFrameSample& Sample = History[HistoryHead];
+	HistoryHead = (HistoryHead + 1) % HistorySize;
+	HistoryCount = FMath::Min(HistoryCount + 1, HistorySize);
+
+	Sample.FrameMs = LastSampleTime > 0.0 ? static_cast<float>((Now - LastSampleTime) * 1000.0) : 0.0f;
+	Sample.GCMs = static_cast<float>(FPlatformTime::ToMilliseconds64(GCCycles));
+	Sample.Spawned = SpawnedCount;
+	Sample.Destroyed = DestroyedCount;
+
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(CategoryCycles); ++Index)
+	{
+		Sample.CategoryMs[Index] = static_cast<float>(FPlatformTime::ToMilliseconds64(CategoryCycles[Index]));
+	}
+
+	LastSampleTime = Now;
+	GCCycles = 0;
+	SpawnedCount = 0;
+	DestroyedCount = 0;
+
+	OnFrameSampled.Broadcast(Sample);
+}
+
+TStatId UDreamEatingPerfMonitor::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDreamEatingPerfMonitor, STATGROUP_Tickables);
+}
+
+bool UDreamEatingPerfMonitor::IsOverlayEnabled()
+{
+	return GDreamEatingPerfOverlay;
+}
+
+void UDreamEatingPerfMonitor::DrawOverlay(UCanvas* Canvas, TConstArrayView<FDreamEatingPerfEntityCount> EntityCounts)
+{
+	if (!Canvas || HistoryCount == 0)
+	{
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// keep the overlay out of the HUD's category, it reports its own cost
+	FDreamEatingPerfScope UntrackedScope(EDreamEatingPerfCategory::Num);
+
+	// average the history
+	constexpr int32 NumCategories = static_cast<int32>(EDreamEatingPerfCategory::Num);
+
+	FFrameSample Average;
+	float MaxFrameMs = 0.0f;
+	float MaxGCMs = 0.0f;
+	double TotalSeconds = 0.0;
+
+	for (int32 Index = 0; Index < HistoryCount; ++Index)
+	{
+		const FFrameSample& Sample = History[Index];
+
+		Average.FrameMs += Sample.FrameMs;
+		Average.GCMs += Sample.GCMs;
+		Average.Spawned += Sample.Spawned;
+		Average.Destroyed += Sample.Destroyed;
+
+		for (int32 Category = 0; Category < NumCategories; ++Category)
+		{
+			Average.CategoryMs[Category] += Sample.CategoryMs[Category];
+		}
+
+		MaxFrameMs = FMath::Max(MaxFrameMs, Sample.FrameMs);
+		MaxGCMs = FMath::Max(MaxGCMs, Sample.GCMs);
+		TotalSeconds += Sample.FrameMs * 0.001;
+	}
+
+	const float InvCount = 1.0f / HistoryCount;
+	const float InvSeconds = TotalSeconds > 0.0 ? static_cast<float>(1.0 / TotalSeconds) : 0.0f;
+
+	// lay out the panel
+	const UFont* Font = GEngine->GetSmallFont();
+	const float LineHeight = Font->GetMaxCharHeight() + 2.0f;
+	const float SparklineHeight = 40.0f;
+	const float PanelWidth = 260.0f;
+	const int32 NumLines = 4 + NumCategories + EntityCounts.Num();
+
+	const float X = 16.0f;
+	float Y = 80.0f;
+
+	FCanvasTileItem Background(FVector2D(X - 6.0f, Y - 6.0f), FVector2D(PanelWidth + 12.0f, NumLines * LineHeight + SparklineHeight + 18.0f), FLinearColor(0.0f, 0.0f, 0.0f, 0.6f));
+	Background.BlendMode = SE_BLEND_Translucent;
+	Canvas->DrawItem(Background);
+
+	auto DrawLine = [&](const FString& Text, const FColor& Color)
+	{
+		Canvas->SetDrawColor(Color);
+		Canvas->DrawText(Font, Text, X, Y);
+		Y += LineHeight;
+	};
+
+	DrawLine(FString::Printf(TEXT("Frame: %.2f ms avg, %.2f ms max"), Average.FrameMs * InvCount, MaxFrameMs), FColor::White);
+
+	for (int32 Category = 0; Category < NumCategories; ++Category)
+	{
+		DrawLine(FString::Printf(TEXT("  %s: %.3f ms"), FDreamEatingPerfScope::GetCategoryName(static_cast<EDreamEatingPerfCategory>(Category)), Average.CategoryMs[Category] * InvCount), FColor(200, 220, 255));
+	}
+
+	DrawLine(FString::Printf(TEXT("GC: %.3f ms avg, %.2f ms max"), Average.GCMs * InvCount, MaxGCMs), FColor(255, 220, 160));
+	DrawLine(FString::Printf(TEXT("Actors: %.1f spawned/s, %.1f destroyed/s"), Average.Spawned * InvSeconds, Average.Destroyed * InvSeconds), FColor(200, 255, 200));
+
+	for (const FDreamEatingPerfEntityCount& EntityCount : EntityCounts)
+	{
+		DrawLine(FString::Printf(TEXT("  %s: %d"), EntityCount.Label, EntityCount.Count), FColor(200, 255, 200));
+	}
+
+	// draw the frame time sparkline as a single batch of bars, oldest on the left
+	const float BarWidth = PanelWidth / HistorySize;
+	const float Baseline = Y + SparklineHeight;
+
+	SparklineTriangles.Reset(HistoryCount * 2);
+
+	for (int32 Age = HistoryCount - 1; Age >= 0; --Age)
+	{
+		const FFrameSample& Sample = History[(HistoryHead - 1 - Age + HistorySize) % HistorySize];
+
+		const float Left = X + (HistorySize - 1 - Age) * BarWidth;
+		const float Top = Baseline - FMath::Min(Sample.FrameMs / PerfOverlaySparklineMaxMs, 1.0f) * SparklineHeight;
+		const FLinearColor Color = Sample.FrameMs <= 16.7f ? FLinearColor::Green : (Sample.FrameMs <= 33.4f ? FLinearColor::Yellow : FLinearColor::Red);
+
+		FCanvasUVTri& Upper = SparklineTriangles.AddDefaulted_GetRef();
+		Upper.V0_Pos = FVector2D(Left, Top);
+		Upper.V1_Pos = FVector2D(Left + BarWidth, Top);
+		Upper.V2_Pos = FVector2D(Left, Baseline);
+		Upper.V0_Color = Upper.V1_Color = Upper.V2_Color = Color;
+
+		FCanvasUVTri& Lower = SparklineTriangles.AddDefaulted_GetRef();
+		Lower.V0_Pos = FVector2D(Left + BarWidth, Top);
+		Lower.V1_Pos = FVector2D(Left + BarWidth, Baseline);
+		Lower.V2_Pos = FVector2D(Left, Baseline);
+		Lower.V0_Color = Lower.V1_Color = Lower.V2_Color = Color;
+	}
+
+	FCanvasTriangleItem Sparkline(SparklineTriangles, nullptr);
+	Canvas->DrawItem(Sparkline);
+
+	// mark the 60 fps budget
+	const float BudgetY = Baseline - (16.7f / PerfOverlaySparklineMaxMs) * SparklineHeight;
+	FCanvasLineItem BudgetLine(FVector2D(X, BudgetY), FVector2D(X + PanelWidth, BudgetY));
+	BudgetLine.SetColor(FLinearColor(1.0f, 1.0f, 1.0f, 0.5f));
+	Canvas->DrawItem(BudgetLine);
+
+	Y = Baseline + 4.0f;
+
+	// report the previous draw's cost, since this one isn't done yet
+	DrawLine(FString::Printf(TEXT("Overlay: %.3f ms"), OverlayMs), FColor(180, 180, 180));
+
+	OverlayMs = static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+}
+
+void UDreamEatingPerfMonitor::OnPreGarbageCollect()
+{
+	GCStartCycles = FPlatformTime::Cycles64();
+}
+
+void UDreamEatingPerfMonitor::OnPostGarbageCollect()
+{
+	if (GCStartCycles != 0)
+	{
+		GCCycles += FPlatformTime::Cycles64() - GCStartCycles;
+		GCStartCycles = 0;
+	}
+}
@@ -0,0 +1,211 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CanvasTypes.h"
+#include <atomic>
+#include "DreamEatingPerfMonitor.generated.h"
+
+class UCanvas;
+
+/** Gameplay cost categories tracked by the performance monitor */
+enum class EDreamEatingPerfCategory : uint8
+{
+	AI,
+	Movement,
+	Selection,
+	Spawning,
+	Projectiles,
+	UI,
+	Num
+};
+
+/**
+ *  Adds the time spent in a scope to a gameplay cost category.
+ *  Time is exclusive: entering a nested scope pauses the enclosing one, so no cycles are counted twice.
+ *  Totals are relaxed atomics, so scopes are lock-free and can run on any thread.
+ *  Scopes don't read the clock unless a performance monitor is sampling.
+ */
+class FDreamEatingPerfScope
+{
+public:
+
+	/** Starts timing the scope. A scope in the Num category pauses the enclosing scope without being counted */
+	explicit FDreamEatingPerfScope(EDreamEatingPerfCategory InCategory);
+
+	/** Adds the scope's time to its category */
+	~FDreamEatingPerfScope();
+
+	/** Enables or disables sampling for every scope */
+	static void SetSampling(bool bInSampling) { bSampling.store(bInSampling, std::memory_order_relaxed); }
+
+	/** Returns true if scopes are recording their time */
+	static bool IsSampling() { return bSampling.load(std::memory_order_relaxed); }
+
+	/** Returns and resets the cycles recorded for every category since the last call */
+	static void Harvest(uint64 (&OutCycles)[static_cast<int32>(EDreamEatingPerfCategory::Num)]);
+
+	/** Returns the display name of a category */
+	static const TCHAR* GetCategoryName(EDreamEatingPerfCategory Category);
+
+private:
+
+	/** If true, scopes record their time */
+	static std::atomic<bool> bSampling;
+
+	/** Cycles recorded per category since the last harvest */
+	static std::atomic<uint64> Cycles[static_cast<int32>(EDreamEatingPerfCategory::Num)];
+
+	/** Category of the enclosing scope on this thread, resumed when this scope ends */
+	int8 PreviousCategory = INDEX_NONE;
+
+	/** If true, this scope started while sampling and is being timed */
+	bool bActive = false;
+};
+
+/** Adds the time spent in the enclosing scope to a gameplay cost category, e.g. DREAMEATING_PERF_SCOPE(AI) */
+#define DREAMEATING_PERF_SCOPE(Category) \
+	FDreamEatingPerfScope PREPROCESSOR_JOIN(DreamEatingPerfScope_, __LINE__)(EDreamEatingPerfCategory::Category)
+
+/** Entity count shown on the performance overlay */
+struct FDreamEatingPerfEntityCount
+{
+	/** Label to display */
+	const TCHAR* Label = nullptr;
+
+	/** Current count */
+	int32 Count = 0;
+};
+
+/**
+ *  Samples gameplay costs every frame and draws them as an in-game overlay, for testers who can't read Insights.
+ *  Shows the rolling per-category cost recorded by DREAMEATING_PERF_SCOPE, entity counts provided by the HUD,
+ *  actor spawn and destroy rates, garbage collection time, a frame time sparkline and the overlay's own cost.
+ *  Toggle with DreamEating.PerfOverlay. Nothing is sampled while the overlay is hidden, unless another monitor requests it.
+ */
+UCLASS()
+class UDreamEatingPerfMonitor : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Number of frames kept for the rolling averages and the sparkline */
+	static constexpr int32 HistorySize = 120;
+
+	/** Costs recorded for a single frame */
+	struct FFrameSample
+	{
+		/** Wall clock frame time, in milliseconds */
+		float FrameMs = 0.0f;
+
+		/** Garbage collection time, in milliseconds */
+		float GCMs = 0.0f;
+
+		/** Exclusive time per category, in milliseconds */
+		float CategoryMs[static_cast<int32>(EDreamEatingPerfCategory::Num)] = {};
+
+		/** Actors spawned this frame */
+		int32 Spawned = 0;
+
+		/** Actors destroyed this frame */
+		int32 Destroyed = 0;
+	};
+
+	/** Called on the game thread with every new frame sample */
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnFrameSampled, const FFrameSample&);
+
+	/** Frame sample listeners */
+	FOnFrameSampled OnFrameSampled;
+
+protected:
+
+	/** Recent frame samples, used as a ring buffer */
+	FFrameSample History[HistorySize];
+
+	/** Index the next sample is written to */
+	int32 HistoryHead = 0;
+
+	/** Number of valid samples */
+	int32 HistoryCount = 0;
+
+	/** Time of the last sample */
+	double LastSampleTime = 0.0;
+
+	/** Actors spawned since the last sample */
+	int32 SpawnedCount = 0;
+
+	/** Actors destroyed since the last sample */
+	int32 DestroyedCount = 0;
+
+	/** Cycle count at the start of the garbage collection in progress */
+	uint64 GCStartCycles = 0;
+
+	/** Garbage collection cycles since the last sample */
+	uint64 GCCycles = 0;
+
+	/** If true, frames are sampled even while the overlay is hidden */
+	bool bSamplingRequested = false;
+
+	/** Cost of the last overlay draw, in milliseconds */
+	float OverlayMs = 0.0f;
+
+	/** Scratch triangles for the sparkline */
+	TArray<FCanvasUVTri> SparklineTriangles;
+
+	/** World actor spawn listener */
+	FDelegateHandle ActorSpawnedHandle;
+
+	/** World actor destroy listener */
+	FDelegateHandle ActorDestroyedHandle;
+
+	/** Garbage collection start listener */
+	FDelegateHandle PreGCHandle;
+
+	/** Garbage collection end listener */
+	FDelegateHandle PostGCHandle;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Subscribes to actor and garbage collection events */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+	/** Records the costs of the last frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Returns true if the overlay should be drawn */
+	static bool IsOverlayEnabled();
+
+	/** Keeps frames sampled while the overlay is hidden, for monitors listening to OnFrameSampled */
+	void RequestSampling(bool bRequest) { bSamplingRequested = bRequest; }
+
+	/** Draws the overlay, along with the given entity counts */
+	void DrawOverlay(UCanvas* Canvas, TConstArrayView<FDreamEatingPerfEntityCount> EntityCounts);
+
+protected:
+
+	/** Counts a spawned actor */
+	void OnActorSpawned(AActor* Actor) { ++SpawnedCount; }
+
+	/** Counts a destroyed actor */
+	void OnActorDestroyed(AActor* Actor) { ++DestroyedCount; }
+
+	/** Starts timing a garbage collection */
+	void OnPreGarbageCollect();
+
+	/** Stops timing a garbage collection */
+	void OnPostGarbageCollect();
+};
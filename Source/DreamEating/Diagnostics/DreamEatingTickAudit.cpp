@@ -0,0 +1,420 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingTickAudit.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "DreamEatingCharacter.h"
+#include "StrategyPawn.h"
+#include "StrategyUnit.h"
+#include "TwinStickNPC.h"
+#include "TwinStickNPCDestruction.h"
+#include "TwinStickSpawner.h"
+#include "TwinStickProjectile.h"
+#include "TwinStickPickup.h"
+#include "TwinStickAoEAttack.h"
+#include "DreamEating.h"
+
+/**
+ *  Stands in for a single tick function while an audit is running, and times it.
+ *  Registered with the same tick group, interval and prerequisites, while the original tick function is disabled.
+ */
+struct FDreamEatingAuditTickFunction : public FTickFunction
+{
+	/** Tick function being timed */
+	FTickFunction* Target = nullptr;
+
+	/** Object owning the target tick function. The target is gone once this is */
+	TWeakObjectPtr<UObject> TargetOwner;
+
+	/** Class the target's cost is reported under */
+	TWeakObjectPtr<UClass> TargetClass;
+
+	/** Cycles spent running the target */
+	uint64 Cycles = 0;
+
+	/** Runs and times the target */
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override
+	{
+		if (!TargetOwner.IsValid())
+		{
+			return;
+		}
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Target->ExecuteTick(DeltaTime, TickType, CurrentThread, MyCompletionGraphEvent);
+		Cycles += FPlatformTime::Cycles64() - StartCycles;
+	}
+
+	/** Names the tick function in tick dumps */
+	virtual FString DiagnosticMessage() override
+	{
+		return FString::Printf(TEXT("DreamEatingTickAudit[%s]"), *GetNameSafe(TargetClass.Get()));
+	}
+};
+
+/** State of the audit in progress */
+struct FDreamEatingTickAuditSession
+{
+	/** World being audited */
+	TWeakObjectPtr<UWorld> World;
+
+	/** Time the current tick phase started */
+	double PhaseStart = 0.0;
+
+	/** Tick phase time accumulated over the audit */
+	double PhaseTime = 0.0;
+
+	/** Number of tick phases measured */
+	int32 Frames = 0;
+
+	/** Timed stand-ins for every tick function enabled when the audit started. Heap allocated so registered tick functions never move */
+	TArray<TUniquePtr<FDreamEatingAuditTickFunction>> TimedTicks;
+
+	/** Tick phase and world cleanup listeners */
+	FDelegateHandle PreTickHandle;
+	FDelegateHandle PostTickHandle;
+	FDelegateHandle CleanupHandle;
+
+	/** If true, an audit is running */
+	bool bRunning = false;
+};
+
+static FDreamEatingTickAuditSession GTickAudit;
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTickAudit(
+	TEXT("DreamEating.Ticks.Audit"),
+	TEXT("Logs every actor and component class with enabled ticks, then measures the average tick phase time and each class's tick cost. Usage: DreamEating.Ticks.Audit [Seconds=2]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		FDreamEatingTickAudit::LogTickingClasses(World);
+
+		const float Seconds = FMath::Max(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 2.0f, 0.5f);
+
+		FDreamEatingTickAudit::StartTimedAudit(World, Seconds);
+	}));
+
+static FAutoConsoleCommandWithWorld CmdTickVerify(
+	TEXT("DreamEating.Ticks.Verify"),
+	TEXT("Logs an error for every gameplay class that should be event driven but ticks in the current world. The class defaults are also covered by the DreamEating.Ticks.NonTickingClasses automation test."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const int32 Errors = FDreamEatingTickAudit::VerifyNonTickingClasses(World);
+
+		if (Errors == 0)
+		{
+			UE_LOG(LogDreamEating, Display, TEXT("Tick verify: no unexpected ticks"));
+		}
+	}));
+
+void FDreamEatingTickAudit::LogTickingClasses(UWorld* World)
+{
+	/** Enabled tick functions of a single class */
+	struct FClassTicks
+	{
+		int32 Count = 0;
+		ETickingGroup TickGroup = TG_PrePhysics;
+		float TickInterval = 0.0f;
+		bool bComponent = false;
+	};
+
+	TMap<UClass*, FClassTicks> Classes;
+	int32 NumActorTicks = 0;
+	int32 NumComponentTicks = 0;
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+
+		if (Actor->PrimaryActorTick.IsTickFunctionRegistered() && Actor->PrimaryActorTick.IsTickFunctionEnabled())
+		{
+			FClassTicks& Ticks = Classes.FindOrAdd(Actor->GetClass());
+			++Ticks.Count;
+			Ticks.TickGroup = Actor->PrimaryActorTick.TickGroup;
+			Ticks.TickInterval = Actor->PrimaryActorTick.TickInterval;
+
+			++NumActorTicks;
+		}
+
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (Component && Component->PrimaryComponentTick.IsTickFunctionRegistered() && Component->PrimaryComponentTick.IsTickFunctionEnabled())
+			{
+				FClassTicks& Ticks = Classes.FindOrAdd(Component->GetClass());
+				++Ticks.Count;
+				Ticks.TickGroup = Component->PrimaryComponentTick.TickGroup;
+				Ticks.TickInterval = Component->PrimaryComponentTick.TickInterval;
+				Ticks.bComponent = true;
+
+				++NumComponentTicks;
+			}
+		}
+	}
+
+	Classes.ValueSort([](const FClassTicks& A, const FClassTicks& B) { return A.Count > B.Count; });
+
+	UE_LOG(LogDreamEating, Display, TEXT("Tick audit: %d actor ticks and %d component ticks enabled across %d classes"), NumActorTicks, NumComponentTicks, Classes.Num());
+
+	for (const TPair<UClass*, FClassTicks>& Pair : Classes)
+	{
+		UE_LOG(LogDreamEating, Display, TEXT("    %5d  %-9s  %-40s  %s, interval %.3f s"),
+			Pair.Value.Count,
+			Pair.Value.bComponent ? TEXT("component") : TEXT("actor"),
+			*Pair.Key->GetName(),
+			*UEnum::GetValueAsString(Pair.Value.TickGroup),
+			Pair.Value.TickInterval);
+	}
+}
+
+int32 FDreamEatingTickAudit::VerifyNonTickingClasses(UWorld* World)
+{
+	int32 Errors = 0;
+	const TArray<UClass*> NonTickingClasses = GetNonTickingClasses();
+
+	// the native defaults must not be able to tick
+	for (UClass* Class : NonTickingClasses)
+	{
+		if (Class->GetDefaultObject<AActor>()->PrimaryActorTick.bCanEverTick)
+		{
+			UE_LOG(LogDreamEating, Error, TEXT("Tick verify: %s can tick, but is expected to be event driven"), *Class->GetName());
+			++Errors;
+		}
+	}
+
+	if (!World)
+	{
+		return Errors;
+	}
+
+	// Blueprints that implement Event Tick are allowed to, but nothing else should have turned ticking on at runtime
+	static const FName ReceiveTickName(TEXT("ReceiveTick"));
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+
+		if (!Actor->PrimaryActorTick.IsTickFunctionEnabled())
+		{
+			continue;
+		}
+
+		UClass* ActorClass = Actor->GetClass();
+
+		if (ActorClass->IsFunctionImplementedInScript(ReceiveTickName))
+		{
+			continue;
+		}
+
+		for (UClass* Class : NonTickingClasses)
+		{
+			if (ActorClass->IsChildOf(Class))
+			{
+				UE_LOG(LogDreamEating, Error, TEXT("Tick verify: %s (%s) is ticking, but is expected to be event driven"), *Actor->GetName(), *ActorClass->GetName());
+				++Errors;
+				break;
+			}
+		}
+	}
+
+	return Errors;
+}
+
+void FDreamEatingTickAudit::StartTimedAudit(UWorld* World, float Seconds)
+{
+	if (!World)
+	{
+		return;
+	}
+
+	if (GTickAudit.bRunning)
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Tick audit: an audit is already running"));
+		return;
+	}
+
+	GTickAudit.World = World;
+	GTickAudit.PhaseStart = 0.0;
+	GTickAudit.PhaseTime = 0.0;
+	GTickAudit.Frames = 0;
+	GTickAudit.bRunning = true;
+
+	// stand in for every enabled tick function, so we can time each one without the stats system
+	auto TimeTickFunction = [](FTickFunction& TickFunction, UObject* Owner, ULevel* Level)
+	{
+		if (!Level || !TickFunction.IsTickFunctionRegistered() || !TickFunction.IsTickFunctionEnabled())
+		{
+			return;
+		}
+
+		FDreamEatingAuditTickFunction& Timed = *GTickAudit.TimedTicks.Emplace_GetRef(MakeUnique<FDreamEatingAuditTickFunction>());
+		Timed.Target = &TickFunction;
+		Timed.TargetOwner = Owner;
+		Timed.TargetClass = Owner->GetClass();
+
+		Timed.bCanEverTick = true;
+		Timed.bStartWithTickEnabled = true;
+		Timed.bTickEvenWhenPaused = TickFunction.bTickEvenWhenPaused;
+		Timed.bHighPriority = TickFunction.bHighPriority;
+		Timed.TickGroup = TickFunction.TickGroup;
+		Timed.EndTickGroup = TickFunction.EndTickGroup;
+		Timed.TickInterval = TickFunction.TickInterval;
+
+		for (const FTickPrerequisite& Prerequisite : TickFunction.GetPrerequisites())
+		{
+			if (FTickFunction* PrerequisiteFunction = Prerequisite.Get())
+			{
+				Timed.AddPrerequisite(Prerequisite.PrerequisiteObject.Get(), *PrerequisiteFunction);
+			}
+		}
+
+		Timed.RegisterTickFunction(Level);
+		TickFunction.SetTickFunctionEnable(false);
+	};
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+
+		TimeTickFunction(Actor->PrimaryActorTick, Actor, Actor->GetLevel());
+
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (Component)
+			{
+				TimeTickFunction(Component->PrimaryComponentTick, Component, Actor->GetLevel());
+			}
+		}
+	}
+
+	// time everything between the start of the first tick group and the end of the last one
+	GTickAudit.PreTickHandle = FWorldDelegates::OnWorldPreActorTick.AddLambda([](UWorld* TickWorld, ELevelTick, float)
+	{
+		if (TickWorld == GTickAudit.World.Get())
+		{
+			GTickAudit.PhaseStart = FPlatformTime::Seconds();
+		}
+	});
+
+	GTickAudit.PostTickHandle = FWorldDelegates::OnWorldPostActorTick.AddLambda([](UWorld* TickWorld, ELevelTick, float)
+	{
+		if (TickWorld == GTickAudit.World.Get() && GTickAudit.PhaseStart > 0.0)
+		{
+			GTickAudit.PhaseTime += FPlatformTime::Seconds() - GTickAudit.PhaseStart;
+			GTickAudit.PhaseStart = 0.0;
+			++GTickAudit.Frames;
+		}
+	});
+
+	// the stand-ins must be gone before the world's levels are
+	GTickAudit.CleanupHandle = FWorldDelegates::OnWorldCleanup.AddLambda([](UWorld* CleanupWorld, bool, bool)
+	{
+		if (CleanupWorld == GTickAudit.World.Get())
+		{
+			FDreamEatingTickAudit::FinishTimedAudit();
+		}
+	});
+
+	FTimerHandle TimerHandle;
+	World->GetTimerManager().SetTimer(TimerHandle, FTimerDelegate::CreateStatic(&FDreamEatingTickAudit::FinishTimedAudit), Seconds, false);
+
+	UE_LOG(LogDreamEating, Display, TEXT("Tick audit: timing %d tick functions for %.1f seconds"), GTickAudit.TimedTicks.Num(), Seconds);
+}
+
+void FDreamEatingTickAudit::FinishTimedAudit()
+{
+	if (!GTickAudit.bRunning)
+	{
+		return;
+	}
+
+	GTickAudit.bRunning = false;
+
+	FWorldDelegates::OnWorldPreActorTick.Remove(GTickAudit.PreTickHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(GTickAudit.PostTickHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(GTickAudit.CleanupHandle);
+
+	/** Tick cost of a single class */
+	struct FClassCost
+	{
+		uint64 Cycles = 0;
+		int32 TickFunctions = 0;
+	};
+
+	TMap<UClass*, FClassCost> Classes;
+
+	// hand ticking back to the original tick functions that still exist
+	for (const TUniquePtr<FDreamEatingAuditTickFunction>& Timed : GTickAudit.TimedTicks)
+	{
+		if (Timed->TargetOwner.IsValid())
+		{
+			Timed->Target->SetTickFunctionEnable(true);
+		}
+
+		Timed->UnRegisterTickFunction();
+
+		if (UClass* Class = Timed->TargetClass.Get())
+		{
+			FClassCost& Cost = Classes.FindOrAdd(Class);
+			Cost.Cycles += Timed->Cycles;
+			++Cost.TickFunctions;
+		}
+	}
+
+	GTickAudit.TimedTicks.Empty();
+
+	const int32 Frames = FMath::Max(GTickAudit.Frames, 1);
+
+	Classes.ValueSort([](const FClassCost& A, const FClassCost& B) { return A.Cycles > B.Cycles; });
+
+	UE_LOG(LogDreamEating, Display, TEXT("Tick audit: %.3f ms average tick phase over %d frames. Cost per class:"),
+		GTickAudit.PhaseTime * 1000.0 / Frames, GTickAudit.Frames);
+
+	for (const TPair<UClass*, FClassCost>& Pair : Classes)
+	{
+		const double FrameMs = FPlatformTime::ToMilliseconds64(Pair.Value.Cycles) / Frames;
+
+		UE_LOG(LogDreamEating, Display, TEXT("    %8.3f ms/frame  %8.2f us/tick function  %5d  %s"),
+			FrameMs, FrameMs * 1000.0 / Pair.Value.TickFunctions, Pair.Value.TickFunctions, *Pair.Key->GetName());
+	}
+}
+
+TArray<UClass*> FDreamEatingTickAudit::GetNonTickingClasses()
+{
+	return {
+		ADreamEatingCharacter::StaticClass(),
+		AStrategyPawn::StaticClass(),
+		AStrategyUnit::StaticClass(),
+		ATwinStickNPC::StaticClass(),
+		ATwinStickNPCDestruction::StaticClass(),
+		ATwinStickSpawner::StaticClass(),
+		ATwinStickProjectile::StaticClass(),
+		ATwinStickPickup::StaticClass(),
+		ATwinStickAoEAttack::StaticClass()
+	};
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDreamEatingNonTickingClassesTest, "DreamEating.Ticks.NonTickingClasses",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDreamEatingNonTickingClassesTest::RunTest(const FString& Parameters)
+{
+	// event driven gameplay classes must not start ticking again
+	for (UClass* Class : FDreamEatingTickAudit::GetNonTickingClasses())
+	{
+		TestFalse(FString::Printf(TEXT("%s can tick"), *Class->GetName()), Class->GetDefaultObject<AActor>()->PrimaryActorTick.bCanEverTick);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
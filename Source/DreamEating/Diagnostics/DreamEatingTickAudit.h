@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/**
+ *  Runtime tick registration audit.
+ *  Reports which actor and component classes have enabled tick functions in a world, how long the tick phase takes and what each class costs.
+ *  Class costs are measured by standing in for every enabled tick function during the audit, so tick order within a group may shift while it runs.
+ *  Also verifies that gameplay classes converted to event and timer driven updates haven't started ticking again.
+ */
+class FDreamEatingTickAudit
+{
+public:
+
+	/** Logs every class with enabled actor or component ticks in the world, most common first */
+	static void LogTickingClasses(UWorld* World);
+
+	/** Times every enabled tick function in the world for the given time, then logs the tick phase time and each class's tick cost */
+	static void StartTimedAudit(UWorld* World, float Seconds);
+
+	/** Ends the running timed audit early, or when its time is up, and logs its results */
+	static void FinishTimedAudit();
+
+	/** Checks that classes which shouldn't tick don't. Logs an error for each offender and returns the number of errors */
+	static int32 VerifyNonTickingClasses(UWorld* World);
+
+	/** Returns the native classes that are expected to never tick */
+	static TArray<UClass*> GetNonTickingClasses();
+};
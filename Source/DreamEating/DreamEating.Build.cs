@@ -20,13 +20,18 @@ public class DreamEating : ModuleRules
 			"GameplayStateTreeModule",
 			"Niagara",
 			"UMG",
-			"Slate"
+			"Slate",
+			"DreamEatingCore"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[] { });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json" });
 
 		PublicIncludePaths.AddRange(new string[] {
 			"DreamEating",
+			"DreamEating/Diagnostics",
+			"DreamEating/Effects",
+			"DreamEating/Navigation",
+			"DreamEating/Simulation",
 			"DreamEating/Variant_Strategy",
 			"DreamEating/Variant_Strategy/UI",
 			"DreamEating/Variant_TwinStick",
@@ -6,4 +6,6 @@
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, DreamEating, "DreamEating" );
 
 DEFINE_LOG_CATEGORY(LogDreamEating)
+
+UE_TRACE_CHANNEL_DEFINE(DreamEatingGameplayChannel)
  
\ No newline at end of file
@@ -3,6 +3,19 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
 /** Main log category used across the project */
 DECLARE_LOG_CATEGORY_EXTERN(LogDreamEating, Log, All);
+
+/** Stats group for gameplay systems across the project */
+DECLARE_STATS_GROUP(TEXT("DreamEating"), STATGROUP_DreamEating, STATCAT_Advanced);
+
+/** Unreal Insights channel for gameplay scopes. Capture with -trace=cpu,DreamEatingGameplay */
+UE_TRACE_CHANNEL_EXTERN(DreamEatingGameplayChannel, DREAMEATING_API);
+
+/** Times a gameplay scope as a cycle stat in the DreamEating stats group and as an event on the DreamEatingGameplay trace channel */
+#define DREAMEATING_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, DreamEatingGameplayChannel)
@@ -42,9 +42,8 @@ ADreamEatingCharacter::ADreamEatingCharacter()
 	TopDownCameraComponent->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
 	TopDownCameraComponent->bUsePawnControlRotation = false;
 
-	// Activate ticking in order to update the cursor every frame.
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = true;
+	// Movement and camera components tick on their own, so the character itself doesn't need to
+	PrimaryActorTick.bCanEverTick = false;
 }
 
 void ADreamEatingCharacter::BeginPlay()
@@ -53,10 +52,3 @@ void ADreamEatingCharacter::BeginPlay()
 
 	// stub
 }
-
-void ADreamEatingCharacter::Tick(float DeltaSeconds)
-{
-    Super::Tick(DeltaSeconds);
-
-	// stub
-}
@@ -32,9 +32,6 @@ public:
 	/** Initialization */
 	virtual void BeginPlay() override;
 
-	/** Update */
-	virtual void Tick(float DeltaSeconds) override;
-
 	/** Returns the camera component **/
 	FORCEINLINE class UCameraComponent* GetTopDownCameraComponent() const { return TopDownCameraComponent; }
 
@@ -4,13 +4,16 @@
 #include "GameFramework/Pawn.h"
 #include "Blueprint/AIBlueprintHelperLibrary.h"
 #include "NiagaraSystem.h"
-#include "NiagaraFunctionLibrary.h"
 #include "DreamEatingCharacter.h"
 #include "Engine/World.h"
 #include "EnhancedInputComponent.h"
 #include "InputActionValue.h"
 #include "EnhancedInputSubsystems.h"
 #include "Engine/LocalPlayer.h"
+#include "DreamEatingPathFollower.h"
+#include "DreamEatingGroundGrid.h"
+#include "DreamEatingSceneQueries.h"
+#include "DreamEatingEffects.h"
 #include "DreamEating.h"
 
 ADreamEatingPlayerController::ADreamEatingPlayerController()
@@ -23,6 +26,9 @@ ADreamEatingPlayerController::ADreamEatingPlayerController()
 	DefaultMouseCursor = EMouseCursor::Default;
 	CachedDestination = FVector::ZeroVector;
 	FollowTime = 0.f;
+
+	// create the path follower
+	PathFollower = CreateDefaultSubobject<UDreamEatingPathFollower>(TEXT("PathFollower"));
 }
 
 void ADreamEatingPlayerController::SetupInputComponent()
@@ -63,39 +69,109 @@ void ADreamEatingPlayerController::SetupInputComponent()
 
 void ADreamEatingPlayerController::OnInputStarted()
 {
+	// Keep following the current path, the new input only retargets it.
+	// Only abort a regular move left over from a fallback, so it doesn't steer the pawn alongside the follower
 	StopMovement();
+	CursorQueryCountdown = 0.0f;
 }
 
 void ADreamEatingPlayerController::OnSetDestinationTriggered()
 {
 	// We flag that the input is being pressed
-	FollowTime += GetWorld()->GetDeltaSeconds();
-	
-	// We look for the location in the world where the player has pressed the input
-	FHitResult Hit;
-	bool bHitSuccessful = false;
-	if (bIsTouch)
+	const float DeltaSeconds = GetWorld()->GetDeltaSeconds();
+	FollowTime += DeltaSeconds;
+
+	// Only query the cursor at the configured rate
+	CursorQueryCountdown -= DeltaSeconds;
+	if (CursorQueryCountdown <= 0.0f)
 	{
-		bHitSuccessful = GetHitResultUnderFinger(ETouchIndex::Touch1, ECollisionChannel::ECC_Visibility, true, Hit);
+		CursorQueryCountdown = CursorQueryInterval;
+
+		// We look for the location in the world where the player has pressed the input
+		if (!GetGroundUnderInput(CachedDestination))
+		{
+			// A short press needs its destination when released, but while held we can steer towards last frame's result
+			const EDreamEatingQueryLatency Latency = FollowTime <= ShortPressThreshold ? EDreamEatingQueryLatency::Immediate : EDreamEatingQueryLatency::NextFrame;
+
+			if (UDreamEatingSceneQueries* SceneQueries = GetWorld()->GetSubsystem<UDreamEatingSceneQueries>())
+			{
+				const FDreamEatingQueryDelegate OnHit = FDreamEatingQueryDelegate::CreateWeakLambda(this, [this](bool bBlockingHit, const FHitResult& Hit)
+				{
+					// If we hit a surface, cache the location
+					if (bBlockingHit)
+					{
+						CachedDestination = Hit.Location;
+					}
+				});
+
+				if (bIsTouch)
+				{
+					float TouchX, TouchY;
+					bool bPressed = false;
+					GetInputTouchState(ETouchIndex::Touch1, TouchX, TouchY, bPressed);
+
+					if (bPressed)
+					{
+						SceneQueries->TraceUnderScreenPosition(Latency, this, FVector2D(TouchX, TouchY), ECollisionChannel::ECC_Visibility, true, OnHit);
+					}
+				}
+				else
+				{
+					SceneQueries->TraceUnderCursor(Latency, this, ECollisionChannel::ECC_Visibility, true, OnHit);
+				}
+			}
+			else
+			{
+				FHitResult Hit;
+				bool bHitSuccessful = false;
+				if (bIsTouch)
+				{
+					bHitSuccessful = GetHitResultUnderFinger(ETouchIndex::Touch1, ECollisionChannel::ECC_Visibility, true, Hit);
+				}
+				else
+				{
+					bHitSuccessful = GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
+				}
+
+				// If we hit a surface, cache the location
+				if (bHitSuccessful)
+				{
+					CachedDestination = Hit.Location;
+				}
+			}
+		}
+
+		// Follow the mouse pointer or touch along a path. Without one we steer straight at it below
+		PathFollower->MoveTo(CachedDestination);
 	}
-	else
+
+	// Steer straight at the destination if we have no path to follow
+	APawn* ControlledPawn = GetPawn();
+	if (ControlledPawn != nullptr && !PathFollower->IsFollowing())
 	{
-		bHitSuccessful = GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
+		FVector WorldDirection = (CachedDestination - ControlledPawn->GetActorLocation()).GetSafeNormal();
+		ControlledPawn->AddMovementInput(WorldDirection, 1.0, false);
 	}
+}
 
-	// If we hit a surface, cache the location
-	if (bHitSuccessful)
+bool ADreamEatingPlayerController::GetGroundUnderInput(FVector& OutLocation) const
+{
+	UDreamEatingGroundGrid* GroundGrid = GetWorld()->GetSubsystem<UDreamEatingGroundGrid>();
+	if (!GroundGrid)
 	{
-		CachedDestination = Hit.Location;
+		return false;
 	}
-	
-	// Move towards mouse pointer or touch
-	APawn* ControlledPawn = GetPawn();
-	if (ControlledPawn != nullptr)
+
+	if (bIsTouch)
 	{
-		FVector WorldDirection = (CachedDestination - ControlledPawn->GetActorLocation()).GetSafeNormal();
-		ControlledPawn->AddMovementInput(WorldDirection, 1.0, false);
+		float TouchX, TouchY;
+		bool bPressed = false;
+		GetInputTouchState(ETouchIndex::Touch1, TouchX, TouchY, bPressed);
+
+		return bPressed && GroundGrid->GetGroundUnderScreenPosition(this, FVector2D(TouchX, TouchY), OutLocation);
 	}
+
+	return GroundGrid->GetGroundUnderCursor(this, OutLocation);
 }
 
 void ADreamEatingPlayerController::OnSetDestinationReleased()
@@ -104,13 +180,32 @@ void ADreamEatingPlayerController::OnSetDestinationReleased()
 	if (FollowTime <= ShortPressThreshold)
 	{
 		// We move there and spawn some particles
-		UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, CachedDestination);
-		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, FXCursor, CachedDestination, FRotator::ZeroRotator, FVector(1.f, 1.f, 1.f), true, true, ENCPoolMethod::None, true);
+		MoveToCachedDestination();
+		if (UDreamEatingEffects* Effects = GetWorld()->GetSubsystem<UDreamEatingEffects>())
+		{
+			Effects->SpawnEffect(FXCursor, CachedDestination, FRotator::ZeroRotator, FVector(1.f, 1.f, 1.f), EDreamEatingEffectPriority::Feedback);
+		}
+	}
+	else
+	{
+		// Holding only steers while the button is down, so stop where we are on release
+		PathFollower->Stop();
 	}
 
 	FollowTime = 0.f;
 }
 
+void ADreamEatingPlayerController::MoveToCachedDestination()
+{
+	// Retarget the path follower without stopping, or fall back to a regular move if there's no path
+	if (!PathFollower->MoveTo(CachedDestination))
+	{
+		// Make sure only one system drives the pawn
+		PathFollower->Stop();
+		UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, CachedDestination);
+	}
+}
+
 // Triggered every frame when the input is held down
 void ADreamEatingPlayerController::OnTouchTriggered()
 {
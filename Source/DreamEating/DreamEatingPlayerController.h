@@ -10,6 +10,7 @@
 class UNiagaraSystem;
 class UInputMappingContext;
 class UInputAction;
+class UDreamEatingPathFollower;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
@@ -24,6 +25,14 @@ class ADreamEatingPlayerController : public APlayerController
 
 protected:
 
+	/** Steers the controlled pawn along its path for both held and clicked moves */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components")
+	UDreamEatingPathFollower* PathFollower;
+
+	/** Time between cursor queries while the move input is held */
+	UPROPERTY(EditAnywhere, Category="Input", meta = (ClampMin = 0, Units = "s"))
+	float CursorQueryInterval = 0.1f;
+
 	/** Time Threshold to know if it was a short press */
 	UPROPERTY(EditAnywhere, Category="Input")
 	float ShortPressThreshold;
@@ -56,6 +65,9 @@ protected:
 	/** Time that the click input has been pressed */
 	float FollowTime = 0.0f;
 
+	/** Time left until the next cursor query while the move input is held */
+	float CursorQueryCountdown = 0.0f;
+
 public:
 
 	/** Constructor */
@@ -73,6 +85,12 @@ protected:
 	void OnTouchTriggered();
 	void OnTouchReleased();
 
+	/** Moves the controlled pawn to the cached destination with the path follower */
+	void MoveToCachedDestination();
+
+	/** Finds the ground under the cursor or touch using the baked ground grid. Returns false if the level has no grid */
+	bool GetGroundUnderInput(FVector& OutLocation) const;
+
 };
 
 
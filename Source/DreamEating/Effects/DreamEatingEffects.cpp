@@ -0,0 +1,290 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingEffects.h"
+#include "NiagaraSystem.h"
+#include "NiagaraComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Effect Spawn"), STAT_EffectSpawn, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Hits"), STAT_EffectPoolHits, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Misses"), STAT_EffectPoolMisses, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effects Over Budget"), STAT_EffectsOverBudget, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effects Culled"), STAT_EffectsCulled, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effects Active"), STAT_EffectsActive, STATGROUP_DreamEating);
+
+static int32 GEffectsSpawnBudget = 8;
+static FAutoConsoleVariableRef CVarEffectsSpawnBudget(
+	TEXT("DreamEating.Effects.SpawnBudget"),
+	GEffectsSpawnBudget,
+	TEXT("Maximum number of cosmetic effects spawned per frame. Feedback effects don't count against it. 0 means unlimited."),
+	ECVF_Default);
+
+static int32 GEffectsMaxPoolSize = 16;
+static FAutoConsoleVariableRef CVarEffectsMaxPoolSize(
+	TEXT("DreamEating.Effects.MaxPoolSize"),
+	GEffectsMaxPoolSize,
+	TEXT("Maximum number of inactive components kept per Niagara system. Finished components beyond this are destroyed."),
+	ECVF_Default);
+
+static float GEffectsCullDistance = 6000.0f;
+static FAutoConsoleVariableRef CVarEffectsCullDistance(
+	TEXT("DreamEating.Effects.CullDistance"),
+	GEffectsCullDistance,
+	TEXT("Effects further than this from a perspective view are skipped. 0 disables distance culling."),
+	ECVF_Default);
+
+static float GEffectsScreenMargin = 0.1f;
+static FAutoConsoleVariableRef CVarEffectsScreenMargin(
+	TEXT("DreamEating.Effects.ScreenMargin"),
+	GEffectsScreenMargin,
+	TEXT("Fraction of the viewport size an effect may be outside of the screen and still spawn."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdEffectsReport(
+	TEXT("DreamEating.Effects.Report"),
+	TEXT("Logs the effect pool sizes, pool hit rate, skipped spawns and average spawn cost."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UDreamEatingEffects* Effects = World ? World->GetSubsystem<UDreamEatingEffects>() : nullptr)
+		{
+			Effects->LogReport();
+		}
+	}));
+
+bool UDreamEatingEffects::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingEffects::Deinitialize()
+{
+	for (TPair<TObjectPtr<UNiagaraSystem>, FDreamEatingEffectPool>& Pair : Pools)
+	{
+		for (UNiagaraComponent* Component : Pair.Value.Free)
+		{
+			if (IsValid(Component))
+			{
+				Component->DestroyComponent();
+			}
+		}
+
+		for (UNiagaraComponent* Component : Pair.Value.Active)
+		{
+			if (IsValid(Component))
+			{
+				Component->OnSystemFinished.RemoveAll(this);
+				Component->DestroyComponent();
+			}
+		}
+	}
+
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+UNiagaraComponent* UDreamEatingEffects::SpawnEffect(UNiagaraSystem* System, FVector Location, FRotator Rotation, FVector Scale, EDreamEatingEffectPriority Priority)
+{
+	if (!System)
+	{
+		return nullptr;
+	}
+
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_EffectSpawn);
+	DREAMEATING_PERF_SCOPE(Spawning);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// reset the budget on the first spawn of a frame
+	if (BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		SpawnsThisFrame = 0;
+	}
+
+	// cosmetic effects share the per-frame budget
+	if (Priority == EDreamEatingEffectPriority::Cosmetic)
+	{
+		if (GEffectsSpawnBudget > 0 && SpawnsThisFrame >= GEffectsSpawnBudget)
+		{
+			INC_DWORD_STAT(STAT_EffectsOverBudget);
+			++TotalOverBudget;
+			return nullptr;
+		}
+	}
+
+	// skip effects nobody will see
+	if (!IsSignificant(Location))
+	{
+		INC_DWORD_STAT(STAT_EffectsCulled);
+		++TotalCulled;
+		return nullptr;
+	}
+
+	if (Priority == EDreamEatingEffectPriority::Cosmetic)
+	{
+		++SpawnsThisFrame;
+	}
+
+	FDreamEatingEffectPool& Pool = Pools.FindOrAdd(System);
+
+	// reuse a finished component if we have one
+	UNiagaraComponent* Component = nullptr;
+
+	while (Pool.Free.Num() > 0 && !Component)
+	{
+		Component = Pool.Free.Pop(EAllowShrinking::No);
+
+		// components may have been destroyed with their level
+		if (!IsValid(Component))
+		{
+			Component = nullptr;
+		}
+	}
+
+	if (Component)
+	{
+		INC_DWORD_STAT(STAT_EffectPoolHits);
+		++TotalPoolHits;
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_EffectPoolMisses);
+		++TotalPoolMisses;
+
+		Component = CreateComponent(System);
+	}
+
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	Component->SetWorldScale3D(Scale);
+	Component->Activate(true);
+
+	Pool.Active.Add(Component);
+	INC_DWORD_STAT(STAT_EffectsActive);
+
+	TotalSpawnTime += FPlatformTime::Seconds() - StartTime;
+
+	return Component;
+}
+
+void UDreamEatingEffects::PrewarmPool(UNiagaraSystem* System, int32 Count)
+{
+	if (!System)
+	{
+		return;
+	}
+
+	FDreamEatingEffectPool& Pool = Pools.FindOrAdd(System);
+
+	while (Pool.Free.Num() < FMath::Min(Count, GEffectsMaxPoolSize))
+	{
+		Pool.Free.Add(CreateComponent(System));
+	}
+}
+
+void UDreamEatingEffects::LogReport() const
+{
+	const int64 TotalSpawns = TotalPoolHits + TotalPoolMisses;
+
+	UE_LOG(LogDreamEating, Display, TEXT("Effects: %lld spawned, %.1f%% pool hits, %lld over budget, %lld culled, %.2f us average spawn cost"),
+		TotalSpawns,
+		TotalSpawns > 0 ? 100.0 * TotalPoolHits / TotalSpawns : 0.0,
+		TotalOverBudget,
+		TotalCulled,
+		TotalSpawns > 0 ? TotalSpawnTime * 1000000.0 / TotalSpawns : 0.0);
+
+	for (const TPair<TObjectPtr<UNiagaraSystem>, FDreamEatingEffectPool>& Pair : Pools)
+	{
+		UE_LOG(LogDreamEating, Display, TEXT("    %s: %d active, %d free"), *GetNameSafe(Pair.Key), Pair.Value.Active.Num(), Pair.Value.Free.Num());
+	}
+}
+
+bool UDreamEatingEffects::IsSignificant(const FVector& Location) const
+{
+	bool bHasView = false;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+
+		if (!PlayerController || !PlayerController->IsLocalController() || !PlayerController->PlayerCameraManager)
+		{
+			continue;
+		}
+
+		bHasView = true;
+
+		// orthographic views keep a fixed distance to everything they show, so only the screen test applies
+		const FMinimalViewInfo& View = PlayerController->PlayerCameraManager->GetCameraCacheView();
+
+		if (View.ProjectionMode == ECameraProjectionMode::Perspective && GEffectsCullDistance > 0.0f
+			&& FVector::DistSquared(View.Location, Location) > FMath::Square(GEffectsCullDistance))
+		{
+			continue;
+		}
+
+		FVector2D ScreenLocation;
+		int32 ViewportX, ViewportY;
+
+		PlayerController->GetViewportSize(ViewportX, ViewportY);
+
+		if (!PlayerController->ProjectWorldLocationToScreen(Location, ScreenLocation, true))
+		{
+			continue;
+		}
+
+		const float MarginX = ViewportX * GEffectsScreenMargin;
+		const float MarginY = ViewportY * GEffectsScreenMargin;
+
+		if (ScreenLocation.X >= -MarginX && ScreenLocation.X <= ViewportX + MarginX
+			&& ScreenLocation.Y >= -MarginY && ScreenLocation.Y <= ViewportY + MarginY)
+		{
+			return true;
+		}
+	}
+
+	// without a local view there's nothing to cull against
+	return !bHasView;
+}
+
+UNiagaraComponent* UDreamEatingEffects::CreateComponent(UNiagaraSystem* System)
+{
+	// the world settings own pooled components so they live in the persistent level
+	UNiagaraComponent* Component = NewObject<UNiagaraComponent>(GetWorld()->GetWorldSettings());
+	Component->SetAsset(System);
+	Component->SetAutoActivate(false);
+	Component->SetAutoDestroy(false);
+	Component->OnSystemFinished.AddDynamic(this, &UDreamEatingEffects::OnEffectFinished);
+	Component->RegisterComponentWithWorld(GetWorld());
+
+	return Component;
+}
+
+void UDreamEatingEffects::OnEffectFinished(UNiagaraComponent* Component)
+{
+	FDreamEatingEffectPool* Pool = Pools.Find(Component->GetAsset());
+
+	if (!Pool || Pool->Active.RemoveSwap(Component, EAllowShrinking::No) == 0)
+	{
+		return;
+	}
+
+	DEC_DWORD_STAT(STAT_EffectsActive);
+
+	// keep the component for the next spawn unless the pool is already full
+	if (Pool->Free.Num() < GEffectsMaxPoolSize)
+	{
+		Pool->Free.Add(Component);
+	}
+	else
+	{
+		Component->OnSystemFinished.RemoveAll(this);
+		Component->DestroyComponent();
+	}
+}
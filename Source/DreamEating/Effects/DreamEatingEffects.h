@@ -0,0 +1,116 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DreamEatingEffects.generated.h"
+
+class UNiagaraSystem;
+class UNiagaraComponent;
+
+/**
+ *  How an effect is treated when the frame is busy or the effect is hard to see
+ */
+UENUM(BlueprintType)
+enum class EDreamEatingEffectPriority : uint8
+{
+	/** Decoration that can be skipped when over budget, too far away or off screen */
+	Cosmetic,
+
+	/** Direct response to player input. Ignores the spawn budget, but is still culled off screen */
+	Feedback
+};
+
+/**
+ *  Pooled components for a single Niagara system
+ */
+USTRUCT()
+struct FDreamEatingEffectPool
+{
+	GENERATED_BODY()
+
+	/** Inactive components ready to be reused */
+	UPROPERTY()
+	TArray<TObjectPtr<UNiagaraComponent>> Free;
+
+	/** Components currently playing an effect */
+	UPROPERTY()
+	TArray<TObjectPtr<UNiagaraComponent>> Active;
+};
+
+/**
+ *  Effects service shared by every variant.
+ *  Spawns one-shot Niagara effects from per-system component pools and returns them to their pool once they finish.
+ *  Cosmetic effects share a per-frame spawn budget, and any effect that is too far from the view or off screen is skipped.
+ *  Pool hits and misses, culled spawns and spawn cost are reported in the DreamEating stat group.
+ */
+UCLASS()
+class UDreamEatingEffects : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Component pools, keyed by Niagara system */
+	UPROPERTY()
+	TMap<TObjectPtr<UNiagaraSystem>, FDreamEatingEffectPool> Pools;
+
+	/** Frame the spawn budget was last reset on */
+	uint64 BudgetFrame = 0;
+
+	/** Number of cosmetic effects spawned on the budget frame */
+	int32 SpawnsThisFrame = 0;
+
+	/** Total number of spawns served from a pool */
+	int64 TotalPoolHits = 0;
+
+	/** Total number of spawns that had to create a new component */
+	int64 TotalPoolMisses = 0;
+
+	/** Total number of spawns skipped by the budget */
+	int64 TotalOverBudget = 0;
+
+	/** Total number of spawns skipped by significance culling */
+	int64 TotalCulled = 0;
+
+	/** Total time spent spawning effects, in seconds */
+	double TotalSpawnTime = 0.0;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+public:
+
+	/**
+	 *  Spawns a one-shot effect at the given location.
+	 *  Returns the component playing the effect, or nullptr if it was skipped. The component goes back to its pool
+	 *  when the effect finishes, so it shouldn't be kept around. Looping systems must be deactivated by the caller.
+	 */
+	UFUNCTION(BlueprintCallable, Category="Effects", meta = (AdvancedDisplay = "Rotation,Scale"))
+	UNiagaraComponent* SpawnEffect(UNiagaraSystem* System, FVector Location, FRotator Rotation, FVector Scale = FVector(1.0f, 1.0f, 1.0f), EDreamEatingEffectPriority Priority = EDreamEatingEffectPriority::Cosmetic);
+
+	/** Fills the pool for a system with inactive components, so its first spawns don't have to create them */
+	UFUNCTION(BlueprintCallable, Category="Effects")
+	void PrewarmPool(UNiagaraSystem* System, int32 Count);
+
+	/** Logs the pool sizes, hit rate, culled spawns and average spawn cost */
+	void LogReport() const;
+
+protected:
+
+	/** Returns true if an effect at the given location is close enough to and inside the view of a local player */
+	bool IsSignificant(const FVector& Location) const;
+
+	/** Creates a new pooled component for the system */
+	UNiagaraComponent* CreateComponent(UNiagaraSystem* System);
+
+	/** Returns a finished component to its pool */
+	UFUNCTION()
+	void OnEffectFinished(UNiagaraComponent* Component);
+};
@@ -0,0 +1,536 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingGroundGrid.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Engine/LevelBounds.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ground Grid Deproject"), STAT_GroundGridDeproject, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ground Grid Queries"), STAT_GroundGridQueries, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ground Grid Misses"), STAT_GroundGridMisses, STATGROUP_DreamEating);
+
+/** File type tag of ground grid files */
+static constexpr uint32 GroundGridMagic = 0x47474544;
+
+/** Current ground grid file format version */
+static constexpr uint32 GroundGridVersion = 1;
+
+/** Quantized height value reserved for cells without ground */
+static constexpr uint16 GroundGridNoGround = 0x7FFF;
+
+/** Highest quantized height value */
+static constexpr uint16 GroundGridMaxHeight = 0x7FFE;
+
+/** Walkable flag of a packed cell */
+static constexpr uint16 GroundGridWalkableFlag = 0x8000;
+
+/** Max number of cells along each side of a baked grid */
+static constexpr int32 GroundGridMaxSize = 4096;
+
+/** Min ground normal Z considered walkable. Matches the character movement default walkable slope */
+static constexpr float GroundGridWalkableFloorZ = 0.71f;
+
+/** Max number of ray march steps per deprojection */
+static constexpr int32 GroundGridMaxSteps = 8192;
+
+static bool GGroundGridEnabled = true;
+static FAutoConsoleVariableRef CVarGroundGridEnabled(
+	TEXT("DreamEating.GroundGrid.Enabled"),
+	GGroundGridEnabled,
+	TEXT("If true, cursor, touch and aim queries deproject against the baked ground grid instead of tracing against complex collision."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdGroundGridBake(
+	TEXT("DreamEating.GroundGrid.Bake"),
+	TEXT("Bakes the ground grid for the current level and reloads it. Usage: DreamEating.GroundGrid.Bake [CellSize=50]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const float CellSize = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 50.0f;
+
+		if (UDreamEatingGroundGrid::BakeWorld(World, CellSize))
+		{
+			if (UDreamEatingGroundGrid* GroundGrid = World->GetSubsystem<UDreamEatingGroundGrid>())
+			{
+				GroundGrid->Reload();
+			}
+		}
+	}));
+
+bool UDreamEatingGroundGrid::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingGroundGrid::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	Reload();
+}
+
+void UDreamEatingGroundGrid::Deinitialize()
+{
+	Unload();
+
+	Super::Deinitialize();
+}
+
+bool UDreamEatingGroundGrid::HasGrid() const
+{
+	return GGroundGridEnabled && Cells != nullptr;
+}
+
+bool UDreamEatingGroundGrid::GetHeight(const FVector& Location, float& OutHeight, bool* bOutWalkable) const
+{
+	if (!HasGrid())
+	{
+		return false;
+	}
+
+	const int32 X = FMath::FloorToInt32((Location.X - Header.OriginX) / Header.CellSize);
+	const int32 Y = FMath::FloorToInt32((Location.Y - Header.OriginY) / Header.CellSize);
+
+	bool bWalkable = false;
+
+	if (!ReadCell(X, Y, OutHeight, bWalkable))
+	{
+		return false;
+	}
+
+	if (bOutWalkable)
+	{
+		*bOutWalkable = bWalkable;
+	}
+
+	return true;
+}
+
+bool UDreamEatingGroundGrid::Deproject(const FVector& RayOrigin, const FVector& RayDirection, FVector& OutLocation, bool* bOutWalkable) const
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_GroundGridDeproject);
+
+	if (!HasGrid())
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_GroundGridQueries);
+
+	const FVector Direction = RayDirection.GetSafeNormal();
+
+	// we only handle rays looking down at the ground
+	if (Direction.Z > -UE_KINDA_SMALL_NUMBER)
+	{
+		INC_DWORD_STAT(STAT_GroundGridMisses);
+		return false;
+	}
+
+	// clip the ray to the grid's height range so we don't march through empty space
+	const double MaxHeight = Header.MinHeight + GroundGridMaxHeight * Header.HeightStep;
+	const double StartT = FMath::Max((MaxHeight - RayOrigin.Z) / Direction.Z, 0.0);
+	const double EndT = (Header.MinHeight - RayOrigin.Z) / Direction.Z;
+
+	if (EndT < StartT)
+	{
+		INC_DWORD_STAT(STAT_GroundGridMisses);
+		return false;
+	}
+
+	// step so we never skip more than half a cell horizontally. Vertical rays only need the two ends
+	const double HorizontalLength = Direction.Size2D();
+	const double StepT = HorizontalLength > UE_KINDA_SMALL_NUMBER ? FMath::Min(Header.CellSize * 0.5 / HorizontalLength, EndT - StartT) : EndT - StartT;
+
+	double PrevT = StartT;
+	double PrevDiff = UE_BIG_NUMBER;
+	double T = StartT;
+
+	for (int32 Step = 0; Step < GroundGridMaxSteps; ++Step)
+	{
+		const FVector Point = RayOrigin + Direction * T;
+
+		float Height = 0.0f;
+		bool bWalkable = false;
+
+		if (GetHeight(Point, Height, &bWalkable))
+		{
+			const double Diff = Point.Z - Height;
+
+			// did we go below the ground?
+			if (Diff <= 0.0)
+			{
+				// refine the crossing between the last two samples
+				const double HitT = (T > PrevT && PrevDiff < UE_BIG_NUMBER) ? PrevT + (T - PrevT) * PrevDiff / (PrevDiff - Diff) : T;
+				const FVector HitPoint = RayOrigin + Direction * HitT;
+
+				GetHeight(HitPoint, Height, &bWalkable);
+
+				OutLocation = FVector(HitPoint.X, HitPoint.Y, Height);
+
+				if (bOutWalkable)
+				{
+					*bOutWalkable = bWalkable;
+				}
+
+				return true;
+			}
+
+			PrevDiff = Diff;
+		}
+		else
+		{
+			// cells without ground never stop the ray
+			PrevDiff = UE_BIG_NUMBER;
+		}
+
+		PrevT = T;
+
+		if (T >= EndT)
+		{
+			break;
+		}
+
+		T = FMath::Min(T + StepT, EndT);
+	}
+
+	INC_DWORD_STAT(STAT_GroundGridMisses);
+	return false;
+}
+
+bool UDreamEatingGroundGrid::GetGroundUnderScreenPosition(const APlayerController* PlayerController, const FVector2D& ScreenPosition, FVector& OutLocation) const
+{
+	if (!HasGrid() || !PlayerController)
+	{
+		return false;
+	}
+
+	FVector RayOrigin, RayDirection;
+
+	if (!PlayerController->DeprojectScreenPositionToWorld(ScreenPosition.X, ScreenPosition.Y, RayOrigin, RayDirection))
+	{
+		return false;
+	}
+
+	FVector GroundLocation;
+
+	if (!Deproject(RayOrigin, RayDirection, GroundLocation))
+	{
+		return false;
+	}
+
+	// the grid only knows about static geometry, so check for dynamic objects between the camera and the ground
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GroundGridDynamic), false, PlayerController->GetPawn());
+
+	FHitResult OutHit;
+
+	OutLocation = GetWorld()->LineTraceSingleByObjectType(OutHit, RayOrigin, GroundLocation, ObjectParams, QueryParams) ? OutHit.ImpactPoint : GroundLocation;
+
+	return true;
+}
+
+bool UDreamEatingGroundGrid::GetGroundUnderCursor(const APlayerController* PlayerController, FVector& OutLocation) const
+{
+	float MouseX, MouseY;
+
+	if (!PlayerController || !PlayerController->GetMousePosition(MouseX, MouseY))
+	{
+		return false;
+	}
+
+	return GetGroundUnderScreenPosition(PlayerController, FVector2D(MouseX, MouseY), OutLocation);
+}
+
+void UDreamEatingGroundGrid::Reload()
+{
+	Unload();
+
+	const FString Path = GetGridFilePath(GetWorld());
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	if (!PlatformFile.FileExists(*Path))
+	{
+		UE_LOG(LogDreamEating, Verbose, TEXT("No ground grid baked for this level at %s"), *Path);
+		return;
+	}
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	// map the file so only the pages we query are ever read
+	MappedFile.Reset(PlatformFile.OpenMapped(*Path));
+
+	if (MappedFile)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		DataSize = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Path))
+	{
+		// this platform can't map files, so load the whole thing instead
+		Data = LoadedFile.GetData();
+		DataSize = LoadedFile.Num();
+	}
+
+	if (!Data || DataSize < int64(sizeof(FDreamEatingGroundGridHeader)))
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Couldn't read the ground grid at %s"), *Path);
+		Unload();
+		return;
+	}
+
+	FMemory::Memcpy(&Header, Data, sizeof(FDreamEatingGroundGridHeader));
+
+	const int64 NumCells = int64(Header.SizeX) * Header.SizeY;
+
+	if (Header.Magic != GroundGridMagic || Header.Version != GroundGridVersion || NumCells <= 0 || Header.CellSize <= 0.0f
+		|| DataSize < int64(sizeof(FDreamEatingGroundGridHeader)) + NumCells * int64(sizeof(uint16)))
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Ground grid at %s is invalid or out of date, rebake it"), *Path);
+		Unload();
+		return;
+	}
+
+	Cells = reinterpret_cast<const uint16*>(Data + sizeof(FDreamEatingGroundGridHeader));
+
+	UE_LOG(LogDreamEating, Log, TEXT("Loaded %dx%d ground grid from %s (%s)"), Header.SizeX, Header.SizeY, *Path, MappedRegion ? TEXT("mapped") : TEXT("loaded"));
+}
+
+FString UDreamEatingGroundGrid::GetGridFilePath(const UWorld* World)
+{
+	// PIE worlds share the grid of the level they were started from
+	const FString MapName = FPackageName::GetShortName(UWorld::RemovePIEPrefix(World->GetOutermost()->GetName()));
+
+	return FPaths::ProjectContentDir() / TEXT("GroundGrids") / MapName + TEXT(".ground");
+}
+
+bool UDreamEatingGroundGrid::BakeWorld(UWorld* World, float CellSize)
+{
+	if (!World || !World->PersistentLevel)
+	{
+		return false;
+	}
+
+	const FBox Bounds = ALevelBounds::CalculateLevelBounds(World->PersistentLevel);
+
+	if (!Bounds.IsValid)
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Can't bake a ground grid for %s, the level has no bounds"), *World->GetName());
+		return false;
+	}
+
+	CellSize = FMath::Max(CellSize, 1.0f);
+
+	FDreamEatingGroundGridHeader NewHeader;
+	NewHeader.Magic = GroundGridMagic;
+	NewHeader.Version = GroundGridVersion;
+	NewHeader.SizeX = FMath::Clamp(FMath::CeilToInt32(Bounds.GetSize().X / CellSize), 1, GroundGridMaxSize);
+	NewHeader.SizeY = FMath::Clamp(FMath::CeilToInt32(Bounds.GetSize().Y / CellSize), 1, GroundGridMaxSize);
+	NewHeader.CellSize = CellSize;
+	NewHeader.OriginX = Bounds.Min.X;
+	NewHeader.OriginY = Bounds.Min.Y;
+
+	const int32 NumCells = NewHeader.SizeX * NewHeader.SizeY;
+
+	TArray<float> Heights;
+	Heights.SetNumUninitialized(NumCells);
+
+	TArray<uint8> Walkable;
+	Walkable.SetNumZeroed(NumCells);
+
+	TBitArray<> HasGround(false, NumCells);
+
+	float MinHeight = TNumericLimits<float>::Max();
+	float MaxHeight = TNumericLimits<float>::Lowest();
+
+	// only bake static collision, dynamic objects are still traced at query time
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldStatic);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GroundGridBake), false);
+
+	for (int32 Y = 0; Y < NewHeader.SizeY; ++Y)
+	{
+		for (int32 X = 0; X < NewHeader.SizeX; ++X)
+		{
+			const int32 Index = Y * NewHeader.SizeX + X;
+			const double CellX = NewHeader.OriginX + (X + 0.5) * CellSize;
+			const double CellY = NewHeader.OriginY + (Y + 0.5) * CellSize;
+
+			FHitResult OutHit;
+
+			if (World->LineTraceSingleByObjectType(OutHit, FVector(CellX, CellY, Bounds.Max.Z + 100.0), FVector(CellX, CellY, Bounds.Min.Z - 100.0), ObjectParams, QueryParams))
+			{
+				Heights[Index] = OutHit.ImpactPoint.Z;
+				Walkable[Index] = OutHit.ImpactNormal.Z >= GroundGridWalkableFloorZ ? 1 : 0;
+				HasGround[Index] = true;
+
+				MinHeight = FMath::Min(MinHeight, Heights[Index]);
+				MaxHeight = FMath::Max(MaxHeight, Heights[Index]);
+			}
+		}
+	}
+
+	if (MinHeight > MaxHeight)
+	{
+		MinHeight = MaxHeight = 0.0f;
+	}
+
+	// quantize heights to the level's height range
+	NewHeader.MinHeight = MinHeight;
+	NewHeader.HeightStep = FMath::Max((MaxHeight - MinHeight) / GroundGridMaxHeight, 0.1f);
+
+	TArray<uint8> FileData;
+	FileData.SetNumUninitialized(sizeof(FDreamEatingGroundGridHeader) + NumCells * sizeof(uint16));
+	FMemory::Memcpy(FileData.GetData(), &NewHeader, sizeof(FDreamEatingGroundGridHeader));
+
+	uint16* PackedCells = reinterpret_cast<uint16*>(FileData.GetData() + sizeof(FDreamEatingGroundGridHeader));
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		if (HasGround[Index])
+		{
+			const uint16 Quantized = uint16(FMath::Clamp(FMath::RoundToInt32((Heights[Index] - MinHeight) / NewHeader.HeightStep), 0, int32(GroundGridMaxHeight)));
+
+			PackedCells[Index] = Quantized | (Walkable[Index] ? GroundGridWalkableFlag : 0);
+		}
+		else
+		{
+			PackedCells[Index] = GroundGridNoGround;
+		}
+	}
+
+	const FString Path = GetGridFilePath(World);
+
+	if (!FFileHelper::SaveArrayToFile(FileData, *Path))
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Couldn't save the ground grid to %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogDreamEating, Display, TEXT("Baked %dx%d ground grid for %s to %s (%d KB)"), NewHeader.SizeX, NewHeader.SizeY, *World->GetName(), *Path, FileData.Num() / 1024);
+
+	return true;
+}
+
+void UDreamEatingGroundGrid::Unload()
+{
+	Cells = nullptr;
+	Header = FDreamEatingGroundGridHeader();
+
+	// the region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+}
+
+bool UDreamEatingGroundGrid::ReadCell(int32 X, int32 Y, float& OutHeight, bool& bOutWalkable) const
+{
+	if (X < 0 || Y < 0 || X >= Header.SizeX || Y >= Header.SizeY)
+	{
+		return false;
+	}
+
+	const uint16 Packed = Cells[Y * Header.SizeX + X];
+	const uint16 Quantized = Packed & GroundGridNoGround;
+
+	if (Quantized == GroundGridNoGround)
+	{
+		return false;
+	}
+
+	OutHeight = Header.MinHeight + Quantized * Header.HeightStep;
+	bOutWalkable = (Packed & GroundGridWalkableFlag) != 0;
+
+	return true;
+}
+
+UDreamEatingGroundGridCommandlet::UDreamEatingGroundGridCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UDreamEatingGroundGridCommandlet::Main(const FString& Params)
+{
+	FString MapList;
+	float CellSize = 50.0f;
+
+	FParse::Value(*Params, TEXT("Map="), MapList);
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+
+	TArray<FString> Maps;
+	MapList.ParseIntoArray(Maps, TEXT("+"));
+
+	if (Maps.Num() == 0)
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("No maps to bake. Usage: -run=DreamEatingGroundGrid -Map=/Game/Maps/Map1+/Game/Maps/Map2 [-CellSize=50]"));
+		return 1;
+	}
+
+	int32 NumFailed = 0;
+
+	for (const FString& Map : Maps)
+	{
+		UPackage* Package = LoadPackage(nullptr, *Map, LOAD_None);
+		UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+		if (!World)
+		{
+			UE_LOG(LogDreamEating, Error, TEXT("Couldn't load map %s"), *Map);
+			++NumFailed;
+			continue;
+		}
+
+		World->AddToRoot();
+
+		// we only need collision to bake the grid
+		if (!World->bIsWorldInitialized)
+		{
+			UWorld::InitializationValues IVS;
+			IVS.RequiresHitProxies(false)
+				.ShouldSimulatePhysics(false)
+				.EnableTraceCollision(true)
+				.CreateNavigation(false)
+				.CreateAISystem(false)
+				.AllowAudioPlayback(false)
+				.CreatePhysicsScene(true);
+
+			World->InitWorld(IVS);
+		}
+
+		World->UpdateWorldComponents(true, false);
+
+		if (!UDreamEatingGroundGrid::BakeWorld(World, CellSize))
+		{
+			++NumFailed;
+		}
+
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+
+		CollectGarbage(RF_NoFlags);
+	}
+
+	return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Commandlets/Commandlet.h"
+#include "DreamEatingGroundGrid.generated.h"
+
+class APlayerController;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ *  Header of a baked ground grid file. Followed by SizeX * SizeY packed cells.
+ *  Each cell holds a quantized height in its low 15 bits and a walkable flag in its top bit.
+ */
+struct FDreamEatingGroundGridHeader
+{
+	/** File type tag */
+	uint32 Magic = 0;
+
+	/** File format version */
+	uint32 Version = 0;
+
+	/** Number of cells along X */
+	int32 SizeX = 0;
+
+	/** Number of cells along Y */
+	int32 SizeY = 0;
+
+	/** Size of each cell, in cm */
+	float CellSize = 0.0f;
+
+	/** World X of the grid's minimum corner */
+	float OriginX = 0.0f;
+
+	/** World Y of the grid's minimum corner */
+	float OriginY = 0.0f;
+
+	/** World Z of a zero height cell */
+	float MinHeight = 0.0f;
+
+	/** Height of one quantization step, in cm */
+	float HeightStep = 0.0f;
+};
+
+/**
+ *  Baked 2D ground height and walkability grid for the current level.
+ *  The grid is baked ahead of time against static collision and memory-mapped when play begins,
+ *  so cursor, touch and placement queries can deproject against it in microseconds instead
+ *  of running complex collision traces. Physics traces are only used for dynamic objects
+ *  standing on the ground, or when the level has no baked grid.
+ */
+UCLASS()
+class UDreamEatingGroundGrid : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Mapped grid file */
+	TUniquePtr<IMappedFileHandle> MappedFile;
+
+	/** Mapped region covering the whole grid file */
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** Grid file contents, used when the platform can't map files */
+	TArray64<uint8> LoadedFile;
+
+	/** Header of the loaded grid */
+	FDreamEatingGroundGridHeader Header;
+
+	/** Packed cells of the loaded grid. Points into the mapped or loaded file */
+	const uint16* Cells = nullptr;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Maps the grid baked for this level */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+public:
+
+	/** Returns true if a baked grid is loaded and queries are enabled */
+	bool HasGrid() const;
+
+	/** Returns the baked ground height at the given location. Returns false outside the grid or over cells without ground */
+	bool GetHeight(const FVector& Location, float& OutHeight, bool* bOutWalkable = nullptr) const;
+
+	/** Intersects a ray with the baked heightfield. Returns false if the ray doesn't reach the ground inside the grid */
+	bool Deproject(const FVector& RayOrigin, const FVector& RayDirection, FVector& OutLocation, bool* bOutWalkable = nullptr) const;
+
+	/** Finds the ground under a screen position, including dynamic objects standing on it. Returns false if the caller should fall back to a regular trace */
+	bool GetGroundUnderScreenPosition(const APlayerController* PlayerController, const FVector2D& ScreenPosition, FVector& OutLocation) const;
+
+	/** Finds the ground under the mouse cursor, including dynamic objects standing on it. Returns false if the caller should fall back to a regular trace */
+	bool GetGroundUnderCursor(const APlayerController* PlayerController, FVector& OutLocation) const;
+
+	/** Reloads the grid file for this level */
+	void Reload();
+
+	/** Returns the grid file path for the given world */
+	static FString GetGridFilePath(const UWorld* World);
+
+	/** Bakes the grid for the given world against its static collision and saves it. Returns false if the world has no bounds to bake */
+	static bool BakeWorld(UWorld* World, float CellSize);
+
+protected:
+
+	/** Releases the loaded grid */
+	void Unload();
+
+	/** Unpacks a cell. Returns false if the cell has no ground */
+	bool ReadCell(int32 X, int32 Y, float& OutHeight, bool& bOutWalkable) const;
+};
+
+/**
+ *  Bakes ground grids for the given maps. Run as part of the cook:
+ *  UnrealEditor-Cmd DreamEating -run=DreamEatingGroundGrid -Map=/Game/Maps/Map1+/Game/Maps/Map2 [-CellSize=50]
+ */
+UCLASS()
+class UDreamEatingGroundGridCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Constructor */
+	UDreamEatingGroundGridCommandlet();
+
+	/** Bakes the grid for each map on the command line */
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,217 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingNavMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Nav Movement Tick"), STAT_NavMovementTick, STATGROUP_DreamEating);
+DECLARE_CYCLE_STAT(TEXT("Nav Movement Full Tick"), STAT_NavMovementFullTick, STATGROUP_DreamEating);
+
+static bool GNavMovementEnabled = true;
+static FAutoConsoleVariableRef CVarNavMovementEnabled(
+	TEXT("DreamEating.NavMovement.Enabled"),
+	GNavMovementEnabled,
+	TEXT("If true, characters using the nav movement component skip the full character movement update while on the navmesh."),
+	ECVF_Default);
+
+/** Accumulated movement tick cost, used by the benchmark command */
+static double GNavMovementTickTime = 0.0;
+
+/** Number of movement ticks accumulated */
+static int64 GNavMovementTickCount = 0;
+
+/** Returns the average movement tick cost since the last reset, in microseconds */
+static double ConsumeNavMovementTickCost()
+{
+	const double AverageCost = GNavMovementTickCount > 0 ? GNavMovementTickTime * 1000000.0 / GNavMovementTickCount : 0.0;
+
+	GNavMovementTickTime = 0.0;
+	GNavMovementTickCount = 0;
+
+	return AverageCost;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdNavMovementBenchmark(
+	TEXT("DreamEating.NavMovement.Benchmark"),
+	TEXT("Measures the per-unit movement tick cost with and without the nav movement update. Usage: DreamEating.NavMovement.Benchmark [Seconds=5]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		const float Seconds = FMath::Max(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 5.0f, 0.5f);
+		const bool bPreviousEnabled = GNavMovementEnabled;
+
+		// measure the nav movement update first
+		GNavMovementEnabled = true;
+		ConsumeNavMovementTickCost();
+
+		FTimerHandle TimerHandle;
+		World->GetTimerManager().SetTimer(TimerHandle, FTimerDelegate::CreateLambda([WeakWorld = TWeakObjectPtr<UWorld>(World), Seconds, bPreviousEnabled]()
+		{
+			const double NavMovementCost = ConsumeNavMovementTickCost();
+
+			// then the full character movement update
+			GNavMovementEnabled = false;
+
+			UWorld* CurrentWorld = WeakWorld.Get();
+
+			if (!CurrentWorld)
+			{
+				GNavMovementEnabled = bPreviousEnabled;
+				return;
+			}
+
+			FTimerHandle SecondHandle;
+			CurrentWorld->GetTimerManager().SetTimer(SecondHandle, FTimerDelegate::CreateLambda([NavMovementCost, bPreviousEnabled]()
+			{
+				const double FullCost = ConsumeNavMovementTickCost();
+
+				GNavMovementEnabled = bPreviousEnabled;
+
+				UE_LOG(LogDreamEating, Display, TEXT("Nav movement benchmark: nav movement %.2f us per unit tick, character movement %.2f us per unit tick (%.1fx)"),
+					NavMovementCost, FullCost, NavMovementCost > 0.0 ? FullCost / NavMovementCost : 0.0);
+
+			}), Seconds, false);
+
+		}), Seconds, false);
+
+		UE_LOG(LogDreamEating, Display, TEXT("Nav movement benchmark started, %.1f seconds per mode"), Seconds);
+	}));
+
+void UDreamEatingNavMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (CanUseNavMovement(DeltaTime))
+	{
+		DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_NavMovementTick);
+		DREAMEATING_PERF_SCOPE(Movement);
+
+		// skip the character movement update, but keep the base movement component bookkeeping
+		UPawnMovementComponent::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+		TickNavMovement(DeltaTime);
+	}
+	else
+	{
+		DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_NavMovementFullTick);
+		DREAMEATING_PERF_SCOPE(Movement);
+
+		// the full update may take us anywhere, so check for a nav floor again before switching back
+		bOnNavMesh = false;
+
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	}
+
+	GNavMovementTickTime += FPlatformTime::Seconds() - StartTime;
+	++GNavMovementTickCount;
+}
+
+bool UDreamEatingNavMovementComponent::CanUseNavMovement(float DeltaTime) const
+{
+	if (!GNavMovementEnabled || !CharacterOwner || !UpdatedComponent || DeltaTime <= 0.0f)
+	{
+		return false;
+	}
+
+	// we only handle authoritative, grounded movement without root motion
+	return CharacterOwner->GetLocalRole() == ROLE_Authority
+		&& IsMovingOnGround()
+		&& !HasAnimRootMotion()
+		&& !CurrentRootMotion.HasActiveRootMotionSources()
+		&& !ShouldSkipUpdate(DeltaTime)
+		&& HasNavFloor();
+}
+
+bool UDreamEatingNavMovementComponent::HasNavFloor() const
+{
+	// the last nav movement update already found a floor where we stand
+	if (bOnNavMesh)
+	{
+		return true;
+	}
+
+	// we left the navmesh or were never on it, e.g. pushed or spawned off it. Check again before switching back
+	FNavLocation NavFloor;
+	return FindNavFloor(UpdatedComponent->GetComponentLocation(), NavFloor);
+}
+
+void UDreamEatingNavMovementComponent::TickNavMovement(float DeltaTime)
+{
+	bWasAvoidanceUpdated = false;
+
+	// gather movement input the same way the full update would
+	const FVector InputVector = ConsumeInputVector();
+	Acceleration = ScaleInputAcceleration(ConstrainInputAcceleration(InputVector));
+	AnalogInputModifier = ComputeAnalogInputModifier();
+
+	// update the velocity. This applies acceleration, braking, friction and any path following request
+	Velocity.Z = 0.0f;
+	CalcVelocity(DeltaTime, GroundFriction, false, GetMaxBrakingDeceleration());
+
+	if (bUseRVOAvoidance)
+	{
+		CalcAvoidanceVelocity(DeltaTime);
+	}
+
+	// path following requests only last for one tick
+	bHasRequestedVelocity = false;
+	bRequestedMoveWithMaxSpeed = false;
+
+	// turn towards the movement direction
+	PhysicsRotation(DeltaTime);
+
+	// move horizontally
+	const FVector Delta = FVector(Velocity.X, Velocity.Y, 0.0f) * DeltaTime;
+
+	if (!Delta.IsNearlyZero())
+	{
+		FHitResult Hit;
+		SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), bSweepMovement, Hit);
+
+		if (Hit.IsValidBlockingHit())
+		{
+			HandleImpact(Hit, DeltaTime, Delta);
+			SlideAlongSurface(Delta, 1.0f - Hit.Time, Hit.Normal, Hit, true);
+		}
+	}
+
+	// take our height from the navmesh instead of sweeping for the floor.
+	// If we walked off the navmesh, keep the move. The full update takes over next tick and finds the real floor
+	FNavLocation NavFloor;
+	bOnNavMesh = FindNavFloor(UpdatedComponent->GetComponentLocation(), NavFloor);
+
+	if (bOnNavMesh)
+	{
+		FVector NewLocation = UpdatedComponent->GetComponentLocation();
+		NewLocation.Z = NavFloor.Location.Z + CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+		if (bConstrainToPlane)
+		{
+			NewLocation = ConstrainLocationToPlane(NewLocation);
+		}
+
+		UpdatedComponent->SetWorldLocation(NewLocation, false, nullptr, ETeleportType::None);
+	}
+
+	UpdateComponentVelocity();
+
+	if (bUseRVOAvoidance)
+	{
+		UpdateDefaultAvoidance();
+	}
+
+	LastUpdateLocation = UpdatedComponent->GetComponentLocation();
+	LastUpdateRotation = UpdatedComponent->GetComponentQuat();
+	LastUpdateVelocity = Velocity;
+}
@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "DreamEatingNavMovementComponent.generated.h"
+
+/**
+ *  Lightweight movement component for mass-produced AI characters.
+ *  While the owner is on the ground, it skips the full character movement update and
+ *  moves along the navmesh instead: velocity is integrated with the regular acceleration,
+ *  braking and rotation rate settings, and height is taken from the navmesh poly under
+ *  the character, so there are no per-tick floor sweeps.
+ *  Path following, crowd and RVO velocity requests keep working as usual.
+ *  Falls back to the full update for root motion, falling, or when the character leaves the navmesh.
+ */
+UCLASS()
+class UDreamEatingNavMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** If true, horizontal movement is swept so the owner gets blocking hits. Disable for units that already avoid each other */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Nav Movement")
+	bool bSweepMovement = true;
+
+	/** If true, the last nav movement update ended on the navmesh. Otherwise we check for a nav floor before using it again */
+	bool bOnNavMesh = false;
+
+public:
+
+	/** Runs the slim navmesh update, or the full character movement update if we can't */
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Enables or disables sweeping horizontal movement */
+	void SetSweepMovement(bool bSweep) { bSweepMovement = bSweep; }
+
+protected:
+
+	/** Returns true if the slim navmesh update can be used this tick. Requires a nav floor under the owner */
+	bool CanUseNavMovement(float DeltaTime) const;
+
+	/** Returns true if there's a nav floor under the owner, reusing the last update's result while it's still on the navmesh */
+	bool HasNavFloor() const;
+
+	/** Moves the owner along the navmesh */
+	void TickNavMovement(float DeltaTime);
+};
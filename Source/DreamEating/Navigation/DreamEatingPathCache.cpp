@@ -0,0 +1,517 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingPathCache.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "NavMesh/NavMeshPath.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Path Cache Lookup"), STAT_PathCacheLookup, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Cache Hits"), STAT_PathCacheHits, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Cache Misses"), STAT_PathCacheMisses, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Cache Entries"), STAT_PathCacheEntries, STATGROUP_DreamEating);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Cache Hit Rate (%)"), STAT_PathCacheHitRate, STATGROUP_DreamEating);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Cache Time Saved (ms)"), STAT_PathCacheTimeSaved, STATGROUP_DreamEating);
+
+static bool GPathCacheEnabled = true;
+static FAutoConsoleVariableRef CVarPathCacheEnabled(
+	TEXT("DreamEating.PathCache.Enabled"),
+	GPathCacheEnabled,
+	TEXT("If true, unit moves reuse cached path corridors between the same pair of navmesh tiles."),
+	ECVF_Default);
+
+static int32 GPathCacheMaxEntries = 256;
+static FAutoConsoleVariableRef CVarPathCacheMaxEntries(
+	TEXT("DreamEating.PathCache.MaxEntries"),
+	GPathCacheMaxEntries,
+	TEXT("Max number of path corridors kept in the path cache."),
+	ECVF_Default);
+
+/** Casts a ray along the navmesh and collects the polys it crosses. Returns false if it's blocked or starts off the navmesh */
+static bool RaycastPolys(const ANavigationData& NavData, const FVector& RayStart, const FVector& RayEnd, FSharedConstNavQueryFilter QueryFilter, const UObject* Querier, ARecastNavMesh::FRaycastResult& OutResult)
+{
+	FNavLocation StartLocation;
+
+	if (!NavData.ProjectPoint(RayStart, StartLocation, NavData.GetDefaultQueryExtent()))
+	{
+		return false;
+	}
+
+	FVector HitLocation;
+	ARecastNavMesh::NavMeshRaycast(&NavData, StartLocation.NodeRef, RayStart, RayEnd, HitLocation, QueryFilter, Querier, OutResult);
+
+	return !OutResult.HasHit() && OutResult.CorridorPolysCount > 0;
+}
+
+/**
+ *  Builds the poly corridor of a string-pulled path through a cached corridor.
+ *  The rays from our own start and goal to their neighbouring path points give the polys joining them onto the cached polys.
+ *  Returns false if either ray is blocked or doesn't meet the cached corridor
+ */
+static bool StitchCorridor(const ANavigationData& NavData, const TArray<NavNodeRef>& CorridorPolys, const TArray<FNavPathPoint>& PathPoints, FSharedConstNavQueryFilter QueryFilter, const UObject* Querier, TArray<NavNodeRef>& OutPolys)
+{
+	const int32 Last = PathPoints.Num() - 1;
+	ARecastNavMesh::FRaycastResult StartRay;
+
+	if (!RaycastPolys(NavData, PathPoints[0].Location, PathPoints[1].Location, QueryFilter, Querier, StartRay))
+	{
+		return false;
+	}
+
+	// the goal is in plain sight, so the ray's polys are the whole corridor
+	if (Last == 1)
+	{
+		OutPolys.Append(StartRay.CorridorPolys, StartRay.CorridorPolysCount);
+		return true;
+	}
+
+	ARecastNavMesh::FRaycastResult EndRay;
+
+	if (!RaycastPolys(NavData, PathPoints[Last - 1].Location, PathPoints[Last].Location, QueryFilter, Querier, EndRay))
+	{
+		return false;
+	}
+
+	// join the start ray onto the cached corridor at the last poly they share
+	int32 StartRayIndex = StartRay.CorridorPolysCount - 1;
+	int32 StartCorridorIndex = INDEX_NONE;
+
+	for (; StartRayIndex >= 0; --StartRayIndex)
+	{
+		StartCorridorIndex = CorridorPolys.Find(StartRay.CorridorPolys[StartRayIndex]);
+
+		if (StartCorridorIndex != INDEX_NONE)
+		{
+			break;
+		}
+	}
+
+	if (StartCorridorIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// and the end ray at the first poly they share past that
+	int32 EndRayIndex = 0;
+	int32 EndCorridorIndex = INDEX_NONE;
+
+	for (; EndRayIndex < EndRay.CorridorPolysCount; ++EndRayIndex)
+	{
+		const int32 CorridorIndex = CorridorPolys.Find(EndRay.CorridorPolys[EndRayIndex]);
+
+		if (CorridorIndex >= StartCorridorIndex)
+		{
+			EndCorridorIndex = CorridorIndex;
+			break;
+		}
+	}
+
+	if (EndCorridorIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutPolys.Append(StartRay.CorridorPolys, StartRayIndex);
+	OutPolys.Append(&CorridorPolys[StartCorridorIndex], EndCorridorIndex - StartCorridorIndex + 1);
+	OutPolys.Append(&EndRay.CorridorPolys[EndRayIndex + 1], EndRay.CorridorPolysCount - EndRayIndex - 1);
+
+	return true;
+}
+
+bool UDreamEatingPathCache::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingPathCache::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// subscribe to navmesh rebuilds so we can drop stale corridors
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(&InWorld))
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UDreamEatingPathCache::OnNavigationGenerationFinished);
+	}
+}
+
+void UDreamEatingPathCache::Deinitialize()
+{
+	// unsubscribe from the navigation system
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &UDreamEatingPathCache::OnNavigationGenerationFinished);
+	}
+
+	Flush();
+
+	Super::Deinitialize();
+}
+
+bool UDreamEatingPathCache::MakeKey(const ANavigationData& NavData, const FVector& Start, const FVector& Goal, TSubclassOf<UNavigationQueryFilter> FilterClass, FDreamEatingPathCacheKey& OutKey) const
+{
+	if (!GPathCacheEnabled)
+	{
+		return false;
+	}
+
+	// clusters are navmesh tiles, so we need a recast navmesh
+	const ARecastNavMesh* NavMesh = Cast<const ARecastNavMesh>(&NavData);
+
+	if (!NavMesh)
+	{
+		return false;
+	}
+
+	// find the polys under both ends of the path
+	const FVector Extent = NavData.GetDefaultQueryExtent();
+	FNavLocation StartLocation, GoalLocation;
+
+	if (!NavData.ProjectPoint(Start, StartLocation, Extent) || !NavData.ProjectPoint(Goal, GoalLocation, Extent))
+	{
+		return false;
+	}
+
+	if (!NavMesh->GetPolyTileIndex(StartLocation.NodeRef, OutKey.StartCluster) || !NavMesh->GetPolyTileIndex(GoalLocation.NodeRef, OutKey.GoalCluster))
+	{
+		return false;
+	}
+
+	OutKey.FilterClass = FilterClass.Get();
+
+	// paths within a single tile are cheap enough to not be worth caching
+	return OutKey.StartCluster != OutKey.GoalCluster;
+}
+
+FNavPathSharedPtr UDreamEatingPathCache::FindPath(const ANavigationData& NavData, const FDreamEatingPathCacheKey& Key, const FVector& Start, const FVector& Goal, FSharedConstNavQueryFilter QueryFilter, const UObject* Querier)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_PathCacheLookup);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FCacheEntry* Entry = Entries.Find(Key);
+
+	// make sure none of the tiles the corridor crosses were rebuilt since we cached it
+	if (Entry)
+	{
+		const ARecastNavMesh* NavMesh = CachedNavMesh.Get();
+		FVector PolyCenter;
+
+		for (const TPair<uint32, NavNodeRef>& TilePoly : Entry->Corridor->TilePolys)
+		{
+			if (!NavMesh || !NavMesh->GetPolyCenter(TilePoly.Value, PolyCenter))
+			{
+				InvalidateTile(TilePoly.Key);
+				Entry = nullptr;
+				break;
+			}
+		}
+	}
+
+	if (!Entry)
+	{
+		++Misses;
+		UpdateStats();
+
+		return nullptr;
+	}
+
+	Entry->LastUsedFrame = GFrameCounter;
+
+	// replace the corridor's end points with our own
+	const TArray<FNavPathPoint>& CorridorPoints = Entry->Corridor->Points;
+
+	TArray<FNavPathPoint> Candidates;
+	Candidates.Reserve(CorridorPoints.Num());
+	Candidates.Emplace(Start);
+
+	for (int32 Index = 1; Index < CorridorPoints.Num() - 1; ++Index)
+	{
+		Candidates.Add(CorridorPoints[Index]);
+	}
+
+	Candidates.Emplace(Goal);
+
+	// string-pull through the corridor, dropping every corner we can see past
+	TArray<FNavPathPoint> PathPoints;
+	PathPoints.Add(Candidates[0]);
+
+	int32 Anchor = 0;
+	FVector HitLocation;
+
+	for (int32 Index = 2; Index < Candidates.Num(); ++Index)
+	{
+		if (NavData.Raycast(Candidates[Anchor].Location, Candidates[Index].Location, HitLocation, QueryFilter, Querier))
+		{
+			// blocked, so the previous candidate is a corner
+			Anchor = Index - 1;
+			PathPoints.Add(Candidates[Anchor]);
+		}
+	}
+
+	PathPoints.Add(Candidates.Last());
+
+	// our own end points may not see the corridor. Treat that as a miss and let the caller run a full query.
+	// The rays also give us the polys joining our end points to the shared corridor
+	FNavMeshPath* MeshPath = new FNavMeshPath();
+	FNavPathSharedPtr Path = MakeShareable(MeshPath);
+
+	if (!StitchCorridor(NavData, Entry->Corridor->Polys, PathPoints, QueryFilter, Querier, MeshPath->PathCorridor))
+	{
+		++Misses;
+		UpdateStats();
+
+		return nullptr;
+	}
+
+	// build the unit's own path. Path following components look up the point polys in the corridor
+	PathPoints[0].NodeRef = MeshPath->PathCorridor[0];
+	PathPoints.Last().NodeRef = MeshPath->PathCorridor.Last();
+
+	MeshPath->GetPathPoints() = MoveTemp(PathPoints);
+	MeshPath->PathCorridorCost.SetNumZeroed(MeshPath->PathCorridor.Num());
+	MeshPath->SetNavigationDataUsed(&NavData);
+	MeshPath->SetQuerier(Querier);
+	MeshPath->MarkReady();
+
+	// account for the time we saved over a full query
+	const double LookupTime = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	TimeSaved += FMath::Max(0.0, AverageQueryTime - LookupTime);
+
+	++Hits;
+	UpdateStats();
+
+	return Path;
+}
+
+void UDreamEatingPathCache::StorePath(const FDreamEatingPathCacheKey& Key, FNavPathSharedPtr Path, double QueryTime)
+{
+	// update the query cost estimate
+	if (QueryTime >= 0.0)
+	{
+		AverageQueryTime = AverageQueryTime > 0.0 ? FMath::Lerp(AverageQueryTime, QueryTime, 0.1) : QueryTime;
+	}
+
+	// only cache complete paths
+	if (!GPathCacheEnabled || !Path.IsValid() || !Path->IsValid() || Path->IsPartial())
+	{
+		return;
+	}
+
+	// paths without a poly corridor can't be shared with crowd agents
+	const ARecastNavMesh* NavMesh = Cast<const ARecastNavMesh>(Path->GetNavigationDataUsed());
+	const FNavMeshPath* MeshPath = Path->CastPath<FNavMeshPath>();
+
+	if (!NavMesh || !MeshPath || MeshPath->PathCorridor.IsEmpty())
+	{
+		return;
+	}
+
+	// start over if the navmesh changed
+	if (CachedNavMesh.Get() != NavMesh)
+	{
+		Flush();
+		CachedNavMesh = NavMesh;
+	}
+
+	TSharedRef<FDreamEatingPathCorridor, ESPMode::ThreadSafe> Corridor = MakeShared<FDreamEatingPathCorridor, ESPMode::ThreadSafe>();
+
+	// copy the path points and polys
+	Corridor->Points = Path->GetPathPoints();
+	Corridor->Polys = MeshPath->PathCorridor;
+
+	// record one poly per tile the corridor crosses
+	uint32 TileIndex = 0;
+
+	for (const NavNodeRef PolyRef : MeshPath->PathCorridor)
+	{
+		if (NavMesh->GetPolyTileIndex(PolyRef, TileIndex) && !Corridor->TilePolys.Contains(TileIndex))
+		{
+			Corridor->TilePolys.Add(TileIndex, PolyRef);
+		}
+	}
+
+	// replace any previous entry
+	if (const FCacheEntry* PreviousEntry = Entries.Find(Key))
+	{
+		for (const TPair<uint32, NavNodeRef>& TilePoly : PreviousEntry->Corridor->TilePolys)
+		{
+			TileEntries.RemoveSingle(TilePoly.Key, Key);
+		}
+	}
+
+	FCacheEntry& Entry = Entries.Add(Key);
+	Entry.Corridor = Corridor;
+	Entry.LastUsedFrame = GFrameCounter;
+
+	for (const TPair<uint32, NavNodeRef>& TilePoly : Corridor->TilePolys)
+	{
+		TileEntries.Add(TilePoly.Key, Key);
+	}
+
+	TrimEntries();
+	UpdateStats();
+}
+
+FNavPathSharedPtr UDreamEatingPathCache::FindOrComputePath(const FVector& Start, const FVector& Goal, TSubclassOf<UNavigationQueryFilter> FilterClass, const UObject* Querier, const FNavAgentProperties& AgentProperties)
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	if (!NavSys)
+	{
+		return nullptr;
+	}
+
+	const ANavigationData* NavData = NavSys->GetNavDataForProps(AgentProperties, Start);
+
+	if (!NavData)
+	{
+		return nullptr;
+	}
+
+	FSharedConstNavQueryFilter QueryFilter = UNavigationQueryFilter::GetQueryFilter(*NavData, Querier, FilterClass);
+
+	// try the cache first
+	FDreamEatingPathCacheKey Key;
+	const bool bCacheable = MakeKey(*NavData, Start, Goal, FilterClass, Key);
+
+	if (bCacheable)
+	{
+		if (FNavPathSharedPtr CachedPath = FindPath(*NavData, Key, Start, Goal, QueryFilter, Querier))
+		{
+			return CachedPath;
+		}
+	}
+
+	// run a full query
+	const double StartTime = FPlatformTime::Seconds();
+
+	FPathFindingQuery Query(Querier, *NavData, Start, Goal, QueryFilter);
+	const FPathFindingResult Result = NavSys->FindPathSync(AgentProperties, Query);
+
+	const double QueryTime = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	if (!Result.IsSuccessful())
+	{
+		return nullptr;
+	}
+
+	if (bCacheable)
+	{
+		StorePath(Key, Result.Path, QueryTime);
+	}
+
+	return Result.Path;
+}
+
+void UDreamEatingPathCache::Flush()
+{
+	Entries.Empty();
+	TileEntries.Empty();
+
+	UpdateStats();
+}
+
+void UDreamEatingPathCache::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	const ARecastNavMesh* NavMesh = CachedNavMesh.Get();
+
+	// ignore other navmeshes
+	if (!NavMesh || NavData != NavMesh)
+	{
+		return;
+	}
+
+	// rebuilt tiles get a new salt, so their old poly refs no longer resolve
+	TSet<uint32> StaleTiles;
+	FVector PolyCenter;
+
+	for (const TPair<FDreamEatingPathCacheKey, FCacheEntry>& CurrentEntry : Entries)
+	{
+		for (const TPair<uint32, NavNodeRef>& TilePoly : CurrentEntry.Value.Corridor->TilePolys)
+		{
+			if (!StaleTiles.Contains(TilePoly.Key) && !NavMesh->GetPolyCenter(TilePoly.Value, PolyCenter))
+			{
+				StaleTiles.Add(TilePoly.Key);
+			}
+		}
+	}
+
+	for (const uint32 TileIndex : StaleTiles)
+	{
+		InvalidateTile(TileIndex);
+	}
+
+	if (StaleTiles.Num() > 0)
+	{
+		UE_LOG(LogDreamEating, Verbose, TEXT("Path cache invalidated %d rebuilt tiles"), StaleTiles.Num());
+	}
+
+	UpdateStats();
+}
+
+void UDreamEatingPathCache::InvalidateTile(uint32 TileIndex)
+{
+	// gather the entries crossing this tile
+	TArray<FDreamEatingPathCacheKey> Keys;
+	TileEntries.MultiFind(TileIndex, Keys);
+
+	for (const FDreamEatingPathCacheKey& CurrentKey : Keys)
+	{
+		FCacheEntry RemovedEntry;
+
+		if (Entries.RemoveAndCopyValue(CurrentKey, RemovedEntry))
+		{
+			// unlink the entry from every other tile it crosses
+			for (const TPair<uint32, NavNodeRef>& TilePoly : RemovedEntry.Corridor->TilePolys)
+			{
+				TileEntries.RemoveSingle(TilePoly.Key, CurrentKey);
+			}
+		}
+	}
+
+	TileEntries.Remove(TileIndex);
+}
+
+void UDreamEatingPathCache::TrimEntries()
+{
+	while (Entries.Num() > FMath::Max(GPathCacheMaxEntries, 1))
+	{
+		// find the least recently used entry
+		const FDreamEatingPathCacheKey* OldestKey = nullptr;
+		uint64 OldestFrame = MAX_uint64;
+
+		for (const TPair<FDreamEatingPathCacheKey, FCacheEntry>& CurrentEntry : Entries)
+		{
+			if (CurrentEntry.Value.LastUsedFrame < OldestFrame)
+			{
+				OldestFrame = CurrentEntry.Value.LastUsedFrame;
+				OldestKey = &CurrentEntry.Key;
+			}
+		}
+
+		const FDreamEatingPathCacheKey KeyToRemove = *OldestKey;
+		FCacheEntry RemovedEntry;
+
+		Entries.RemoveAndCopyValue(KeyToRemove, RemovedEntry);
+
+		for (const TPair<uint32, NavNodeRef>& TilePoly : RemovedEntry.Corridor->TilePolys)
+		{
+			TileEntries.RemoveSingle(TilePoly.Key, KeyToRemove);
+		}
+	}
+}
+
+void UDreamEatingPathCache::UpdateStats() const
+{
+	const int32 Lookups = Hits + Misses;
+
+	SET_DWORD_STAT(STAT_PathCacheHits, Hits);
+	SET_DWORD_STAT(STAT_PathCacheMisses, Misses);
+	SET_DWORD_STAT(STAT_PathCacheEntries, Entries.Num());
+	SET_FLOAT_STAT(STAT_PathCacheHitRate, Lookups > 0 ? 100.0f * Hits / Lookups : 0.0f);
+	SET_FLOAT_STAT(STAT_PathCacheTimeSaved, static_cast<float>(TimeSaved));
+}
@@ -0,0 +1,145 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationSystemTypes.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "DreamEatingPathCache.generated.h"
+
+class ANavigationData;
+class ARecastNavMesh;
+
+/**
+ *  Cache key for a path between two navmesh clusters.
+ *  Clusters are navmesh tiles, so every start and goal within the same pair of tiles shares the entry.
+ */
+struct FDreamEatingPathCacheKey
+{
+	/** Tile index of the start poly */
+	uint32 StartCluster = 0;
+
+	/** Tile index of the goal poly */
+	uint32 GoalCluster = 0;
+
+	/** Navigation filter class used to find the path */
+	const UClass* FilterClass = nullptr;
+
+	friend bool operator==(const FDreamEatingPathCacheKey& A, const FDreamEatingPathCacheKey& B)
+	{
+		return A.StartCluster == B.StartCluster && A.GoalCluster == B.GoalCluster && A.FilterClass == B.FilterClass;
+	}
+
+	friend uint32 GetTypeHash(const FDreamEatingPathCacheKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.StartCluster), GetTypeHash(Key.GoalCluster)), GetTypeHash(Key.FilterClass));
+	}
+};
+
+/**
+ *  Immutable path corridor shared between every unit that hits the same cache entry.
+ *  Units string-pull their own start and goal through it locally, and stitch their end polys onto its polys.
+ */
+struct FDreamEatingPathCorridor
+{
+	/** Path points of the original query */
+	TArray<FNavPathPoint> Points;
+
+	/** Navmesh polys of the original query, start to goal */
+	TArray<NavNodeRef> Polys;
+
+	/** One poly ref per tile crossed by the corridor. Used to detect tile rebuilds */
+	TMap<uint32, NavNodeRef> TilePolys;
+};
+
+typedef TSharedPtr<const FDreamEatingPathCorridor, ESPMode::ThreadSafe> FDreamEatingPathCorridorPtr;
+
+/**
+ *  World-wide navigation path cache.
+ *  Stores path corridors keyed by (start tile, goal tile, filter class) so repeated
+ *  orders between the same areas skip A* entirely.
+ *  Entries are dropped when any tile they cross is rebuilt.
+ */
+UCLASS()
+class UDreamEatingPathCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Cached entry */
+	struct FCacheEntry
+	{
+		/** Shared corridor */
+		FDreamEatingPathCorridorPtr Corridor;
+
+		/** Frame counter when this entry was last used */
+		uint64 LastUsedFrame = 0;
+	};
+
+	/** Cached corridors */
+	TMap<FDreamEatingPathCacheKey, FCacheEntry> Entries;
+
+	/** Keys of the entries that cross each tile */
+	TMultiMap<uint32, FDreamEatingPathCacheKey> TileEntries;
+
+	/** Navmesh the cache was built against */
+	TWeakObjectPtr<const ARecastNavMesh> CachedNavMesh;
+
+	/** Number of cache hits */
+	int32 Hits = 0;
+
+	/** Number of cache misses */
+	int32 Misses = 0;
+
+	/** Running average time for a path query to return, sync or async, in milliseconds */
+	double AverageQueryTime = 0.0;
+
+	/** Total estimated time saved by cache hits, in milliseconds */
+	double TimeSaved = 0.0;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Subscribes to navigation rebuild events */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+public:
+
+	/** Builds the cache key for a path between the two locations. Returns false if either end is off the navmesh */
+	bool MakeKey(const ANavigationData& NavData, const FVector& Start, const FVector& Goal, TSubclassOf<UNavigationQueryFilter> FilterClass, FDreamEatingPathCacheKey& OutKey) const;
+
+	/** Looks up a cached corridor and string-pulls a path for the given start and goal through it. Returns an invalid pointer on a miss.
+	 *  Hits are navmesh paths with their own poly corridor, so crowd following accepts them the same as a fresh query result */
+	FNavPathSharedPtr FindPath(const ANavigationData& NavData, const FDreamEatingPathCacheKey& Key, const FVector& Start, const FVector& Goal, FSharedConstNavQueryFilter QueryFilter, const UObject* Querier);
+
+	/** Stores a freshly computed path. Pass how long the query took to return in ms, from submission to result for async queries, or a negative value if unknown */
+	void StorePath(const FDreamEatingPathCacheKey& Key, FNavPathSharedPtr Path, double QueryTime = -1.0);
+
+	/** Finds a path through the cache, running a synchronous query and caching the result on a miss */
+	FNavPathSharedPtr FindOrComputePath(const FVector& Start, const FVector& Goal, TSubclassOf<UNavigationQueryFilter> FilterClass, const UObject* Querier, const FNavAgentProperties& AgentProperties);
+
+	/** Drops every cached entry */
+	void Flush();
+
+protected:
+
+	/** Called when the navigation system finishes rebuilding dirty tiles */
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* NavData);
+
+	/** Removes every entry crossing the given tile */
+	void InvalidateTile(uint32 TileIndex);
+
+	/** Evicts the least recently used entries over the cache budget */
+	void TrimEntries();
+
+	/** Updates the hit rate stats */
+	void UpdateStats() const;
+};
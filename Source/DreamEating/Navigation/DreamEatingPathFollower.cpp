@@ -0,0 +1,189 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingPathFollower.h"
+#include "DreamEatingPathCache.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "Engine/World.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Player Path Follower"), STAT_PlayerPathFollower, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Player Path Refreshes"), STAT_PlayerPathRefreshes, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Player Path Queries"), STAT_PlayerPathQueries, STATGROUP_DreamEating);
+
+UDreamEatingPathFollower::UDreamEatingPathFollower()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	// steer before the pawn's movement consumes its input
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+void UDreamEatingPathFollower::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_PlayerPathFollower);
+	DREAMEATING_PERF_SCOPE(Movement);
+
+	APawn* Pawn = GetControlledPawn();
+
+	if (!IsFollowing() || !Pawn)
+	{
+		return;
+	}
+
+	const FVector Location = Pawn->GetNavAgentLocation();
+
+	// skip the next corner if we can already see past it
+	StringPullCountdown -= DeltaTime;
+
+	if (StringPullCountdown <= 0.0f && CornerIndex + 1 < Corners.Num())
+	{
+		StringPullCountdown = StringPullInterval;
+
+		if (HasLineOfSight(Location, Corners[CornerIndex + 1]))
+		{
+			++CornerIndex;
+		}
+	}
+
+	// move on to the next corner once we're close enough
+	const bool bLastCorner = CornerIndex == Corners.Num() - 1;
+
+	if (FVector::Dist2D(Location, Corners[CornerIndex]) <= (bLastCorner ? GoalAcceptanceRadius : CornerAcceptanceRadius))
+	{
+		if (bLastCorner)
+		{
+			Stop();
+			return;
+		}
+
+		++CornerIndex;
+	}
+
+	Pawn->AddMovementInput((Corners[CornerIndex] - Location).GetSafeNormal2D(), 1.0f, false);
+}
+
+bool UDreamEatingPathFollower::MoveTo(const FVector& Goal)
+{
+	if (!GetControlledPawn())
+	{
+		Stop();
+		return false;
+	}
+
+	// small goal changes keep the corridor we already have
+	if (RefreshGoal(Goal))
+	{
+		INC_DWORD_STAT(STAT_PlayerPathRefreshes);
+		return true;
+	}
+
+	INC_DWORD_STAT(STAT_PlayerPathQueries);
+
+	if (!FindNewPath(Goal))
+	{
+		return false;
+	}
+
+	// we're taking over, so abort any move the controller's path following component is still running
+	if (AController* Controller = Cast<AController>(GetOwner()))
+	{
+		Controller->StopMovement();
+	}
+
+	return true;
+}
+
+void UDreamEatingPathFollower::Stop()
+{
+	Corners.Reset();
+	CornerIndex = 0;
+}
+
+bool UDreamEatingPathFollower::RefreshGoal(const FVector& Goal)
+{
+	if (!IsFollowing() || FVector::DistSquared(Goal, Corners.Last()) > FMath::Square(GoalReuseDistance))
+	{
+		return false;
+	}
+
+	// the last corner before the goal, or the pawn itself if it's already on the last leg
+	const bool bOnLastLeg = CornerIndex >= Corners.Num() - 1;
+	const FVector Anchor = bOnLastLeg ? GetControlledPawn()->GetNavAgentLocation() : Corners[Corners.Num() - 2];
+
+	// the corridor is still good as long as the anchor can see the new goal
+	if (!HasLineOfSight(Anchor, Goal))
+	{
+		return false;
+	}
+
+	Corners.Last() = Goal;
+
+	return true;
+}
+
+bool UDreamEatingPathFollower::FindNewPath(const FVector& Goal)
+{
+	APawn* Pawn = GetControlledPawn();
+	UDreamEatingPathCache* PathCache = GetWorld()->GetSubsystem<UDreamEatingPathCache>();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	// never keep walking the old path towards the old goal
+	if (!PathCache || !NavSys)
+	{
+		Stop();
+		return false;
+	}
+
+	const FVector Start = Pawn->GetNavAgentLocation();
+
+	FNavPathSharedPtr Path = PathCache->FindOrComputePath(Start, Goal, nullptr, GetOwner(), Pawn->GetNavAgentPropertiesRef());
+
+	if (!Path.IsValid() || Path->GetPathPoints().Num() < 2)
+	{
+		Stop();
+		return false;
+	}
+
+	Corners.Reset(Path->GetPathPoints().Num());
+
+	for (const FNavPathPoint& PathPoint : Path->GetPathPoints())
+	{
+		Corners.Add(PathPoint.Location);
+	}
+
+	// the first point is where we're standing
+	CornerIndex = 1;
+	StringPullCountdown = 0.0f;
+	PathNavData = NavSys->GetNavDataForProps(Pawn->GetNavAgentPropertiesRef(), Start);
+
+	return true;
+}
+
+bool UDreamEatingPathFollower::HasLineOfSight(const FVector& From, const FVector& To) const
+{
+	const ANavigationData* NavData = PathNavData.Get();
+
+	if (!NavData)
+	{
+		return false;
+	}
+
+	// navmesh raycasts return true when they hit a boundary
+	FVector HitLocation;
+
+	return !NavData->Raycast(From, To, HitLocation, NavData->GetDefaultQueryFilter(), GetOwner());
+}
+
+APawn* UDreamEatingPathFollower::GetControlledPawn() const
+{
+	const AController* Controller = Cast<AController>(GetOwner());
+
+	return Controller ? Controller->GetPawn() : nullptr;
+}
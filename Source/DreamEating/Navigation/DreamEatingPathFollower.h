@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "NavigationSystemTypes.h"
+#include "DreamEatingPathFollower.generated.h"
+
+class AController;
+class APawn;
+class ANavigationData;
+
+/**
+ *  Lightweight path follower for player controlled pawns.
+ *  Steers the controller's pawn along a path corridor with movement input, so held and
+ *  clicked moves share the same follower and can retarget without stopping.
+ *  Small goal changes reuse the remaining corridor, and corners are string-pulled
+ *  locally as the pawn gains line of sight past them.
+ */
+UCLASS(ClassGroup=(Navigation), meta=(BlueprintSpawnableComponent))
+class UDreamEatingPathFollower : public UActorComponent
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Goal changes within this distance try to reuse the current corridor instead of finding a new path */
+	UPROPERTY(EditAnywhere, Category="Path Following", meta = (ClampMin = 0, Units = "cm"))
+	float GoalReuseDistance = 300.0f;
+
+	/** Distance to an intermediate corner at which the pawn moves on to the next one */
+	UPROPERTY(EditAnywhere, Category="Path Following", meta = (ClampMin = 0, Units = "cm"))
+	float CornerAcceptanceRadius = 50.0f;
+
+	/** Distance to the goal at which the move is complete */
+	UPROPERTY(EditAnywhere, Category="Path Following", meta = (ClampMin = 0, Units = "cm"))
+	float GoalAcceptanceRadius = 25.0f;
+
+	/** Time between attempts to string-pull past the next corner */
+	UPROPERTY(EditAnywhere, Category="Path Following", meta = (ClampMin = 0, Units = "s"))
+	float StringPullInterval = 0.1f;
+
+	/** Corners of the path being followed */
+	TArray<FVector> Corners;
+
+	/** Index of the corner the pawn is moving towards */
+	int32 CornerIndex = 0;
+
+	/** Navigation data the path was found on */
+	TWeakObjectPtr<const ANavigationData> PathNavData;
+
+	/** Time left until the next string-pull attempt */
+	float StringPullCountdown = 0.0f;
+
+public:
+
+	/** Constructor */
+	UDreamEatingPathFollower();
+
+	/** Steers the pawn along the path */
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+public:
+
+	/** Moves to the given goal, reusing the current corridor if the goal only moved a little, and aborts any other path following move. Stops and returns false if no path was found */
+	bool MoveTo(const FVector& Goal);
+
+	/** Stops following the current path */
+	void Stop();
+
+	/** Returns true if a path is being followed */
+	bool IsFollowing() const { return Corners.Num() > 0; }
+
+	/** Returns the goal of the current path */
+	FVector GetGoal() const { return Corners.Num() > 0 ? Corners.Last() : FVector::ZeroVector; }
+
+protected:
+
+	/** Tries to retarget the current corridor to a nearby goal. Returns false if a new path is needed */
+	bool RefreshGoal(const FVector& Goal);
+
+	/** Finds a new path to the goal through the path cache */
+	bool FindNewPath(const FVector& Goal);
+
+	/** Returns true if there's a clear line on the navmesh between the two locations */
+	bool HasLineOfSight(const FVector& From, const FVector& To) const;
+
+	/** Returns the pawn being steered */
+	APawn* GetControlledPawn() const;
+};
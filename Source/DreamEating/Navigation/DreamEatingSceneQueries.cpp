@@ -0,0 +1,195 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingSceneQueries.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Scene Query Immediate"), STAT_SceneQueryImmediate, STATGROUP_DreamEating);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scene Queries Immediate"), STAT_SceneQueriesImmediate, STATGROUP_DreamEating);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scene Queries Async"), STAT_SceneQueriesAsync, STATGROUP_DreamEating);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Scene Query Time Saved (ms)"), STAT_SceneQueryTimeSaved, STATGROUP_DreamEating);
+
+static bool GSceneQueriesAsync = true;
+static FAutoConsoleVariableRef CVarSceneQueriesAsync(
+	TEXT("DreamEating.SceneQueries.Async"),
+	GSceneQueriesAsync,
+	TEXT("If true, gameplay traces that tolerate a frame of latency run through the async trace system. Otherwise every trace runs immediately."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdSceneQueriesReport(
+	TEXT("DreamEating.SceneQueries.Report"),
+	TEXT("Logs the number of immediate and async gameplay traces issued, and the estimated game thread time saved."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UDreamEatingSceneQueries* SceneQueries = World ? World->GetSubsystem<UDreamEatingSceneQueries>() : nullptr)
+		{
+			SceneQueries->LogReport();
+		}
+	}));
+
+bool UDreamEatingSceneQueries::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingSceneQueries::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &UDreamEatingSceneQueries::OnAsyncTraceFinished);
+}
+
+void UDreamEatingSceneQueries::Deinitialize()
+{
+	TraceDelegate.Unbind();
+	PendingQueries.Empty();
+
+	Super::Deinitialize();
+}
+
+void UDreamEatingSceneQueries::Tick(float DeltaTime)
+{
+	// async traces save roughly what they would have cost on the game thread
+	const double TimeSaved = AsyncThisFrame * AverageImmediateCost;
+
+	SET_FLOAT_STAT(STAT_SceneQueryTimeSaved, TimeSaved * 1000.0);
+
+	TotalTimeSaved += TimeSaved;
+	AsyncThisFrame = 0;
+}
+
+TStatId UDreamEatingSceneQueries::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDreamEatingSceneQueries, STATGROUP_Tickables);
+}
+
+void UDreamEatingSceneQueries::LineTraceByChannel(EDreamEatingQueryLatency Latency, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, FDreamEatingQueryDelegate Delegate)
+{
+	if (Latency == EDreamEatingQueryLatency::NextFrame && GSceneQueriesAsync)
+	{
+		const uint32 QueryID = AddPendingQuery(MoveTemp(Delegate));
+
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, TraceChannel, Params, FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, QueryID);
+		return;
+	}
+
+	FHitResult OutHit;
+	bool bHit = false;
+
+	{
+		DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_SceneQueryImmediate);
+
+		const double StartTime = FPlatformTime::Seconds();
+		bHit = GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, TraceChannel, Params);
+		RecordImmediate(StartTime);
+	}
+
+	Delegate.ExecuteIfBound(bHit, OutHit);
+}
+
+void UDreamEatingSceneQueries::SweepByObjectType(EDreamEatingQueryLatency Latency, const FVector& Start, const FVector& End, const FCollisionObjectQueryParams& ObjectParams, const FCollisionShape& Shape, const FCollisionQueryParams& Params, FDreamEatingQueryDelegate Delegate)
+{
+	if (Latency == EDreamEatingQueryLatency::NextFrame && GSceneQueriesAsync)
+	{
+		const uint32 QueryID = AddPendingQuery(MoveTemp(Delegate));
+
+		GetWorld()->AsyncSweepByObjectType(EAsyncTraceType::Single, Start, End, FQuat::Identity, ObjectParams, Shape, Params, &TraceDelegate, QueryID);
+		return;
+	}
+
+	FHitResult OutHit;
+	bool bHit = false;
+
+	{
+		DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_SceneQueryImmediate);
+
+		const double StartTime = FPlatformTime::Seconds();
+		bHit = GetWorld()->SweepSingleByObjectType(OutHit, Start, End, FQuat::Identity, ObjectParams, Shape, Params);
+		RecordImmediate(StartTime);
+	}
+
+	Delegate.ExecuteIfBound(bHit, OutHit);
+}
+
+bool UDreamEatingSceneQueries::TraceUnderScreenPosition(EDreamEatingQueryLatency Latency, const APlayerController* PlayerController, const FVector2D& ScreenPosition, ECollisionChannel TraceChannel, bool bTraceComplex, FDreamEatingQueryDelegate Delegate)
+{
+	FVector WorldOrigin, WorldDirection;
+
+	if (!PlayerController || !PlayerController->DeprojectScreenPositionToWorld(ScreenPosition.X, ScreenPosition.Y, WorldOrigin, WorldDirection))
+	{
+		return false;
+	}
+
+	// match the player controller's own screen position traces
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(DreamEatingScreenTrace), bTraceComplex);
+
+	LineTraceByChannel(Latency, WorldOrigin, WorldOrigin + WorldDirection * PlayerController->HitResultTraceDistance, TraceChannel, Params, MoveTemp(Delegate));
+
+	return true;
+}
+
+bool UDreamEatingSceneQueries::TraceUnderCursor(EDreamEatingQueryLatency Latency, const APlayerController* PlayerController, ECollisionChannel TraceChannel, bool bTraceComplex, FDreamEatingQueryDelegate Delegate)
+{
+	float MouseX, MouseY;
+
+	if (!PlayerController || !PlayerController->GetMousePosition(MouseX, MouseY))
+	{
+		return false;
+	}
+
+	return TraceUnderScreenPosition(Latency, PlayerController, FVector2D(MouseX, MouseY), TraceChannel, bTraceComplex, MoveTemp(Delegate));
+}
+
+void UDreamEatingSceneQueries::LogReport() const
+{
+	UE_LOG(LogDreamEating, Display, TEXT("Scene queries: %lld immediate, %lld async, %.2f us average immediate cost, %.2f ms game thread time saved"),
+		TotalImmediate, TotalAsync, AverageImmediateCost * 1000000.0, TotalTimeSaved * 1000.0);
+}
+
+uint32 UDreamEatingSceneQueries::AddPendingQuery(FDreamEatingQueryDelegate&& Delegate)
+{
+	INC_DWORD_STAT(STAT_SceneQueriesAsync);
+
+	++AsyncThisFrame;
+	++TotalAsync;
+
+	// skip zero so a default user data value never matches a request
+	if (++LastQueryID == 0)
+	{
+		++LastQueryID;
+	}
+
+	PendingQueries.Add(LastQueryID, MoveTemp(Delegate));
+
+	return LastQueryID;
+}
+
+void UDreamEatingSceneQueries::RecordImmediate(double StartTime)
+{
+	INC_DWORD_STAT(STAT_SceneQueriesImmediate);
+
+	++TotalImmediate;
+
+	// exponential moving average, seeded with the first sample
+	const double Cost = FPlatformTime::Seconds() - StartTime;
+	AverageImmediateCost = TotalImmediate == 1 ? Cost : FMath::Lerp(AverageImmediateCost, Cost, 0.05);
+}
+
+void UDreamEatingSceneQueries::OnAsyncTraceFinished(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	FDreamEatingQueryDelegate Delegate;
+
+	if (!PendingQueries.RemoveAndCopyValue(Datum.UserData, Delegate))
+	{
+		return;
+	}
+
+	// single traces return at most one hit, which may be an overlap
+	const FHitResult* OutHit = Datum.OutHits.Num() > 0 ? &Datum.OutHits[0] : nullptr;
+	const bool bHit = OutHit && OutHit->bBlockingHit;
+
+	Delegate.ExecuteIfBound(bHit, OutHit ? *OutHit : FHitResult());
+}
@@ -0,0 +1,109 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "DreamEatingSceneQueries.generated.h"
+
+class APlayerController;
+
+/**
+ *  How long a gameplay trace is allowed to take before its result is delivered
+ */
+enum class EDreamEatingQueryLatency : uint8
+{
+	/** Runs on the game thread and delivers the result right away. For inputs that must respond this frame */
+	Immediate,
+
+	/** Batched into the async trace system and delivered at the start of the next frame */
+	NextFrame
+};
+
+/** Delivers the result of a gameplay trace */
+DECLARE_DELEGATE_TwoParams(FDreamEatingQueryDelegate, bool /*bBlockingHit*/, const FHitResult& /*Hit*/);
+
+/**
+ *  Scene query service for gameplay traces.
+ *  Each request carries a latency class: immediate requests run synchronously, while requests that
+ *  tolerate a frame of delay are handed to the world's async trace batch and delivered next frame.
+ *  Tracks how many traces of each class were issued and how much game thread time the async ones saved.
+ */
+UCLASS()
+class UDreamEatingSceneQueries : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Delegates waiting for async results, keyed by request ID */
+	TMap<uint32, FDreamEatingQueryDelegate> PendingQueries;
+
+	/** Delegate passed to the async trace system */
+	FTraceDelegate TraceDelegate;
+
+	/** ID of the last async request */
+	uint32 LastQueryID = 0;
+
+	/** Running average cost of an immediate trace, in seconds. Used to estimate the time async traces save */
+	double AverageImmediateCost = 0.0;
+
+	/** Number of async traces issued this frame */
+	int32 AsyncThisFrame = 0;
+
+	/** Total number of immediate traces issued */
+	int64 TotalImmediate = 0;
+
+	/** Total number of async traces issued */
+	int64 TotalAsync = 0;
+
+	/** Total estimated game thread time saved by async traces, in seconds */
+	double TotalTimeSaved = 0.0;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Initialization */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+	/** Updates the per-frame stats */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Traces a line against the given channel */
+	void LineTraceByChannel(EDreamEatingQueryLatency Latency, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, FDreamEatingQueryDelegate Delegate);
+
+	/** Sweeps a shape against the given object types */
+	void SweepByObjectType(EDreamEatingQueryLatency Latency, const FVector& Start, const FVector& End, const FCollisionObjectQueryParams& ObjectParams, const FCollisionShape& Shape, const FCollisionQueryParams& Params, FDreamEatingQueryDelegate Delegate);
+
+	/** Traces from a screen position into the world, the same way the player controller's hit result queries do. Returns false if the position couldn't be deprojected */
+	bool TraceUnderScreenPosition(EDreamEatingQueryLatency Latency, const APlayerController* PlayerController, const FVector2D& ScreenPosition, ECollisionChannel TraceChannel, bool bTraceComplex, FDreamEatingQueryDelegate Delegate);
+
+	/** Traces from the mouse cursor into the world. Returns false if there's no cursor */
+	bool TraceUnderCursor(EDreamEatingQueryLatency Latency, const APlayerController* PlayerController, ECollisionChannel TraceChannel, bool bTraceComplex, FDreamEatingQueryDelegate Delegate);
+
+	/** Logs the total trace counts and estimated game thread time saved */
+	void LogReport() const;
+
+protected:
+
+	/** Registers a delegate for an async request and returns its ID */
+	uint32 AddPendingQuery(FDreamEatingQueryDelegate&& Delegate);
+
+	/** Records the cost of an immediate trace */
+	void RecordImmediate(double StartTime);
+
+	/** Called by the async trace system when a batched trace finishes */
+	void OnAsyncTraceFinished(const FTraceHandle& Handle, FTraceDatum& Datum);
+};
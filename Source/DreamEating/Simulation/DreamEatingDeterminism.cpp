@@ -0,0 +1,249 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingDeterminism.h"
+#include "GameFramework/Actor.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Determinism State Hash"), STAT_DeterminismStateHash, STATGROUP_DreamEating);
+
+static bool GDeterminismEnabled = false;
+static FAutoConsoleVariableRef CVarDeterminismEnabled(
+	TEXT("DreamEating.Determinism.Enabled"),
+	GDeterminismEnabled,
+	TEXT("If true, worlds run in deterministic mode with a fixed simulation step, seeded random streams and per-frame state hashes. Read when a world starts. Also enabled by -Deterministic."),
+	ECVF_Default);
+
+static int32 GDeterminismSeed = 1337;
+static FAutoConsoleVariableRef CVarDeterminismSeed(
+	TEXT("DreamEating.Determinism.Seed"),
+	GDeterminismSeed,
+	TEXT("Seed for the random streams in deterministic mode. Read when a world starts. Also set by -DeterministicSeed=N."),
+	ECVF_Default);
+
+static float GDeterminismStepRate = 60.0f;
+static FAutoConsoleVariableRef CVarDeterminismStepRate(
+	TEXT("DreamEating.Determinism.StepRate"),
+	GDeterminismStepRate,
+	TEXT("Simulation steps per second in deterministic mode. Every frame advances the game by exactly one step, however long it took to render."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdDeterminismSaveHashes(
+	TEXT("DreamEating.Determinism.SaveHashes"),
+	TEXT("Writes the state hash of every frame so far. Usage: DreamEating.Determinism.SaveHashes [Path]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UDreamEatingDeterminism* Determinism = World ? World->GetSubsystem<UDreamEatingDeterminism>() : nullptr)
+		{
+			const FString Path = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("Determinism") / FString::Printf(TEXT("%s-%d.txt"), *World->GetMapName(), Determinism->GetSeed());
+
+			if (Determinism->SaveFrameHashes(Path))
+			{
+				UE_LOG(LogDreamEating, Display, TEXT("Wrote %d frame hashes to %s"), Determinism->GetFrameHashes().Num(), *FPaths::ConvertRelativePathToFull(Path));
+			}
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdDeterminismCompareHashes(
+	TEXT("DreamEating.Determinism.CompareHashes"),
+	TEXT("Compares the state hash of every frame so far against a previous run. Usage: DreamEating.Determinism.CompareHashes Path"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() == 0)
+		{
+			UE_LOG(LogDreamEating, Warning, TEXT("Usage: DreamEating.Determinism.CompareHashes Path"));
+			return;
+		}
+
+		if (const UDreamEatingDeterminism* Determinism = World ? World->GetSubsystem<UDreamEatingDeterminism>() : nullptr)
+		{
+			Determinism->CompareFrameHashes(Args[0]);
+		}
+	}));
+
+bool UDreamEatingDeterminism::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingDeterminism::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bDeterministic = GDeterminismEnabled || FParse::Param(FCommandLine::Get(), TEXT("Deterministic"));
+
+	Seed = GDeterminismSeed;
+	FParse::Value(FCommandLine::Get(), TEXT("DeterministicSeed="), Seed);
+
+	if (!bDeterministic)
+	{
+		Seed = FMath::Rand();
+	}
+
+	// derive a separate seed for each stream
+	for (int32 StreamIndex = 0; StreamIndex < UE_ARRAY_COUNT(Streams); ++StreamIndex)
+	{
+		Streams[StreamIndex].Initialize(static_cast<int32>(HashCombineFast(static_cast<uint32>(Seed), GetTypeHash(StreamIndex))));
+	}
+
+	if (bDeterministic)
+	{
+		// advance the game by a fixed step every frame instead of the measured frame time
+		bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+		PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+
+		FApp::SetUseFixedTimeStep(true);
+		FApp::SetFixedDeltaTime(1.0 / FMath::Max(GDeterminismStepRate, 1.0f));
+
+		UE_LOG(LogDreamEating, Display, TEXT("Deterministic mode: seed %d, %.0f steps per second"), Seed, 1.0 / FApp::GetFixedDeltaTime());
+	}
+}
+
+void UDreamEatingDeterminism::Deinitialize()
+{
+	if (bDeterministic)
+	{
+		FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+		// keep the hashes of every deterministic run so they can be compared later
+		if (FrameHashes.Num() > 0)
+		{
+			const FString Path = FPaths::ProjectSavedDir() / TEXT("Determinism") / FString::Printf(TEXT("%s-%d-%s.txt"), *GetWorld()->GetMapName(), Seed, *FDateTime::Now().ToString());
+
+			if (SaveFrameHashes(Path))
+			{
+				UE_LOG(LogDreamEating, Display, TEXT("Deterministic mode: wrote %d frame hashes to %s"), FrameHashes.Num(), *FPaths::ConvertRelativePathToFull(Path));
+			}
+		}
+	}
+
+	Super::Deinitialize();
+}
+
+void UDreamEatingDeterminism::Tick(float DeltaTime)
+{
+	if (bDeterministic)
+	{
+		FrameHashes.Add(ComputeStateHash());
+	}
+}
+
+TStatId UDreamEatingDeterminism::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDreamEatingDeterminism, STATGROUP_Tickables);
+}
+
+FRandomStream& UDreamEatingDeterminism::GetRandomStream(const UObject* WorldContextObject, EDreamEatingRandomStream Stream)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+
+	if (UDreamEatingDeterminism* Determinism = World ? World->GetSubsystem<UDreamEatingDeterminism>() : nullptr)
+	{
+		return Determinism->Streams[static_cast<int32>(Stream)];
+	}
+
+	// editor and preview worlds don't need to be deterministic
+	static FRandomStream FallbackStream(FMath::Rand());
+	return FallbackStream;
+}
+
+bool UDreamEatingDeterminism::SaveFrameHashes(const FString& Path) const
+{
+	TArray<FString> Lines;
+	Lines.Reserve(FrameHashes.Num());
+
+	for (const uint32 Hash : FrameHashes)
+	{
+		Lines.Add(FString::Printf(TEXT("%08x"), Hash));
+	}
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *Path))
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Could not write frame hashes to %s"), *Path);
+		return false;
+	}
+
+	return true;
+}
+
+void UDreamEatingDeterminism::CompareFrameHashes(const FString& Path) const
+{
+	TArray<FString> Lines;
+
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Path))
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Could not read frame hashes from %s"), *Path);
+		return;
+	}
+
+	const int32 NumFrames = FMath::Min(Lines.Num(), FrameHashes.Num());
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const uint32 Expected = FParse::HexNumber(*Lines[Frame]);
+
+		if (Expected != FrameHashes[Frame])
+		{
+			UE_LOG(LogDreamEating, Warning, TEXT("Determinism: diverged from %s at frame %d (%08x, expected %08x)"), *Path, Frame, FrameHashes[Frame], Expected);
+			return;
+		}
+	}
+
+	UE_LOG(LogDreamEating, Display, TEXT("Determinism: first %d frames match %s"), NumFrames, *Path);
+}
+
+uint32 UDreamEatingDeterminism::ComputeStateHash() const
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_DeterminismStateHash);
+
+	// quantize to a hundredth of a unit so hashes don't depend on the sign of zero
+	auto Quantize = [](const FVector& Vector, uint32 Hash)
+	{
+		const int64 Values[3] = { FMath::RoundToInt64(Vector.X * 100.0), FMath::RoundToInt64(Vector.Y * 100.0), FMath::RoundToInt64(Vector.Z * 100.0) };
+		return FCrc::MemCrc32(Values, sizeof(Values), Hash);
+	};
+
+	// sum the actor hashes so the result doesn't depend on iteration order
+	uint32 StateHash = 0;
+	int32 NumActors = 0;
+
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		const USceneComponent* Root = It->GetRootComponent();
+
+		if (!Root || Root->Mobility != EComponentMobility::Movable)
+		{
+			continue;
+		}
+
+		// spawned actors get their name suffix in spawn order, so it identifies them across runs
+		uint32 ActorHash = GetTypeHash(It->GetFName().GetNumber());
+		ActorHash = Quantize(Root->GetComponentLocation(), ActorHash);
+		ActorHash = Quantize(Root->GetComponentRotation().Euler(), ActorHash);
+		ActorHash = Quantize(Root->GetComponentVelocity(), ActorHash);
+
+		StateHash += ActorHash;
+		++NumActors;
+	}
+
+	StateHash = HashCombineFast(StateHash, GetTypeHash(NumActors));
+
+	// include the streams so extra or missing rolls show up on the frame they happen
+	for (const FRandomStream& Stream : Streams)
+	{
+		StateHash = HashCombineFast(StateHash, GetTypeHash(Stream.GetCurrentSeed()));
+	}
+
+	return StateHash;
+}
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Math/RandomStream.h"
+#include "DreamEatingDeterminism.generated.h"
+
+/**
+ *  Gameplay systems that draw random numbers. Each one gets its own stream,
+ *  so a change in how often one system rolls doesn't shift the results of the others
+ */
+enum class EDreamEatingRandomStream : uint8
+{
+	/** Twin Stick NPC spawn locations and delays */
+	Spawning,
+
+	/** Twin Stick pickup drops */
+	Drops,
+
+	/** Strategy unit scatter around move goals */
+	StrategyScatter,
+
+	Num
+};
+
+/**
+ *  Deterministic simulation mode.
+ *  When enabled at world start, the game advances by a fixed simulation step instead of the measured frame time,
+ *  every random stream is seeded from a single seed, and a hash of the state of every movable actor is recorded each frame.
+ *  Two runs of the same map, seed and input then produce the same hashes, and the first divergent frame points at the bug.
+ *  Enable with -Deterministic [-DeterministicSeed=N] or DreamEating.Determinism.Enabled before loading a map.
+ *  Random streams are available in both modes; outside of deterministic mode they're seeded randomly.
+ */
+UCLASS()
+class UDreamEatingDeterminism : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Random streams, indexed by EDreamEatingRandomStream */
+	FRandomStream Streams[static_cast<int32>(EDreamEatingRandomStream::Num)];
+
+	/** If true, this world runs in deterministic mode */
+	bool bDeterministic = false;
+
+	/** Seed the streams were initialized from */
+	int32 Seed = 0;
+
+	/** Fixed time step setting before deterministic mode was enabled */
+	bool bPreviousUseFixedTimeStep = false;
+
+	/** Fixed delta time before deterministic mode was enabled */
+	double PreviousFixedDeltaTime = 0.0;
+
+	/** State hash of every simulated frame so far */
+	TArray<uint32> FrameHashes;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Seeds the streams and sets up the fixed step */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Restores the time step and writes the frame hashes */
+	virtual void Deinitialize() override;
+
+	/** Records the state hash of the frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Returns the given random stream for the world of the context object. Falls back to a randomly seeded stream if there's no game world */
+	static FRandomStream& GetRandomStream(const UObject* WorldContextObject, EDreamEatingRandomStream Stream);
+
+	/** Returns true if this world runs in deterministic mode */
+	bool IsDeterministic() const { return bDeterministic; }
+
+	/** Returns the seed the streams were initialized from */
+	int32 GetSeed() const { return Seed; }
+
+	/** Returns the state hash of every simulated frame so far */
+	const TArray<uint32>& GetFrameHashes() const { return FrameHashes; }
+
+	/** Writes the frame hashes to a text file, one per line. Returns false if the file couldn't be written */
+	bool SaveFrameHashes(const FString& Path) const;
+
+	/** Compares the frame hashes against a file written by a previous run and logs the first divergent frame */
+	void CompareFrameHashes(const FString& Path) const;
+
+protected:
+
+	/** Hashes the state of every movable actor and the random streams */
+	uint32 ComputeStateHash() const;
+};
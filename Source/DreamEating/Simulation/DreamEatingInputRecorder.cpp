@@ -0,0 +1,700 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingInputRecorder.h"
+#include "DreamEatingBenchmarkReport.h"
+#include "EnhancedInputComponent.h"
+#include "EnhancedInputSubsystems.h"
+#include "EnhancedPlayerInput.h"
+#include "InputAction.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "UnrealClient.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Tasks/Task.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Input Record"), STAT_InputRecord, STATGROUP_DreamEating);
+DECLARE_CYCLE_STAT(TEXT("Input Playback"), STAT_InputPlayback, STATGROUP_DreamEating);
+
+static int32 GInputRecorderFlushSize = 16 * 1024;
+static FAutoConsoleVariableRef CVarInputRecorderFlushSize(
+	TEXT("DreamEating.Input.FlushSize"),
+	GInputRecorderFlushSize,
+	TEXT("Bytes of encoded input to buffer before handing them to the background writer."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdInputRecord(
+	TEXT("DreamEating.Input.Record"),
+	TEXT("Records the local player's input. Usage: DreamEating.Input.Record [Path]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UDreamEatingInputRecorder* Recorder = World ? World->GetSubsystem<UDreamEatingInputRecorder>() : nullptr)
+		{
+			Recorder->StartRecording(Args.Num() > 0 ? Args[0] : FString());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdInputPlay(
+	TEXT("DreamEating.Input.Play"),
+	TEXT("Replays a recorded input stream and reports the frame times. Usage: DreamEating.Input.Play Path"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() == 0)
+		{
+			UE_LOG(LogDreamEating, Warning, TEXT("Usage: DreamEating.Input.Play Path"));
+			return;
+		}
+
+		if (UDreamEatingInputRecorder* Recorder = World ? World->GetSubsystem<UDreamEatingInputRecorder>() : nullptr)
+		{
+			Recorder->StartPlayback(Args[0]);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdInputStop(
+	TEXT("DreamEating.Input.Stop"),
+	TEXT("Stops recording or replaying input."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UDreamEatingInputRecorder* Recorder = World ? World->GetSubsystem<UDreamEatingInputRecorder>() : nullptr)
+		{
+			Recorder->Stop();
+		}
+	}));
+
+/** Stream header */
+static const uint8 InputStreamMagic[4] = { 'D', 'E', 'I', 'R' };
+
+/** Stream format version */
+static constexpr uint8 InputStreamVersion = 1;
+
+/** Record entry code for a new channel definition. Value entries use the channel index plus one */
+static constexpr uint32 InputStreamDefineChannel = 0;
+
+/** Fixed point scale for recorded values */
+static constexpr float InputStreamQuantization = 1024.0f;
+
+/** Appends a variable length unsigned integer, seven bits per byte */
+template<typename AllocatorType>
+static void WriteVarInt(TArray<uint8, AllocatorType>& Bytes, uint32 Value)
+{
+	while (Value >= 0x80)
+	{
+		Bytes.Add(static_cast<uint8>(Value | 0x80));
+		Value >>= 7;
+	}
+
+	Bytes.Add(static_cast<uint8>(Value));
+}
+
+/** Reads a variable length unsigned integer. Returns false if the stream ends first */
+static bool ReadVarInt(const TArray<uint8>& Bytes, int32& Offset, uint32& OutValue)
+{
+	OutValue = 0;
+
+	for (int32 Shift = 0; Shift < 35; Shift += 7)
+	{
+		if (!Bytes.IsValidIndex(Offset))
+		{
+			return false;
+		}
+
+		const uint8 Byte = Bytes[Offset++];
+		OutValue |= static_cast<uint32>(Byte & 0x7f) << Shift;
+
+		if ((Byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Maps signed deltas to unsigned so small negative values stay small */
+static uint32 ZigZagEncode(int32 Value)
+{
+	return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+}
+
+/** Reverses ZigZagEncode */
+static int32 ZigZagDecode(uint32 Value)
+{
+	return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1);
+}
+
+/** Returns the number of components stored for a value type */
+static int32 GetNumComponents(EInputActionValueType ValueType)
+{
+	switch (ValueType)
+	{
+	case EInputActionValueType::Axis2D:
+		return 2;
+	case EInputActionValueType::Axis3D:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+/**
+ *  Appends encoded input to a file from background tasks.
+ *  Every write is chained after the previous one, so chunks land in order without the game thread ever waiting on the disk
+ */
+class FDreamEatingInputStreamWriter : public TSharedFromThis<FDreamEatingInputStreamWriter>
+{
+public:
+
+	/** Constructor */
+	explicit FDreamEatingInputStreamWriter(const FString& InPath)
+		: Path(InPath)
+	{
+	}
+
+	/** Queues a chunk of bytes to be appended */
+	void Write(TArray<uint8>&& Bytes)
+	{
+		LastTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Self = AsShared(), Bytes = MoveTemp(Bytes)]()
+		{
+			if (!Self->Archive)
+			{
+				Self->Archive.Reset(IFileManager::Get().CreateFileWriter(*Self->Path));
+
+				if (!Self->Archive)
+				{
+					UE_LOG(LogDreamEating, Error, TEXT("Input recorder: could not open %s"), *Self->Path);
+					return;
+				}
+			}
+
+			Self->Archive->Serialize(const_cast<uint8*>(Bytes.GetData()), Bytes.Num());
+
+		}, UE::Tasks::Prerequisites(LastTask));
+	}
+
+	/** Queues closing the file once every chunk is written */
+	void Close()
+	{
+		LastTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Self = AsShared()]()
+		{
+			Self->Archive.Reset();
+
+		}, UE::Tasks::Prerequisites(LastTask));
+	}
+
+	/** Waits for every queued write. Only used on shutdown */
+	void Wait()
+	{
+		LastTask.Wait();
+	}
+
+protected:
+
+	/** File being written */
+	FString Path;
+
+	/** Open file. Only touched from the write tasks */
+	TUniquePtr<FArchive> Archive;
+
+	/** Last queued write */
+	UE::Tasks::FTask LastTask;
+};
+
+void FDreamEatingInputPlaybackTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (IsValid(Recorder))
+	{
+		Recorder->TickPlayback();
+	}
+}
+
+FString FDreamEatingInputPlaybackTickFunction::DiagnosticMessage()
+{
+	return TEXT("DreamEatingInputPlayback");
+}
+
+bool UDreamEatingInputRecorder::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingInputRecorder::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	FString ReplayPath;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("InputReplay="), ReplayPath))
+	{
+		StartPlayback(ReplayPath);
+	}
+	else if (FParse::Param(FCommandLine::Get(), TEXT("InputRecord")))
+	{
+		StartRecording(FString());
+	}
+}
+
+void UDreamEatingInputRecorder::Deinitialize()
+{
+	// the recording has to be complete on disk before the world goes away
+	const TSharedPtr<FDreamEatingInputStreamWriter> PendingWriter = Writer;
+
+	Stop();
+
+	if (PendingWriter.IsValid())
+	{
+		PendingWriter->Wait();
+	}
+
+	PlaybackTickFunction.Reset();
+
+	Super::Deinitialize();
+}
+
+void UDreamEatingInputRecorder::Tick(float DeltaTime)
+{
+	// tickables run after the tick groups, so this reads the values the player controller processed this frame.
+	// Playback runs from its own tick function instead, ahead of the player controller
+	if (Mode != EMode::Recording)
+	{
+		return;
+	}
+
+	if (APlayerController* PlayerController = GetPlayerController())
+	{
+		RecordFrame(PlayerController);
+
+		++Frame;
+	}
+}
+
+void UDreamEatingInputRecorder::TickPlayback()
+{
+	if (Mode != EMode::Playing)
+	{
+		return;
+	}
+
+	APlayerController* PlayerController = GetPlayerController();
+
+	if (!PlayerController)
+	{
+		return;
+	}
+
+	// a new player controller only waits for the replay from the next frame on
+	SetPlaybackController(PlayerController);
+
+	PlayFrame(PlayerController);
+
+	++Frame;
+}
+
+void UDreamEatingInputRecorder::SetPlaybackController(APlayerController* PlayerController)
+{
+	if (PlaybackController.Get() == PlayerController)
+	{
+		return;
+	}
+
+	if (APlayerController* PreviousController = PlaybackController.Get())
+	{
+		PreviousController->PrimaryActorTick.RemovePrerequisite(this, *PlaybackTickFunction);
+	}
+
+	PlaybackController = PlayerController;
+
+	if (PlayerController)
+	{
+		PlayerController->PrimaryActorTick.AddPrerequisite(this, *PlaybackTickFunction);
+	}
+}
+
+TStatId UDreamEatingInputRecorder::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDreamEatingInputRecorder, STATGROUP_Tickables);
+}
+
+void UDreamEatingInputRecorder::StartRecording(const FString& Path)
+{
+	Stop();
+
+	const FString RecordingPath = !Path.IsEmpty() ? Path : FPaths::ProjectSavedDir() / TEXT("InputRecordings") / FString::Printf(TEXT("%s-%s.deinput"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+
+	Mode = EMode::Recording;
+	Frame = 0;
+	LastRecordFrame = 0;
+	Channels.Reset();
+	ActionChannels.Reset();
+
+	// the cursor is always the first channel
+	FChannel& Cursor = Channels.AddDefaulted_GetRef();
+	Cursor.ValueType = EInputActionValueType::Axis2D;
+
+	Writer = MakeShared<FDreamEatingInputStreamWriter>(RecordingPath);
+
+	PendingBytes.Reset();
+	PendingBytes.Append(InputStreamMagic, UE_ARRAY_COUNT(InputStreamMagic));
+	PendingBytes.Add(InputStreamVersion);
+
+	UE_LOG(LogDreamEating, Display, TEXT("Input recorder: recording to %s"), *FPaths::ConvertRelativePathToFull(RecordingPath));
+}
+
+void UDreamEatingInputRecorder::StartPlayback(const FString& Path)
+{
+	Stop();
+
+	if (!FFileHelper::LoadFileToArray(PlaybackBytes, *Path))
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Input recorder: could not read %s"), *Path);
+		return;
+	}
+
+	if (PlaybackBytes.Num() < 5 || FMemory::Memcmp(PlaybackBytes.GetData(), InputStreamMagic, UE_ARRAY_COUNT(InputStreamMagic)) != 0 || PlaybackBytes[4] != InputStreamVersion)
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Input recorder: %s is not a version %d input stream"), *Path, InputStreamVersion);
+		PlaybackBytes.Reset();
+		return;
+	}
+
+	Mode = EMode::Playing;
+	Frame = 0;
+	LastRecordFrame = 0;
+	PlaybackOffset = 5;
+	Channels.Reset();
+	ActionChannels.Reset();
+
+	FChannel& Cursor = Channels.AddDefaulted_GetRef();
+	Cursor.ValueType = EInputActionValueType::Axis2D;
+
+	// read the stamp of the first record
+	uint32 FrameDelta = 0;
+	NextPlaybackFrame = ReadVarInt(PlaybackBytes, PlaybackOffset, FrameDelta) ? static_cast<int32>(FrameDelta) : MAX_int32;
+
+	PlaybackReport = MakeUnique<FDreamEatingBenchmarkReport>(TEXT("InputReplay"));
+	PlaybackReport->AddScenario(FPaths::GetBaseFilename(Path));
+
+	// replay before the player controller processes its input, so the recorded values land on the frame they were recorded on.
+	// The tick function is kept allocated once created, since playback can stop from inside it
+	if (!PlaybackTickFunction.IsValid())
+	{
+		PlaybackTickFunction = MakeUnique<FDreamEatingInputPlaybackTickFunction>();
+		PlaybackTickFunction->Recorder = this;
+		PlaybackTickFunction->TickGroup = TG_PrePhysics;
+		PlaybackTickFunction->bCanEverTick = true;
+		PlaybackTickFunction->bStartWithTickEnabled = true;
+	}
+
+	PlaybackTickFunction->RegisterTickFunction(GetWorld()->PersistentLevel);
+	SetPlaybackController(GetPlayerController());
+
+	UE_LOG(LogDreamEating, Display, TEXT("Input recorder: replaying %s (%d bytes)"), *Path, PlaybackBytes.Num());
+}
+
+void UDreamEatingInputRecorder::Stop()
+{
+	if (Mode == EMode::Recording)
+	{
+		// end with an empty record so playback knows how long the session ran
+		WriteVarInt(PendingBytes, Frame - LastRecordFrame);
+		WriteVarInt(PendingBytes, 0);
+
+		Writer->Write(MoveTemp(PendingBytes));
+		Writer->Close();
+		Writer.Reset();
+
+		UE_LOG(LogDreamEating, Display, TEXT("Input recorder: recorded %d frames on %d channels"), Frame, Channels.Num());
+	}
+	else if (Mode == EMode::Playing)
+	{
+		UE_LOG(LogDreamEating, Display, TEXT("Input recorder: replayed %d frames"), Frame);
+
+		PlaybackBytes.Empty();
+		PlaybackReport->Finish();
+		PlaybackReport.Reset();
+
+		SetPlaybackController(nullptr);
+		PlaybackTickFunction->UnRegisterTickFunction();
+	}
+
+	Mode = EMode::Idle;
+}
+
+APlayerController* UDreamEatingInputRecorder::GetPlayerController() const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	return PlayerController && PlayerController->IsLocalController() ? PlayerController : nullptr;
+}
+
+void UDreamEatingInputRecorder::DiscoverActions(APlayerController* PlayerController)
+{
+	const UInputComponent* InputComponents[] = { PlayerController->InputComponent, PlayerController->GetPawn() ? PlayerController->GetPawn()->InputComponent : nullptr };
+
+	for (const UInputComponent* InputComponent : InputComponents)
+	{
+		const UEnhancedInputComponent* EnhancedInput = Cast<UEnhancedInputComponent>(InputComponent);
+
+		if (!EnhancedInput)
+		{
+			continue;
+		}
+
+		for (const TUniquePtr<FEnhancedInputActionEventBinding>& Binding : EnhancedInput->GetActionEventBindings())
+		{
+			const UInputAction* Action = Binding->GetAction();
+
+			if (!Action || ActionChannels.Contains(Action))
+			{
+				continue;
+			}
+
+			ActionChannels.Add(Action, Channels.Num());
+
+			FChannel& Channel = Channels.AddDefaulted_GetRef();
+			Channel.Action = Action;
+			Channel.ValueType = Action->ValueType;
+		}
+	}
+}
+
+void UDreamEatingInputRecorder::RecordFrame(APlayerController* PlayerController)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_InputRecord);
+
+	const UEnhancedPlayerInput* PlayerInput = Cast<UEnhancedPlayerInput>(PlayerController->PlayerInput);
+
+	if (!PlayerInput)
+	{
+		return;
+	}
+
+	// pick up actions bound since the last frame, such as a newly possessed pawn's
+	const int32 FirstNewChannel = Channels.Num();
+	DiscoverActions(PlayerController);
+
+	TArray<uint8, TInlineAllocator<256>> Entries;
+	int32 NumEntries = 0;
+
+	// define the new channels
+	for (int32 ChannelIndex = FirstNewChannel; ChannelIndex < Channels.Num(); ++ChannelIndex)
+	{
+		const FChannel& Channel = Channels[ChannelIndex];
+		const FTCHARToUTF8 ActionPath(*FSoftObjectPath(Channel.Action.Get()).ToString());
+
+		WriteVarInt(Entries, InputStreamDefineChannel);
+		Entries.Add(static_cast<uint8>(Channel.ValueType));
+		WriteVarInt(Entries, ActionPath.Length());
+		Entries.Append(reinterpret_cast<const uint8*>(ActionPath.Get()), ActionPath.Length());
+
+		++NumEntries;
+	}
+
+	// encode the channels that changed as deltas from their last value
+	for (int32 ChannelIndex = 0; ChannelIndex < Channels.Num(); ++ChannelIndex)
+	{
+		FChannel& Channel = Channels[ChannelIndex];
+		FVector Value = FVector::ZeroVector;
+
+		if (ChannelIndex == 0)
+		{
+			float MouseX = 0.0f;
+			float MouseY = 0.0f;
+			PlayerController->GetMousePosition(MouseX, MouseY);
+
+			Value = FVector(MouseX, MouseY, 0.0f);
+		}
+		else if (const UInputAction* Action = Channel.Action.Get())
+		{
+			Value = PlayerInput->GetActionValue(Action).Get<FVector>();
+		}
+
+		const int32 NumComponents = GetNumComponents(Channel.ValueType);
+		int32 Quantized[3];
+		bool bChanged = false;
+
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			Quantized[Component] = FMath::RoundToInt32(Value[Component] * InputStreamQuantization);
+			bChanged |= Quantized[Component] != Channel.Quantized[Component];
+		}
+
+		if (!bChanged)
+		{
+			continue;
+		}
+
+		WriteVarInt(Entries, ChannelIndex + 1);
+
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			WriteVarInt(Entries, ZigZagEncode(Quantized[Component] - Channel.Quantized[Component]));
+			Channel.Quantized[Component] = Quantized[Component];
+		}
+
+		++NumEntries;
+	}
+
+	// frames without changes aren't written at all
+	if (NumEntries > 0)
+	{
+		WriteVarInt(PendingBytes, Frame - LastRecordFrame);
+		WriteVarInt(PendingBytes, NumEntries);
+		PendingBytes.Append(Entries);
+
+		LastRecordFrame = Frame;
+	}
+
+	// hand full chunks to the background writer
+	if (PendingBytes.Num() >= GInputRecorderFlushSize)
+	{
+		Writer->Write(MoveTemp(PendingBytes));
+		PendingBytes.Reset();
+	}
+}
+
+void UDreamEatingInputRecorder::PlayFrame(APlayerController* PlayerController)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_InputPlayback);
+
+	PlaybackReport->GetCurrentScenario()->SampleFrame();
+
+	// apply every record due this frame
+	while (NextPlaybackFrame <= Frame)
+	{
+		if (!ReadRecord())
+		{
+			Stop();
+			return;
+		}
+	}
+
+	// move the cursor to where it was recorded
+	const FChannel& Cursor = Channels[0];
+
+	if (const ULocalPlayer* LocalPlayer = PlayerController->GetLocalPlayer())
+	{
+		if (LocalPlayer->ViewportClient && LocalPlayer->ViewportClient->Viewport)
+		{
+			LocalPlayer->ViewportClient->Viewport->SetMouse(Cursor.Quantized[0] / InputStreamQuantization, Cursor.Quantized[1] / InputStreamQuantization);
+		}
+	}
+
+	UEnhancedInputLocalPlayerSubsystem* InputSubsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer());
+
+	if (!InputSubsystem)
+	{
+		return;
+	}
+
+	// injected input only lasts one frame, so feed every active action again
+	for (int32 ChannelIndex = 1; ChannelIndex < Channels.Num(); ++ChannelIndex)
+	{
+		const FChannel& Channel = Channels[ChannelIndex];
+		const UInputAction* Action = Channel.Action.Get();
+
+		if (!Action || (Channel.Quantized[0] == 0 && Channel.Quantized[1] == 0 && Channel.Quantized[2] == 0))
+		{
+			continue;
+		}
+
+		const FVector Value(Channel.Quantized[0] / InputStreamQuantization, Channel.Quantized[1] / InputStreamQuantization, Channel.Quantized[2] / InputStreamQuantization);
+		InputSubsystem->InjectInputForAction(Action, FInputActionValue(Channel.ValueType, Value));
+	}
+
+	// the last record has been applied
+	if (NextPlaybackFrame == MAX_int32)
+	{
+		Stop();
+	}
+}
+
+bool UDreamEatingInputRecorder::ReadRecord()
+{
+	uint32 NumEntries = 0;
+
+	if (!ReadVarInt(PlaybackBytes, PlaybackOffset, NumEntries))
+	{
+		return false;
+	}
+
+	for (uint32 Entry = 0; Entry < NumEntries; ++Entry)
+	{
+		uint32 Code = 0;
+
+		if (!ReadVarInt(PlaybackBytes, PlaybackOffset, Code))
+		{
+			return false;
+		}
+
+		if (Code == InputStreamDefineChannel)
+		{
+			uint32 PathLength = 0;
+
+			if (!PlaybackBytes.IsValidIndex(PlaybackOffset))
+			{
+				return false;
+			}
+
+			const EInputActionValueType ValueType = static_cast<EInputActionValueType>(PlaybackBytes[PlaybackOffset++]);
+
+			if (!ReadVarInt(PlaybackBytes, PlaybackOffset, PathLength) || PlaybackOffset + static_cast<int32>(PathLength) > PlaybackBytes.Num())
+			{
+				return false;
+			}
+
+			const FString ActionPath(FUTF8ToTCHAR(reinterpret_cast<const UTF8CHAR*>(PlaybackBytes.GetData() + PlaybackOffset), PathLength));
+			PlaybackOffset += PathLength;
+
+			FChannel& Channel = Channels.AddDefaulted_GetRef();
+			Channel.Action = Cast<UInputAction>(FSoftObjectPath(ActionPath).TryLoad());
+			Channel.ValueType = ValueType;
+
+			if (!Channel.Action.IsValid())
+			{
+				UE_LOG(LogDreamEating, Warning, TEXT("Input recorder: recorded action %s no longer exists, its input will be skipped"), *ActionPath);
+			}
+
+			continue;
+		}
+
+		const int32 ChannelIndex = static_cast<int32>(Code) - 1;
+
+		if (!Channels.IsValidIndex(ChannelIndex))
+		{
+			UE_LOG(LogDreamEating, Error, TEXT("Input recorder: stream references undefined channel %d"), ChannelIndex);
+			return false;
+		}
+
+		FChannel& Channel = Channels[ChannelIndex];
+
+		for (int32 Component = 0; Component < GetNumComponents(Channel.ValueType); ++Component)
+		{
+			uint32 Delta = 0;
+
+			if (!ReadVarInt(PlaybackBytes, PlaybackOffset, Delta))
+			{
+				return false;
+			}
+
+			Channel.Quantized[Component] += ZigZagDecode(Delta);
+		}
+	}
+
+	// read the stamp of the next record
+	uint32 FrameDelta = 0;
+	LastRecordFrame = NextPlaybackFrame;
+	NextPlaybackFrame = ReadVarInt(PlaybackBytes, PlaybackOffset, FrameDelta) ? LastRecordFrame + static_cast<int32>(FrameDelta) : MAX_int32;
+
+	return true;
+}
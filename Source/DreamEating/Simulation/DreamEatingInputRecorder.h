@@ -0,0 +1,169 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "InputActionValue.h"
+#include "DreamEatingInputRecorder.generated.h"
+
+class UInputAction;
+class APlayerController;
+class FDreamEatingInputStreamWriter;
+class FDreamEatingBenchmarkReport;
+class UDreamEatingInputRecorder;
+
+/**
+ *  Replays recorded input in the pre-physics tick group, ahead of the player controller's own tick,
+ *  so injected values are processed on the same frame they were recorded on
+ */
+struct FDreamEatingInputPlaybackTickFunction : public FTickFunction
+{
+	/** Recorder doing the replay */
+	UDreamEatingInputRecorder* Recorder = nullptr;
+
+	/** Replays the input for this frame */
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	/** Names the tick function in tick dumps */
+	virtual FString DiagnosticMessage() override;
+};
+
+/**
+ *  Records and replays the first local player's Enhanced Input actions.
+ *  Recording picks up every action bound on the player controller's and possessed pawn's input components,
+ *  so the Twin Stick, Strategy and TopDown bindings are all covered without changes to them.
+ *  Each frame, the action values and cursor position that changed since the last frame are delta encoded into
+ *  a compact binary stream with frame stamps, and written to disk from a background task.
+ *  Playback injects the recorded values back through the Enhanced Input subsystem one frame at a time, before the player
+ *  controller processes its input, and samples the frame times into a benchmark report, so a recorded session can be replayed headlessly
+ *  against a new build. Combine with -Deterministic to make the runs comparable.
+ *  Record with DreamEating.Input.Record or -InputRecord, replay with DreamEating.Input.Play or -InputReplay=Path.
+ */
+UCLASS()
+class UDreamEatingInputRecorder : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	friend FDreamEatingInputPlaybackTickFunction;
+
+protected:
+
+	/** Recorder modes */
+	enum class EMode : uint8
+	{
+		Idle,
+		Recording,
+		Playing
+	};
+
+	/** Recorded input channel, either an action or the cursor position */
+	struct FChannel
+	{
+		/** Recorded action. nullptr for the cursor channel */
+		TWeakObjectPtr<const UInputAction> Action;
+
+		/** Value type of the action */
+		EInputActionValueType ValueType = EInputActionValueType::Boolean;
+
+		/** Last recorded or replayed value, quantized */
+		int32 Quantized[3] = { 0, 0, 0 };
+	};
+
+	/** Current mode */
+	EMode Mode = EMode::Idle;
+
+	/** Recorded channels. The first one is always the cursor position */
+	TArray<FChannel> Channels;
+
+	/** Channel index of each recorded action */
+	TMap<TWeakObjectPtr<const UInputAction>, int32> ActionChannels;
+
+	/** Frames since recording or playback started */
+	int32 Frame = 0;
+
+	/** Frame of the last record written or read */
+	int32 LastRecordFrame = 0;
+
+	/** Encoded records not yet handed to the writer */
+	TArray<uint8> PendingBytes;
+
+	/** Background writer for the stream being recorded */
+	TSharedPtr<FDreamEatingInputStreamWriter> Writer;
+
+	/** Stream being replayed */
+	TArray<uint8> PlaybackBytes;
+
+	/** Read position in the stream being replayed */
+	int32 PlaybackOffset = 0;
+
+	/** Frame of the next record to replay */
+	int32 NextPlaybackFrame = 0;
+
+	/** Report the replay's frame times are written to */
+	TUniquePtr<FDreamEatingBenchmarkReport> PlaybackReport;
+
+	/** Tick function replaying the input. Heap allocated so the registered tick function never moves */
+	TUniquePtr<FDreamEatingInputPlaybackTickFunction> PlaybackTickFunction;
+
+	/** Player controller whose tick waits for the replay */
+	TWeakObjectPtr<APlayerController> PlaybackController;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Starts recording or playback if requested on the command line */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Flushes any recording in progress */
+	virtual void Deinitialize() override;
+
+	/** Records the input for this frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Starts recording to the given file */
+	void StartRecording(const FString& Path);
+
+	/** Starts replaying the given file */
+	void StartPlayback(const FString& Path);
+
+	/** Stops recording or playback */
+	void Stop();
+
+	/** Returns true while recording */
+	bool IsRecording() const { return Mode == EMode::Recording; }
+
+	/** Returns true while replaying */
+	bool IsPlaying() const { return Mode == EMode::Playing; }
+
+protected:
+
+	/** Returns the first local player controller */
+	APlayerController* GetPlayerController() const;
+
+	/** Adds a channel for every bound action not seen yet, and encodes its definition */
+	void DiscoverActions(APlayerController* PlayerController);
+
+	/** Encodes this frame's changed values */
+	void RecordFrame(APlayerController* PlayerController);
+
+	/** Replays the next frame, from the playback tick function */
+	void TickPlayback();
+
+	/** Makes the player controller's tick wait for the playback tick function */
+	void SetPlaybackController(APlayerController* PlayerController);
+
+	/** Decodes and injects every record up to this frame */
+	void PlayFrame(APlayerController* PlayerController);
+
+	/** Decodes a single record from the playback stream. Returns false at the end of the stream */
+	bool ReadRecord();
+};
@@ -0,0 +1,195 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingTickManager.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Aggregated Tick"), STAT_AggregatedTick, STATGROUP_DreamEating);
+DECLARE_CYCLE_STAT(TEXT("Aggregated Tick Parallel"), STAT_AggregatedTickParallel, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Aggregated Tick Instances"), STAT_AggregatedTickInstances, STATGROUP_DreamEating);
+
+static bool GAggregatedTickEnabled = true;
+static FAutoConsoleVariableRef CVarAggregatedTickEnabled(
+	TEXT("DreamEating.Ticks.Aggregated"),
+	GAggregatedTickEnabled,
+	TEXT("If true, opted-in actors are updated in batches by the aggregated tick manager. Only affects actors that begin play afterwards."),
+	ECVF_Default);
+
+static int32 GAggregatedTickParallelThreshold = 64;
+static FAutoConsoleVariableRef CVarAggregatedTickParallelThreshold(
+	TEXT("DreamEating.Ticks.ParallelThreshold"),
+	GAggregatedTickParallelThreshold,
+	TEXT("Minimum batch size before the thread-safe part of an aggregated tick runs in a ParallelFor. 0 always runs it on the game thread."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdAggregatedTickReport(
+	TEXT("DreamEating.Ticks.AggregatedReport"),
+	TEXT("Logs every aggregated tick batch with its class, tick group and instance count."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UDreamEatingTickManager* TickManager = World ? World->GetSubsystem<UDreamEatingTickManager>() : nullptr)
+		{
+			TickManager->LogReport();
+		}
+	}));
+
+void FDreamEatingAggregatedTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_AggregatedTick);
+	DREAMEATING_PERF_SCOPE(AI);
+
+	// instances registered during the update wait for the next frame
+	const int32 NumInstances = Instances.Num();
+
+	bIterating = true;
+
+	// run the thread-safe part first, spread across workers for large batches
+	{
+		DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_AggregatedTickParallel);
+
+		const bool bParallel = GAggregatedTickParallelThreshold > 0 && NumInstances >= GAggregatedTickParallelThreshold;
+
+		ParallelFor(NumInstances, [this, DeltaTime](int32 Index)
+		{
+			Instances[Index]->AggregatedTickParallel(DeltaTime);
+
+		}, !bParallel);
+	}
+
+	for (int32 Index = 0; Index < NumInstances; ++Index)
+	{
+		// skip instances removed by an earlier update in this batch
+		if (FDreamEatingAggregatedTickable* Instance = Instances[Index])
+		{
+			Instance->AggregatedTick(DeltaTime);
+		}
+	}
+
+	bIterating = false;
+
+	if (bNeedsCompaction)
+	{
+		Instances.Remove(nullptr);
+		bNeedsCompaction = false;
+
+		// empty batches stay registered, but stop ticking
+		if (Instances.Num() == 0)
+		{
+			SetTickFunctionEnable(false);
+		}
+	}
+}
+
+FString FDreamEatingAggregatedTickFunction::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("DreamEatingAggregatedTick[%s]"), *GetNameSafe(InstanceClass.Get()));
+}
+
+FName FDreamEatingAggregatedTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return InstanceClass.IsValid() ? InstanceClass->GetFName() : NAME_None;
+}
+
+bool UDreamEatingTickManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDreamEatingTickManager::Deinitialize()
+{
+	for (TPair<TPair<const UClass*, ETickingGroup>, TUniquePtr<FDreamEatingAggregatedTickFunction>>& Pair : Batches)
+	{
+		Pair.Value->UnRegisterTickFunction();
+	}
+
+	Batches.Empty();
+	InstanceBatches.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UDreamEatingTickManager::RegisterActor(AActor* Actor, FDreamEatingAggregatedTickable* Instance)
+{
+	if (!GAggregatedTickEnabled || !Actor || !Instance || InstanceBatches.Contains(Instance))
+	{
+		return false;
+	}
+
+	const ETickingGroup TickGroup = Actor->PrimaryActorTick.TickGroup;
+	TUniquePtr<FDreamEatingAggregatedTickFunction>& Batch = Batches.FindOrAdd(TPair<const UClass*, ETickingGroup>(Actor->GetClass(), TickGroup));
+
+	// the first instance of a class in a tick group creates its tick function
+	if (!Batch.IsValid())
+	{
+		Batch = MakeUnique<FDreamEatingAggregatedTickFunction>();
+		Batch->InstanceClass = Actor->GetClass();
+		Batch->TickGroup = TickGroup;
+		Batch->bCanEverTick = true;
+		Batch->bStartWithTickEnabled = true;
+		Batch->RegisterTickFunction(GetWorld()->PersistentLevel);
+	}
+	else if (Batch->Instances.Num() == 0)
+	{
+		Batch->SetTickFunctionEnable(true);
+	}
+
+	Batch->Instances.Add(Instance);
+	InstanceBatches.Add(Instance, Batch.Get());
+
+	INC_DWORD_STAT(STAT_AggregatedTickInstances);
+
+	// the batch takes over from the actor's own tick
+	Actor->SetActorTickEnabled(false);
+
+	return true;
+}
+
+void UDreamEatingTickManager::Unregister(FDreamEatingAggregatedTickable* Instance)
+{
+	FDreamEatingAggregatedTickFunction* Batch = nullptr;
+
+	if (!InstanceBatches.RemoveAndCopyValue(Instance, Batch))
+	{
+		return;
+	}
+
+	DEC_DWORD_STAT(STAT_AggregatedTickInstances);
+
+	// keep indices stable while the batch is being updated
+	if (Batch->bIterating)
+	{
+		const int32 Index = Batch->Instances.Find(Instance);
+
+		if (Index != INDEX_NONE)
+		{
+			Batch->Instances[Index] = nullptr;
+			Batch->bNeedsCompaction = true;
+		}
+
+		return;
+	}
+
+	Batch->Instances.RemoveSingleSwap(Instance, EAllowShrinking::No);
+
+	// empty batches stay registered, but stop ticking
+	if (Batch->Instances.Num() == 0)
+	{
+		Batch->SetTickFunctionEnable(false);
+	}
+}
+
+void UDreamEatingTickManager::LogReport() const
+{
+	UE_LOG(LogDreamEating, Display, TEXT("Aggregated ticks: %d instances in %d batches"), InstanceBatches.Num(), Batches.Num());
+
+	for (const TPair<TPair<const UClass*, ETickingGroup>, TUniquePtr<FDreamEatingAggregatedTickFunction>>& Pair : Batches)
+	{
+		UE_LOG(LogDreamEating, Display, TEXT("    %5d  %-40s  %s"), Pair.Value->Instances.Num(), *GetNameSafe(Pair.Key.Key), *UEnum::GetValueAsString(Pair.Key.Value));
+	}
+}
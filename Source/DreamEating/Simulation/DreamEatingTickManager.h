@@ -0,0 +1,95 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "DreamEatingTickManager.generated.h"
+
+class AActor;
+
+/**
+ *  Implemented by objects whose per-frame update can be batched with others of the same class
+ */
+class FDreamEatingAggregatedTickable
+{
+public:
+
+	/** Destructor */
+	virtual ~FDreamEatingAggregatedTickable() = default;
+
+	/** Thread-safe part of the update. May run in parallel with other instances, so it must only touch this instance's own data */
+	virtual void AggregatedTickParallel(float DeltaTime) {}
+
+	/** Game thread part of the update. Runs after the parallel part of every instance in the batch */
+	virtual void AggregatedTick(float DeltaTime) = 0;
+};
+
+/**
+ *  Single tick function that updates every registered instance of one class in one tick group
+ */
+struct FDreamEatingAggregatedTickFunction : public FTickFunction
+{
+	/** Registered instances, kept contiguous */
+	TArray<FDreamEatingAggregatedTickable*> Instances;
+
+	/** Class the instances belong to, used for diagnostics */
+	TWeakObjectPtr<UClass> InstanceClass;
+
+	/** If true, the batch is being updated and removals are deferred */
+	bool bIterating = false;
+
+	/** If true, some instances were removed while iterating and left as nullptr */
+	bool bNeedsCompaction = false;
+
+	/** Updates every instance */
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	/** Names the tick function in tick dumps */
+	virtual FString DiagnosticMessage() override;
+
+	/** Names the tick function in the profiler */
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+/**
+ *  Aggregated tick manager.
+ *  Registers one tick function per class and tick group, and updates every opted-in instance from it in contiguous order,
+ *  instead of scheduling hundreds of tiny per-actor tick functions. The thread-safe part of each update can run in a ParallelFor.
+ */
+UCLASS()
+class UDreamEatingTickManager : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Tick functions, keyed by class and tick group. Heap allocated so registered tick functions never move */
+	TMap<TPair<const UClass*, ETickingGroup>, TUniquePtr<FDreamEatingAggregatedTickFunction>> Batches;
+
+	/** Batch each instance is registered in */
+	TMap<FDreamEatingAggregatedTickable*, FDreamEatingAggregatedTickFunction*> InstanceBatches;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+public:
+
+	/**
+	 *  Moves an actor's per-frame update into the batch for its class and tick group, and disables the actor's own tick.
+	 *  Returns false if aggregated ticking is disabled, in which case the actor should keep ticking on its own.
+	 */
+	bool RegisterActor(AActor* Actor, FDreamEatingAggregatedTickable* Instance);
+
+	/** Removes an instance from its batch. Safe to call from inside a batched update */
+	void Unregister(FDreamEatingAggregatedTickable* Instance);
+
+	/** Logs every batch with its class, tick group and instance count */
+	void LogReport() const;
+};
@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyAIController.h"
+#include "Navigation/CrowdFollowingComponent.h"
+#include "Navigation/CrowdManager.h"
+#include "HAL/IConsoleManager.h"
+
+static bool GStrategyCrowdMovement = true;
+static FAutoConsoleVariableRef CVarStrategyCrowdMovement(
+	TEXT("DreamEating.Strategy.CrowdMovement"),
+	GStrategyCrowdMovement,
+	TEXT("If true, Strategy units are simulated by the crowd manager. If false, they use regular path following. Applied when a unit is possessed."),
+	ECVF_Default);
+
+static int32 GStrategyCrowdAvoidanceQuality = 1;
+static FAutoConsoleVariableRef CVarStrategyCrowdAvoidanceQuality(
+	TEXT("DreamEating.Strategy.CrowdAvoidanceQuality"),
+	GStrategyCrowdAvoidanceQuality,
+	TEXT("Crowd avoidance sampling quality for Strategy units, from 0 (Low) to 3 (High). Higher values cost more per agent, per frame."),
+	ECVF_Default);
+
+static float GStrategyCrowdQueryRange = 400.0f;
+static FAutoConsoleVariableRef CVarStrategyCrowdQueryRange(
+	TEXT("DreamEating.Strategy.CrowdQueryRange"),
+	GStrategyCrowdQueryRange,
+	TEXT("Range in cm used by Strategy units to gather crowd neighbours from the proximity grid."),
+	ECVF_Default);
+
+AStrategyAIController::AStrategyAIController(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCrowdFollowingComponent>(TEXT("PathFollowingComponent")))
+{
+}
+
+void AStrategyAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	ApplyCrowdSettings();
+}
+
+void AStrategyAIController::ApplyCrowdSettings()
+{
+	UCrowdFollowingComponent* CrowdComp = Cast<UCrowdFollowingComponent>(GetPathFollowingComponent());
+
+	if (!CrowdComp)
+	{
+		return;
+	}
+
+	// register or unregister with the crowd manager
+	CrowdComp->SetCrowdSimulationState(GStrategyCrowdMovement ? ECrowdSimulationState::Enabled : ECrowdSimulationState::Disabled);
+
+	// set up the per agent avoidance budget
+	CrowdComp->SetCrowdAvoidanceQuality(static_cast<ECrowdAvoidanceQuality::Type>(FMath::Clamp(GStrategyCrowdAvoidanceQuality, 0, 3)));
+	CrowdComp->SetCrowdCollisionQueryRange(GStrategyCrowdQueryRange);
+	CrowdComp->SetCrowdSeparation(true);
+}
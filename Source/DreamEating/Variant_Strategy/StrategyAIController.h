@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "StrategyAIController.generated.h"
+
+/**
+ *  AI Controller for Strategy units.
+ *  Replaces the default path following component with a Detour crowd agent,
+ *  so dense groups steer around each other through the crowd manager's batched update
+ *  instead of pushing through each other with capsule physics.
+ */
+UCLASS()
+class AStrategyAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Constructor */
+	AStrategyAIController(const FObjectInitializer& ObjectInitializer);
+
+protected:
+
+	/** Applies the crowd settings to the possessed unit */
+	virtual void OnPossess(APawn* InPawn) override;
+
+public:
+
+	/** Applies the current crowd console variables to this controller's crowd agent */
+	void ApplyCrowdSettings();
+};
@@ -0,0 +1,546 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyArmyBenchmark.h"
+#include "StrategyUnit.h"
+#include "StrategyUnitRegistry.h"
+#include "StrategyOrderDispatcher.h"
+#include "StrategyPlayerController.h"
+#include "DreamEatingFormation.h"
+#include "NavigationSystem.h"
+#include "Navigation/CrowdManager.h"
+#include "Navigation/CrowdFollowingComponent.h"
+#include "AIController.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "DreamEating.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdStrategyArmyBenchmark(
+	TEXT("DreamEating.Strategy.ArmyBenchmark"),
+	TEXT("Benchmarks selection and move orders on large armies. Runs 50, 500 and 2000 units unless a unit count is given. Usage: DreamEating.Strategy.ArmyBenchmark [Units=All] [Seconds=10]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UStrategyArmyBenchmark* Benchmark = World ? World->GetSubsystem<UStrategyArmyBenchmark>() : nullptr)
+		{
+			const int32 Units = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 0;
+			const float Seconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 10.0f;
+
+			Benchmark->StartBenchmark(Units, Seconds);
+		}
+	}));
+
+/** Time between scripted commands, in seconds */
+static constexpr float ArmyBenchmarkCommandInterval = 0.5f;
+
+/** Time given to a freshly placed army to be possessed and settle before measuring, in seconds */
+static constexpr float ArmyBenchmarkSettleTime = 2.0f;
+
+/** Distance between placed units */
+static constexpr float ArmyBenchmarkSpacing = 150.0f;
+
+/** Random picks tried when looking for an unselected unit to order the selection onto */
+static constexpr int32 ArmyBenchmarkMaxTargetAttempts = 8;
+
+bool UStrategyArmyBenchmark::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStrategyArmyBenchmark::Tick(float DeltaTime)
+{
+	if (Phase == EPhase::Idle)
+	{
+		return;
+	}
+
+	Elapsed += DeltaTime;
+
+	if (Phase == EPhase::Settle)
+	{
+		if (Elapsed >= ArmyBenchmarkSettleTime)
+		{
+			Phase = EPhase::Measure;
+			Elapsed = 0.0f;
+			CommandCountdown = 0.0f;
+
+			const UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>();
+			StartPathQueries = Dispatcher ? Dispatcher->GetTotalPathQueries() : 0;
+			StartInteractions = Dispatcher ? Dispatcher->GetTotalInteractions() : 0;
+			StartCachedPathRejections = Dispatcher ? Dispatcher->GetCachedPathRejections() : 0;
+
+			FDreamEatingBenchmarkScenario& Scenario = Report->AddScenario(FString::Printf(TEXT("Units%d"), Queue[QueueIndex]));
+
+			// units past the crowd manager's MaxAgents fall back to plain path following, which avoids nothing and costs far less
+			const int32 CrowdAgents = CountCrowdAgents();
+			Scenario.SetMetric(TEXT("crowd_agents"), CrowdAgents);
+
+			if (CrowdAgents < Units.Num())
+			{
+				UE_LOG(LogDreamEating, Warning, TEXT("Army benchmark: only %d of %d units are crowd agents, raise [/Script/AIModule.CrowdManager] MaxAgents"), CrowdAgents, Units.Num());
+			}
+		}
+
+		return;
+	}
+
+	FDreamEatingBenchmarkScenario& Scenario = *Report->GetCurrentScenario();
+	Scenario.SampleFrame();
+
+	// count the units still executing an order
+	if (const UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>())
+	{
+		int32 Moving = 0;
+
+		for (const TWeakObjectPtr<AStrategyUnit>& CurrentUnit : Units)
+		{
+			if (CurrentUnit.IsValid() && Dispatcher->IsExecutingOrder(CurrentUnit.Get()))
+			{
+				++Moving;
+			}
+		}
+
+		Scenario.SampleCounter(TEXT("units_moving"), Moving);
+	}
+
+	CommandCountdown -= DeltaTime;
+
+	if (CommandCountdown <= 0.0f)
+	{
+		CommandCountdown += ArmyBenchmarkCommandInterval;
+		RunNextCommand(Scenario);
+	}
+
+	if (Elapsed >= Duration)
+	{
+		FinishRun();
+	}
+}
+
+TStatId UStrategyArmyBenchmark::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStrategyArmyBenchmark, STATGROUP_Tickables);
+}
+
+bool UStrategyArmyBenchmark::StartBenchmark(int32 InNumUnits, float InDuration)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Army benchmark is already running"));
+		return false;
+	}
+
+	// use the first unit in the level as a template
+	TActorIterator<AStrategyUnit> It(GetWorld());
+
+	if (!It)
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Army benchmark needs at least one Strategy unit in the level"));
+		return false;
+	}
+
+	PlayerController = Cast<AStrategyPlayerController>(GetWorld()->GetFirstPlayerController());
+
+	if (!PlayerController.IsValid())
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Army benchmark needs a Strategy player controller"));
+		return false;
+	}
+
+	UnitClass = It->GetClass();
+	Center = It->GetActorLocation();
+	Duration = FMath::Max(InDuration, 1.0f);
+
+	Queue.Reset();
+
+	if (InNumUnits > 0)
+	{
+		Queue.Add(InNumUnits);
+	}
+	else
+	{
+		Queue = { 50, 500, 2000 };
+	}
+
+	QueueIndex = 0;
+	TotalInteractions = 0;
+	TotalCachedPathRejections = 0;
+	RandomStream.Initialize(1337);
+	Report = MakeUnique<FDreamEatingBenchmarkReport>(TEXT("StrategyArmyBenchmark"));
+
+	StartRun();
+
+	return true;
+}
+
+void UStrategyArmyBenchmark::StartRun()
+{
+	Phase = EPhase::Settle;
+	Elapsed = 0.0f;
+	CommandIndex = 0;
+	NumOrders = 0;
+
+	const int32 NumUnits = Queue[QueueIndex];
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// place the army on a square grid centered on the template unit
+	TArray<FVector> Slots;
+	FDreamEatingFormation::MakeGrid(Center, NumUnits, ArmyBenchmarkSpacing, Slots);
+
+	for (FVector SpawnLocation : Slots)
+	{
+		FNavLocation NavLocation;
+
+		if (NavSys && NavSys->ProjectPointToNavigation(SpawnLocation, NavLocation))
+		{
+			SpawnLocation = NavLocation.Location;
+		}
+
+		if (AStrategyUnit* Unit = GetWorld()->SpawnActor<AStrategyUnit>(UnitClass, FTransform(SpawnLocation), SpawnParams))
+		{
+			Units.Add(Unit);
+		}
+	}
+
+	UE_LOG(LogDreamEating, Display, TEXT("Army benchmark: placed %d units"), Units.Num());
+}
+
+int32 UStrategyArmyBenchmark::CountCrowdAgents() const
+{
+	const UCrowdManager* CrowdManager = UCrowdManager::GetCurrent(GetWorld());
+
+	if (!CrowdManager)
+	{
+		return 0;
+	}
+
+	int32 CrowdAgents = 0;
+
+	for (const TWeakObjectPtr<AStrategyUnit>& CurrentUnit : Units)
+	{
+		const AAIController* Controller = CurrentUnit.IsValid() ? Cast<AAIController>(CurrentUnit->GetController()) : nullptr;
+		const UCrowdFollowingComponent* CrowdComp = Controller ? Cast<UCrowdFollowingComponent>(Controller->GetPathFollowingComponent()) : nullptr;
+
+		if (CrowdComp && CrowdManager->IsAgentValid(CrowdComp))
+		{
+			++CrowdAgents;
+		}
+	}
+
+	return CrowdAgents;
+}
+
+void UStrategyArmyBenchmark::FinishRun()
+{
+	FDreamEatingBenchmarkScenario& Scenario = *Report->GetCurrentScenario();
+
+	// the last order is never followed by another command, so record its latencies here
+	if (NumOrders > 0)
+	{
+		SampleOrderLatency(Scenario);
+	}
+
+	const UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>();
+	const int32 PathQueries = Dispatcher ? Dispatcher->GetTotalPathQueries() - StartPathQueries : 0;
+	const int32 Interactions = Dispatcher ? Dispatcher->GetTotalInteractions() - StartInteractions : 0;
+	const int32 CachedPathRejections = Dispatcher ? Dispatcher->GetCachedPathRejections() - StartCachedPathRejections : 0;
+
+	TotalInteractions += Interactions;
+	TotalCachedPathRejections += CachedPathRejections;
+
+	Scenario.SetMetric(TEXT("units"), Units.Num());
+	Scenario.SetMetric(TEXT("orders"), NumOrders);
+	Scenario.SetMetric(TEXT("path_queries"), PathQueries);
+	Scenario.SetMetric(TEXT("path_queries_per_order"), NumOrders > 0 ? static_cast<double>(PathQueries) / NumOrders : 0.0);
+	Scenario.SetMetric(TEXT("interactions"), Interactions);
+	Scenario.SetMetric(TEXT("cached_path_rejections"), CachedPathRejections);
+
+	// clear the selection so the controller doesn't hold on to destroyed units
+	if (PlayerController.IsValid())
+	{
+		PlayerController->DeselectAll();
+	}
+
+	// clean up the units
+	for (const TWeakObjectPtr<AStrategyUnit>& CurrentUnit : Units)
+	{
+		if (CurrentUnit.IsValid())
+		{
+			if (AController* Controller = CurrentUnit->GetController())
+			{
+				Controller->Destroy();
+			}
+
+			CurrentUnit->Destroy();
+		}
+	}
+
+	Units.Reset();
+
+	// move on to the next army size, or write the report
+	if (++QueueIndex < Queue.Num() && PlayerController.IsValid())
+	{
+		StartRun();
+	}
+	else
+	{
+		Phase = EPhase::Idle;
+		Report->Finish();
+		Report.Reset();
+	}
+}
+
+void UStrategyArmyBenchmark::RunNextCommand(FDreamEatingBenchmarkScenario& Scenario)
+{
+	AStrategyPlayerController* Controller = PlayerController.Get();
+
+	if (!Controller)
+	{
+		return;
+	}
+
+	// the first move and path latencies are only final once the previous order has started moving, so record them before the next one
+	if (NumOrders > 0)
+	{
+		SampleOrderLatency(Scenario);
+	}
+
+	// cycle through box select, select all and deselect followed by box select, ordering the selection each time
+	const int32 Step = CommandIndex++ % 4;
+
+	if (Step == 1)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Controller->SelectAllOnScreen();
+		Scenario.SampleCounter(TEXT("select_all_ms"), static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0));
+
+		// units are never rendered in headless runs, so select the whole army the way a drag over it would
+		if (Controller->GetSelectedUnits().Num() == 0)
+		{
+			TArray<AStrategyUnit*> Army;
+			Army.Reserve(Units.Num());
+
+			for (const TWeakObjectPtr<AStrategyUnit>& CurrentUnit : Units)
+			{
+				if (CurrentUnit.IsValid())
+				{
+					Army.Add(CurrentUnit.Get());
+				}
+			}
+
+			const double DragStartTime = FPlatformTime::Seconds();
+			Controller->DragSelectUnits(Army);
+			Scenario.SampleCounter(TEXT("select_all_drag_ms"), static_cast<float>((FPlatformTime::Seconds() - DragStartTime) * 1000.0));
+		}
+	}
+	else
+	{
+		if (Step == 3)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Controller->DeselectAll();
+			Scenario.SampleCounter(TEXT("deselect_ms"), static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0));
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		BoxSelect();
+		Scenario.SampleCounter(TEXT("box_select_ms"), static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0));
+	}
+
+	Scenario.SampleCounter(TEXT("selected_units"), Controller->GetSelectedUnits().Num());
+
+	// order the selection to a random goal, or onto another unit every other order so it interacts on arrival
+	if (Controller->GetSelectedUnits().Num() > 0)
+	{
+		const AStrategyUnit* Target = NumOrders % 2 == 1 ? GetRandomInteractionTarget() : nullptr;
+		const FVector Goal = Target ? Target->GetActorLocation() : GetRandomGoal();
+
+		const double StartTime = FPlatformTime::Seconds();
+		Controller->MoveSelectedUnitsTo(Goal);
+		Scenario.SampleCounter(TEXT("order_dispatch_ms"), static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0));
+
+		++NumOrders;
+	}
+}
+
+void UStrategyArmyBenchmark::SampleOrderLatency(FDreamEatingBenchmarkScenario& Scenario) const
+{
+	const UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>();
+
+	if (!Dispatcher)
+	{
+		return;
+	}
+
+	// skip latencies the last order hasn't reached yet, rather than repeat the previous order's
+	if (!Dispatcher->IsWaitingForFirstMove())
+	{
+		Scenario.SampleCounter(TEXT("first_move_latency_ms"), Dispatcher->GetLastFirstMoveLatency());
+	}
+
+	if (!Dispatcher->IsWaitingForFirstPath())
+	{
+		Scenario.SampleCounter(TEXT("first_path_latency_ms"), Dispatcher->GetLastFirstPathLatency());
+	}
+}
+
+void UStrategyArmyBenchmark::BoxSelect()
+{
+	UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>();
+
+	if (!Registry || !PlayerController.IsValid() || Units.Num() == 0)
+	{
+		return;
+	}
+
+	// pick a box around a random unit, sized to catch a fraction of the army
+	const TWeakObjectPtr<AStrategyUnit>& BoxUnit = Units[RandomStream.RandRange(0, Units.Num() - 1)];
+
+	if (!BoxUnit.IsValid())
+	{
+		return;
+	}
+
+	const FVector BoxCenter = BoxUnit->GetActorLocation();
+	const FVector2D Extent(RandomStream.FRandRange(2.0f, 8.0f) * ArmyBenchmarkSpacing, RandomStream.FRandRange(2.0f, 8.0f) * ArmyBenchmarkSpacing);
+
+	// use the spatial grid for the broad phase, then clip to the box the way the HUD's drag select does
+	TArray<AStrategyUnit*> Candidates;
+	Registry->QueryUnitsInRadius(BoxCenter, Extent.Size(), Candidates);
+
+	TArray<AStrategyUnit*> Selected;
+	Selected.Reserve(Candidates.Num());
+
+	for (AStrategyUnit* Candidate : Candidates)
+	{
+		const FVector Offset = Candidate->GetActorLocation() - BoxCenter;
+
+		if (FMath::Abs(Offset.X) <= Extent.X && FMath::Abs(Offset.Y) <= Extent.Y)
+		{
+			Selected.Add(Candidate);
+		}
+	}
+
+	PlayerController->DragSelectUnits(Selected);
+}
+
+FVector UStrategyArmyBenchmark::GetRandomGoal() const
+{
+	// pick a point around the center from the seeded stream so every run issues the same orders
+	const float Radius = FMath::Max(FMath::Sqrt(static_cast<float>(Units.Num())) * ArmyBenchmarkSpacing, 1000.0f);
+	const FVector Goal = FDreamEatingFormation::SampleDisc(RandomStream, Center, Radius);
+
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		FNavLocation NavLocation;
+
+		if (NavSys->ProjectPointToNavigation(Goal, NavLocation, FVector(500.0f, 500.0f, 1000.0f)))
+		{
+			return NavLocation.Location;
+		}
+	}
+
+	return Goal;
+}
+
+AStrategyUnit* UStrategyArmyBenchmark::GetRandomInteractionTarget()
+{
+	if (!PlayerController.IsValid() || Units.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	const TArray<AStrategyUnit*>& Selected = PlayerController->GetSelectedUnits();
+
+	// a few random picks are enough, the selection rarely covers the whole army
+	for (int32 Attempt = 0; Attempt < ArmyBenchmarkMaxTargetAttempts; ++Attempt)
+	{
+		AStrategyUnit* Candidate = Units[RandomStream.RandRange(0, Units.Num() - 1)].Get();
+
+		if (Candidate && !Selected.Contains(Candidate))
+		{
+			return Candidate;
+		}
+	}
+
+	return nullptr;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Longest time the automation test waits for every army size to finish */
+static constexpr double ArmyBenchmarkTestTimeout = 300.0;
+
+/** Returns the benchmark subsystem of the running game world, if any */
+static UStrategyArmyBenchmark* GetStrategyArmyBenchmark()
+{
+	UWorld* World = AutomationCommon::GetAnyGameWorld();
+	return World ? World->GetSubsystem<UStrategyArmyBenchmark>() : nullptr;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FStartStrategyArmyBenchmarkCommand, FAutomationTestBase*, Test, int32, NumUnits, float, Seconds);
+
+bool FStartStrategyArmyBenchmarkCommand::Update()
+{
+	UStrategyArmyBenchmark* Benchmark = GetStrategyArmyBenchmark();
+
+	if (!Benchmark || !Benchmark->StartBenchmark(NumUnits, Seconds))
+	{
+		Test->AddError(TEXT("Could not start the army benchmark, see the log for details"));
+	}
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FWaitForStrategyArmyBenchmarkCommand, FAutomationTestBase*, Test);
+
+bool FWaitForStrategyArmyBenchmarkCommand::Update()
+{
+	UStrategyArmyBenchmark* Benchmark = GetStrategyArmyBenchmark();
+
+	if (!Benchmark)
+	{
+		return true;
+	}
+
+	if (Benchmark->IsRunning())
+	{
+		if (GetCurrentRunTime() > ArmyBenchmarkTestTimeout)
+		{
+			Test->AddError(TEXT("Army benchmark timed out"));
+			return true;
+		}
+
+		return false;
+	}
+
+	// crowd following must accept every path the cache hands out, and orders onto units must interact on arrival
+	Test->TestEqual(TEXT("Cached paths refused by path following"), Benchmark->GetTotalCachedPathRejections(), 0);
+	Test->TestTrue(TEXT("Orders onto units ran arrival interactions"), Benchmark->GetTotalInteractions() > 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStrategyArmyBenchmarkTest, "DreamEating.Bench.StrategyArmy",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FStrategyArmyBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// run every army size in the Strategy level, the report is written by the benchmark itself
+	AutomationOpenMap(TEXT("/Game/Variant_Strategy/LVL_Strategy"));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.0f));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartStrategyArmyBenchmarkCommand(this, 0, 10.0f));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitForStrategyArmyBenchmarkCommand(this));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,145 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DreamEatingBenchmarkReport.h"
+#include "StrategyArmyBenchmark.generated.h"
+
+class AStrategyUnit;
+class AStrategyPlayerController;
+
+/**
+ *  Army scale benchmark for the Strategy variant.
+ *  For each army size, procedurally places that many units on the navmesh around the first unit in the level,
+ *  then runs a scripted loop of box selections, select all, deselects and move orders through the player controller.
+ *  Every other order targets an unselected unit, so the arrival interactions run too.
+ *  Reports selection and order dispatch cost, click to first movement latency, path query and interaction counts and frame time
+ *  percentiles as JSON through the shared benchmark report, along with how many units the crowd manager took on as agents.
+ *  Run with DreamEating.Strategy.ArmyBenchmark [Units=All] [Seconds=10], or headless through the automation test with
+ *  -game -nullrhi -ExecCmds="Automation RunTests DreamEating.Bench.StrategyArmy; Quit"
+ */
+UCLASS()
+class UStrategyArmyBenchmark : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Benchmark phases */
+	enum class EPhase : uint8
+	{
+		Idle,
+		Settle,
+		Measure
+	};
+
+	/** Current phase */
+	EPhase Phase = EPhase::Idle;
+
+	/** Army sizes queued for this run */
+	TArray<int32> Queue;
+
+	/** Index of the army size being run */
+	int32 QueueIndex = 0;
+
+	/** Report the runs are written to */
+	TUniquePtr<FDreamEatingBenchmarkReport> Report;
+
+	/** Units spawned for the current run */
+	TArray<TWeakObjectPtr<AStrategyUnit>> Units;
+
+	/** Unit class to spawn */
+	TSubclassOf<AStrategyUnit> UnitClass;
+
+	/** Player controller the scripted commands go through */
+	TWeakObjectPtr<AStrategyPlayerController> PlayerController;
+
+	/** Center of the army */
+	FVector Center = FVector::ZeroVector;
+
+	/** Random stream for selection boxes and order goals */
+	FRandomStream RandomStream;
+
+	/** Duration of each measured run, in seconds */
+	float Duration = 10.0f;
+
+	/** Time elapsed in the current phase */
+	float Elapsed = 0.0f;
+
+	/** Time until the next scripted command */
+	float CommandCountdown = 0.0f;
+
+	/** Number of scripted commands issued in the current run */
+	int32 CommandIndex = 0;
+
+	/** Number of orders issued in the current run */
+	int32 NumOrders = 0;
+
+	/** Path queries submitted before the current run started */
+	int32 StartPathQueries = 0;
+
+	/** Arrival interactions before the current run started */
+	int32 StartInteractions = 0;
+
+	/** Cached path rejections before the current run started */
+	int32 StartCachedPathRejections = 0;
+
+	/** Arrival interactions over every run of the benchmark */
+	int32 TotalInteractions = 0;
+
+	/** Cached path rejections over every run of the benchmark */
+	int32 TotalCachedPathRejections = 0;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Runs the scripted commands and samples the current run */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Starts the benchmark for the default army sizes, or only the given one. Returns false if it couldn't start */
+	bool StartBenchmark(int32 InNumUnits, float InDuration);
+
+	/** Returns true while the benchmark is running */
+	bool IsRunning() const { return Phase != EPhase::Idle; }
+
+	/** Returns the number of arrival interactions over every run of the last benchmark */
+	int32 GetTotalInteractions() const { return TotalInteractions; }
+
+	/** Returns the number of cached paths refused over every run of the last benchmark */
+	int32 GetTotalCachedPathRejections() const { return TotalCachedPathRejections; }
+
+protected:
+
+	/** Places the army for the current run */
+	void StartRun();
+
+	/** Records the results of the current run, cleans up its units and moves on */
+	void FinishRun();
+
+	/** Returns the number of placed units registered as crowd agents */
+	int32 CountCrowdAgents() const;
+
+	/** Issues the next scripted selection and order commands */
+	void RunNextCommand(FDreamEatingBenchmarkScenario& Scenario);
+
+	/** Records the first move and path latencies of the last order, once they're in */
+	void SampleOrderLatency(FDreamEatingBenchmarkScenario& Scenario) const;
+
+	/** Selects every benchmark unit inside a random world space box */
+	void BoxSelect();
+
+	/** Returns a random navigable goal around the army's center */
+	FVector GetRandomGoal() const;
+
+	/** Returns a random benchmark unit outside the selection to order the selection onto, if any */
+	AStrategyUnit* GetRandomInteractionTarget();
+};
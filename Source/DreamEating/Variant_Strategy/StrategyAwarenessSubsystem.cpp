@@ -0,0 +1,233 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyAwarenessSubsystem.h"
+#include "StrategyUnit.h"
+#include "StrategyUnitRegistry.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Awareness Scan"), STAT_StrategyAwarenessScan, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Awareness Units Scanned"), STAT_StrategyAwarenessScanned, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Awareness Events"), STAT_StrategyAwarenessEvents, STATGROUP_DreamEating);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Awareness Max Staleness (ms)"), STAT_StrategyAwarenessStaleness, STATGROUP_DreamEating);
+
+static float GStrategyAwarenessBudget = 200.0f;
+static FAutoConsoleVariableRef CVarStrategyAwarenessBudget(
+	TEXT("DreamEating.Strategy.AwarenessBudgetUs"),
+	GStrategyAwarenessBudget,
+	TEXT("Per-frame time budget in microseconds for the Strategy unit awareness scanner."),
+	ECVF_Default);
+
+static float GStrategyAwarenessMaxStaleness = 0.5f;
+static FAutoConsoleVariableRef CVarStrategyAwarenessMaxStaleness(
+	TEXT("DreamEating.Strategy.AwarenessMaxStaleness"),
+	GStrategyAwarenessMaxStaleness,
+	TEXT("Max time in seconds between two awareness scans of the same unit. Overrides the time budget when needed."),
+	ECVF_Default);
+
+static int32 GStrategyAwarenessUnitsPerFrame = 128;
+static FAutoConsoleVariableRef CVarStrategyAwarenessUnitsPerFrame(
+	TEXT("DreamEating.Strategy.AwarenessUnitsPerFrame"),
+	GStrategyAwarenessUnitsPerFrame,
+	TEXT("Max number of units the awareness scanner checks per frame once the staleness guarantee is met."),
+	ECVF_Default);
+
+bool UStrategyAwarenessSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStrategyAwarenessSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// the scan cursor indexes into the registry, so follow its removals
+	UStrategyUnitRegistry* Registry = Collection.InitializeDependency<UStrategyUnitRegistry>();
+
+	if (Registry)
+	{
+		UnitRemovedHandle = Registry->OnUnitRemoved.AddUObject(this, &UStrategyAwarenessSubsystem::OnUnitRemoved);
+	}
+}
+
+void UStrategyAwarenessSubsystem::Deinitialize()
+{
+	if (UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>())
+	{
+		Registry->OnUnitRemoved.Remove(UnitRemovedHandle);
+	}
+
+	States.Empty();
+	PendingEvents.Empty();
+
+	Super::Deinitialize();
+}
+
+void UStrategyAwarenessSubsystem::Tick(float DeltaTime)
+{
+	UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>();
+
+	if (!Registry)
+	{
+		return;
+	}
+
+	const TArray<TObjectPtr<AStrategyUnit>>& Units = Registry->GetUnits();
+	const int32 NumUnits = Units.Num();
+
+	if (NumUnits == 0)
+	{
+		return;
+	}
+
+	{
+		DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyAwarenessScan);
+		DREAMEATING_PERF_SCOPE(AI);
+
+		// the staleness guarantee sets the minimum slice. The time budget may extend it
+		const int32 RequiredUnits = FMath::Min(FMath::CeilToInt32(NumUnits * DeltaTime / FMath::Max(GStrategyAwarenessMaxStaleness, 0.01f)), NumUnits);
+		const int32 MaxUnits = FMath::Clamp(GStrategyAwarenessUnitsPerFrame, RequiredUnits, NumUnits);
+
+		const double StartTime = FPlatformTime::Seconds();
+		const double Budget = GStrategyAwarenessBudget * 0.000001;
+
+		int32 Scanned = 0;
+		float MaxStaleness = 0.0f;
+
+		while (Scanned < MaxUnits && (Scanned < RequiredUnits || FPlatformTime::Seconds() - StartTime < Budget))
+		{
+			// wrap around once we've gone through every unit
+			if (Cursor >= NumUnits)
+			{
+				Cursor = 0;
+				PruneStates();
+			}
+
+			MaxStaleness = FMath::Max(MaxStaleness, ScanUnit(Units[Cursor], StartTime));
+
+			++Cursor;
+			++Scanned;
+		}
+
+		SET_DWORD_STAT(STAT_StrategyAwarenessScanned, Scanned);
+		SET_FLOAT_STAT(STAT_StrategyAwarenessStaleness, MaxStaleness);
+	}
+
+	PostEvents();
+}
+
+TStatId UStrategyAwarenessSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStrategyAwarenessSubsystem, STATGROUP_Tickables);
+}
+
+float UStrategyAwarenessSubsystem::ScanUnit(AStrategyUnit* Unit, double Now)
+{
+	if (!IsValid(Unit) || Unit->GetAwarenessRadius() <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	FStrategyAwarenessState& State = States.FindOrAdd(Unit);
+
+	// track how stale this unit's awareness got
+	const float Staleness = State.LastScanTime > 0.0 ? static_cast<float>((Now - State.LastScanTime) * 1000.0) : 0.0f;
+
+	State.LastScanTime = Now;
+
+	// query the shared grid
+	NearbyUnits.Reset();
+	UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>();
+	Registry->QueryUnitsInRadius(Unit->GetActorLocation(), Unit->GetAwarenessRadius(), NearbyUnits);
+
+	NearbySet.Reset();
+	NearbySet.Append(NearbyUnits);
+	NearbySet.Remove(Unit);
+
+	// anything we were aware of that's no longer nearby has been lost.
+	// Anything still nearby is taken out of the set, so only the new units are left in it
+	for (int32 Index = State.AwareOf.Num() - 1; Index >= 0; --Index)
+	{
+		AStrategyUnit* Other = State.AwareOf[Index].Get();
+
+		if (Other && NearbySet.Remove(Other) > 0)
+		{
+			continue;
+		}
+
+		if (Other)
+		{
+			FStrategyAwarenessEvent& Event = PendingEvents.AddDefaulted_GetRef();
+			Event.Unit = Unit;
+			Event.Other = Other;
+			Event.bBecameAware = false;
+		}
+
+		State.AwareOf.RemoveAtSwap(Index, EAllowShrinking::No);
+	}
+
+	// anything nearby we weren't aware of is new
+	for (AStrategyUnit* Other : NearbySet)
+	{
+		State.AwareOf.Add(Other);
+
+		FStrategyAwarenessEvent& Event = PendingEvents.AddDefaulted_GetRef();
+		Event.Unit = Unit;
+		Event.Other = Other;
+		Event.bBecameAware = true;
+	}
+
+	return Staleness;
+}
+
+void UStrategyAwarenessSubsystem::OnUnitRemoved(int32 Index)
+{
+	// every unit after the removed one moved down a slot
+	if (Index < Cursor)
+	{
+		--Cursor;
+	}
+}
+
+void UStrategyAwarenessSubsystem::PostEvents()
+{
+	SET_DWORD_STAT(STAT_StrategyAwarenessEvents, PendingEvents.Num());
+
+	// swap the queue out, in case a unit's response causes more events
+	TArray<FStrategyAwarenessEvent> Events = MoveTemp(PendingEvents);
+	PendingEvents.Reset();
+
+	for (const FStrategyAwarenessEvent& Event : Events)
+	{
+		AStrategyUnit* Unit = Event.Unit.Get();
+		AStrategyUnit* Other = Event.Other.Get();
+
+		if (!Unit || !Other)
+		{
+			continue;
+		}
+
+		if (Event.bBecameAware)
+		{
+			Unit->NotifyBecameAware(Other);
+		}
+		else
+		{
+			Unit->NotifyLostAwareness(Other);
+		}
+	}
+}
+
+void UStrategyAwarenessSubsystem::PruneStates()
+{
+	for (auto It = States.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().ResolveObjectPtr())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
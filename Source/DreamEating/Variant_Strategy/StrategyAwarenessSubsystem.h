@@ -0,0 +1,101 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "StrategyAwarenessSubsystem.generated.h"
+
+class AStrategyUnit;
+
+/**
+ *  Awareness state for a single unit
+ */
+struct FStrategyAwarenessState
+{
+	/** Units currently inside this unit's awareness radius */
+	TArray<TWeakObjectPtr<AStrategyUnit>> AwareOf;
+
+	/** Platform time of the last scan for this unit */
+	double LastScanTime = 0.0;
+};
+
+/**
+ *  A pending awareness change
+ */
+struct FStrategyAwarenessEvent
+{
+	/** Unit receiving the event */
+	TWeakObjectPtr<AStrategyUnit> Unit;
+
+	/** Unit that entered or left the awareness radius */
+	TWeakObjectPtr<AStrategyUnit> Other;
+
+	/** If true, the other unit entered the awareness radius. Otherwise it left */
+	bool bBecameAware = false;
+};
+
+/**
+ *  Time-sliced awareness scanner for Strategy units.
+ *  Each frame, scans a slice of the registered units against the unit registry's
+ *  spatial grid and posts "became aware" and "lost awareness" events to them.
+ *  The slice is bounded by a per-frame time budget, but always includes enough units
+ *  so that no unit goes longer than the max staleness without being scanned.
+ */
+UCLASS()
+class UStrategyAwarenessSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Awareness state for each unit that has been scanned */
+	TMap<TObjectKey<AStrategyUnit>, FStrategyAwarenessState> States;
+
+	/** Events waiting to be posted to their units */
+	TArray<FStrategyAwarenessEvent> PendingEvents;
+
+	/** Index of the next unit to scan in the registry */
+	int32 Cursor = 0;
+
+	/** Scratch list for proximity queries */
+	TArray<AStrategyUnit*> NearbyUnits;
+
+	/** Scratch set of the nearby units not yet matched against a unit's awareness list */
+	TSet<AStrategyUnit*> NearbySet;
+
+	/** Unit registry removal listener */
+	FDelegateHandle UnitRemovedHandle;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Subscribes to unit registry removals */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+	/** Scans the next slice of units */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/** Updates a single unit's awareness and queues events for any changes. Returns the time since the unit was last scanned, in milliseconds */
+	float ScanUnit(AStrategyUnit* Unit, double Now);
+
+	/** Keeps the scan cursor on the same unit when an earlier unit is removed from the registry */
+	void OnUnitRemoved(int32 Index);
+
+	/** Posts the queued events to their units */
+	void PostEvents();
+
+	/** Drops the state of units that no longer exist */
+	void PruneStates();
+};
@@ -0,0 +1,220 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyCrowdBenchmark.h"
+#include "StrategyUnit.h"
+#include "DreamEatingFormation.h"
+#include "AIController.h"
+#include "NavigationSystem.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "CoreGlobals.h"
+#include "DreamEating.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdStrategyCrowdBenchmark(
+	TEXT("DreamEating.Strategy.CrowdBenchmark"),
+	TEXT("Benchmarks crowd movement against regular path following. Usage: DreamEating.Strategy.CrowdBenchmark [Units=500] [Seconds=10]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UStrategyCrowdBenchmark* Benchmark = World ? World->GetSubsystem<UStrategyCrowdBenchmark>() : nullptr)
+		{
+			const int32 Units = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 500;
+			const float Seconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 10.0f;
+
+			Benchmark->StartBenchmark(Units, Seconds);
+		}
+	}));
+
+bool UStrategyCrowdBenchmark::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStrategyCrowdBenchmark::Tick(float DeltaTime)
+{
+	if (Phase == EPhase::Idle)
+	{
+		return;
+	}
+
+	// sample the frame
+	Elapsed += DeltaTime;
+	FrameTimes.Add(DeltaTime * 1000.0f);
+	GameThreadTimes.Add(static_cast<float>(FPlatformTime::ToMilliseconds(GGameThreadTime)));
+
+	// check how many units have arrived
+	if (ArrivalTime < 0.0f)
+	{
+		int32 Arrived = 0;
+
+		for (const TWeakObjectPtr<AStrategyUnit>& CurrentUnit : Units)
+		{
+			const AAIController* Controller = CurrentUnit.IsValid() ? Cast<AAIController>(CurrentUnit->GetController()) : nullptr;
+
+			if (!Controller || Controller->GetMoveStatus() == EPathFollowingStatus::Idle)
+			{
+				++Arrived;
+			}
+		}
+
+		if (Arrived >= Units.Num() * 0.9f)
+		{
+			ArrivalTime = Elapsed;
+		}
+	}
+
+	// move on to the next phase once this one times out
+	if (Elapsed >= Duration)
+	{
+		const EPhase FinishedPhase = Phase;
+
+		FinishPhase();
+
+		if (FinishedPhase == EPhase::Crowd)
+		{
+			StartPhase(EPhase::CharacterMovement);
+		}
+		else
+		{
+			SetCrowdMovement(bPreviousCrowdMovement);
+			Phase = EPhase::Idle;
+		}
+	}
+}
+
+TStatId UStrategyCrowdBenchmark::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStrategyCrowdBenchmark, STATGROUP_Tickables);
+}
+
+void UStrategyCrowdBenchmark::StartBenchmark(int32 InNumUnits, float InDuration)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Crowd benchmark is already running"));
+		return;
+	}
+
+	// use the first unit in the level as a template
+	TActorIterator<AStrategyUnit> It(GetWorld());
+
+	if (!It)
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Crowd benchmark needs at least one Strategy unit in the level"));
+		return;
+	}
+
+	UnitClass = It->GetClass();
+	Center = It->GetActorLocation();
+	NumUnits = FMath::Max(InNumUnits, 1);
+	Duration = FMath::Max(InDuration, 1.0f);
+
+	// save the crowd setting so we can restore it when we're done
+	if (IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DreamEating.Strategy.CrowdMovement")))
+	{
+		bPreviousCrowdMovement = CVar->GetBool();
+	}
+
+	StartPhase(EPhase::Crowd);
+}
+
+void UStrategyCrowdBenchmark::StartPhase(EPhase NewPhase)
+{
+	Phase = NewPhase;
+	Elapsed = 0.0f;
+	ArrivalTime = -1.0f;
+	FrameTimes.Reset();
+	GameThreadTimes.Reset();
+
+	// units pick up the crowd setting when they're possessed
+	SetCrowdMovement(NewPhase == EPhase::Crowd);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// spawn the units in concentric rings around the center
+	TArray<FVector> Slots;
+	FDreamEatingFormation::MakeRings(Center, NumUnits, 2000.0f, 150.0f, Slots);
+
+	for (FVector SpawnLocation : Slots)
+	{
+		FNavLocation NavLocation;
+
+		if (NavSys && NavSys->ProjectPointToNavigation(SpawnLocation, NavLocation))
+		{
+			SpawnLocation = NavLocation.Location;
+		}
+
+		if (AStrategyUnit* Unit = GetWorld()->SpawnActor<AStrategyUnit>(UnitClass, FTransform(SpawnLocation), SpawnParams))
+		{
+			Units.Add(Unit);
+		}
+	}
+
+	// send everyone to the center
+	for (const TWeakObjectPtr<AStrategyUnit>& CurrentUnit : Units)
+	{
+		if (CurrentUnit.IsValid())
+		{
+			CurrentUnit->MoveToLocation(Center, 50.0f);
+		}
+	}
+
+	UE_LOG(LogDreamEating, Display, TEXT("Crowd benchmark: started %s phase with %d units"), NewPhase == EPhase::Crowd ? TEXT("crowd") : TEXT("character movement"), Units.Num());
+}
+
+void UStrategyCrowdBenchmark::FinishPhase()
+{
+	// compute the results
+	float AverageFrame = 0.0f;
+	float AverageGameThread = 0.0f;
+
+	for (int32 Index = 0; Index < FrameTimes.Num(); ++Index)
+	{
+		AverageFrame += FrameTimes[Index];
+		AverageGameThread += GameThreadTimes[Index];
+	}
+
+	const int32 NumSamples = FMath::Max(FrameTimes.Num(), 1);
+	AverageFrame /= NumSamples;
+	AverageGameThread /= NumSamples;
+
+	FrameTimes.Sort();
+	const float P95Frame = FrameTimes.Num() > 0 ? FrameTimes[FMath::Min(FMath::FloorToInt32(FrameTimes.Num() * 0.95f), FrameTimes.Num() - 1)] : 0.0f;
+
+	UE_LOG(LogDreamEating, Display, TEXT("Crowd benchmark [%s]: %d units, %d frames, avg frame %.2f ms, p95 frame %.2f ms, avg game thread %.2f ms, 90%% arrived %s"),
+		Phase == EPhase::Crowd ? TEXT("Crowd") : TEXT("CharacterMovement"),
+		Units.Num(),
+		FrameTimes.Num(),
+		AverageFrame,
+		P95Frame,
+		AverageGameThread,
+		ArrivalTime >= 0.0f ? *FString::Printf(TEXT("after %.2f s"), ArrivalTime) : TEXT("never"));
+
+	// clean up the units
+	for (const TWeakObjectPtr<AStrategyUnit>& CurrentUnit : Units)
+	{
+		if (CurrentUnit.IsValid())
+		{
+			if (AController* Controller = CurrentUnit->GetController())
+			{
+				Controller->Destroy();
+			}
+
+			CurrentUnit->Destroy();
+		}
+	}
+
+	Units.Reset();
+}
+
+void UStrategyCrowdBenchmark::SetCrowdMovement(bool bEnabled)
+{
+	if (IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DreamEating.Strategy.CrowdMovement")))
+	{
+		CVar->Set(bEnabled, ECVF_SetByCode);
+	}
+}
@@ -0,0 +1,94 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StrategyCrowdBenchmark.generated.h"
+
+class AStrategyUnit;
+
+/**
+ *  Compares crowd-managed Strategy unit locomotion against regular path following.
+ *  Spawns a ring of units that all converge on a single point, once with the crowd manager
+ *  and once without, and logs the frame and game thread times of both runs.
+ *  Run with DreamEating.Strategy.CrowdBenchmark [Units] [Seconds]
+ */
+UCLASS()
+class UStrategyCrowdBenchmark : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Benchmark phases */
+	enum class EPhase : uint8
+	{
+		Idle,
+		Crowd,
+		CharacterMovement
+	};
+
+	/** Current phase */
+	EPhase Phase = EPhase::Idle;
+
+	/** Units spawned for the current phase */
+	TArray<TWeakObjectPtr<AStrategyUnit>> Units;
+
+	/** Unit class to spawn */
+	TSubclassOf<AStrategyUnit> UnitClass;
+
+	/** Point all units converge on */
+	FVector Center = FVector::ZeroVector;
+
+	/** Number of units to spawn */
+	int32 NumUnits = 500;
+
+	/** Duration of each phase, in seconds */
+	float Duration = 10.0f;
+
+	/** Time elapsed in the current phase */
+	float Elapsed = 0.0f;
+
+	/** Time it took 90% of the units to arrive in the current phase. Negative if they haven't yet */
+	float ArrivalTime = -1.0f;
+
+	/** Frame time samples for the current phase, in milliseconds */
+	TArray<float> FrameTimes;
+
+	/** Game thread time samples for the current phase, in milliseconds */
+	TArray<float> GameThreadTimes;
+
+	/** Value of the crowd movement console variable before the benchmark started */
+	bool bPreviousCrowdMovement = true;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Samples the current phase */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Starts the benchmark. Uses the class of the first Strategy unit found in the level */
+	void StartBenchmark(int32 InNumUnits, float InDuration);
+
+	/** Returns true while the benchmark is running */
+	bool IsRunning() const { return Phase != EPhase::Idle; }
+
+protected:
+
+	/** Spawns the units and issues the converge order for a phase */
+	void StartPhase(EPhase NewPhase);
+
+	/** Logs the results of the current phase and cleans up its units */
+	void FinishPhase();
+
+	/** Sets the crowd movement console variable */
+	static void SetCrowdMovement(bool bEnabled);
+};
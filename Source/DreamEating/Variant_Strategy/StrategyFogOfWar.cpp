@@ -0,0 +1,417 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyFogOfWar.h"
+#include "StrategyUnit.h"
+#include "StrategyUnitRegistry.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "Tasks/Task.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fog of War Gather"), STAT_StrategyFogGather, STATGROUP_DreamEating);
+DECLARE_CYCLE_STAT(TEXT("Fog of War Job"), STAT_StrategyFogJob, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Fog of War Units Restamped"), STAT_StrategyFogRestamped, STATGROUP_DreamEating);
+
+void FStrategyFogState::Process(const TArray<FStrategyFogUnitChange>& Changes)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyFogJob);
+
+	// the buffer we were swapped in with is missing the cells changed by the last job
+	for (int32 Index : ChangedCells)
+	{
+		BackBuffer[Index] = VisionCounts[Index] > 0 ? 1 : 0;
+	}
+
+	ChangedCells.Reset();
+
+	for (const FStrategyFogUnitChange& Change : Changes)
+	{
+		// remove the unit's previous stamp
+		TArray<int32> OldStamp;
+
+		if (Stamps.RemoveAndCopyValue(Change.Unit, OldStamp))
+		{
+			ApplyStamp(OldStamp, false);
+		}
+
+		// is the unit still revealing the grid?
+		if (Change.RadiusCells >= 0)
+		{
+			TArray<int32>& NewStamp = Stamps.Add(Change.Unit);
+			ComputeStamp(Change.Cell, Change.RadiusCells, NewStamp);
+
+			// stamps hold team offset cell indices, so we can apply them regardless of the team
+			const int32 TeamOffset = Change.Team * GridSize * GridSize;
+
+			for (int32& Index : NewStamp)
+			{
+				Index += TeamOffset;
+			}
+
+			ApplyStamp(NewStamp, true);
+		}
+	}
+}
+
+void FStrategyFogState::ComputeStamp(const FIntPoint& Origin, int32 RadiusCells, TArray<int32>& OutCells)
+{
+	// start a new visit so each cell is only added once
+	++VisitMark;
+
+	const int32 OriginIndex = Origin.Y * GridSize + Origin.X;
+	const bool bOcclude = Heights.Num() > 0 && Heights[OriginIndex] > TNumericLimits<float>::Lowest();
+	const float EyeZ = bOcclude ? Heights[OriginIndex] + EyeHeight : 0.0f;
+	const int32 RadiusSquared = RadiusCells * RadiusCells;
+
+	VisitMarks[OriginIndex] = VisitMark;
+	OutCells.Add(OriginIndex);
+
+	// cast a ray from the origin to every cell on the bounding square's perimeter
+	const int32 NumPerimeterCells = FMath::Max(RadiusCells * 8, 1);
+
+	for (int32 PerimeterIndex = 0; PerimeterIndex < NumPerimeterCells; ++PerimeterIndex)
+	{
+		// walk the perimeter one side at a time
+		const int32 Side = PerimeterIndex / FMath::Max(RadiusCells * 2, 1);
+		const int32 Offset = PerimeterIndex % FMath::Max(RadiusCells * 2, 1) - RadiusCells;
+
+		FIntPoint Target;
+
+		switch (Side)
+		{
+		case 0:		Target = FIntPoint(Offset, -RadiusCells);	break;
+		case 1:		Target = FIntPoint(RadiusCells, Offset);	break;
+		case 2:		Target = FIntPoint(-Offset, RadiusCells);	break;
+		default:	Target = FIntPoint(-RadiusCells, -Offset);	break;
+		}
+
+		const int32 Steps = FMath::Max(FMath::Abs(Target.X), FMath::Abs(Target.Y));
+
+		for (int32 Step = 1; Step <= Steps; ++Step)
+		{
+			const int32 DeltaX = FMath::RoundToInt(float(Target.X * Step) / Steps);
+			const int32 DeltaY = FMath::RoundToInt(float(Target.Y * Step) / Steps);
+
+			// stop at the edge of the sight circle
+			if (DeltaX * DeltaX + DeltaY * DeltaY > RadiusSquared)
+			{
+				break;
+			}
+
+			const int32 X = Origin.X + DeltaX;
+			const int32 Y = Origin.Y + DeltaY;
+
+			// stop at the edge of the grid
+			if (X < 0 || Y < 0 || X >= GridSize || Y >= GridSize)
+			{
+				break;
+			}
+
+			const int32 Index = Y * GridSize + X;
+
+			if (VisitMarks[Index] != VisitMark)
+			{
+				VisitMarks[Index] = VisitMark;
+				OutCells.Add(Index);
+			}
+
+			// blockers are visible themselves, but hide everything behind them
+			if (bOcclude && Heights[Index] > EyeZ)
+			{
+				break;
+			}
+		}
+	}
+}
+
+void FStrategyFogState::ApplyStamp(const TArray<int32>& Cells, bool bAdd)
+{
+	for (int32 Index : Cells)
+	{
+		uint16& Count = VisionCounts[Index];
+
+		if (bAdd)
+		{
+			// the cell just became visible
+			if (Count++ == 0)
+			{
+				BackBuffer[Index] = 1;
+				ChangedCells.Add(Index);
+			}
+		}
+		else if (Count > 0)
+		{
+			// the cell just became hidden
+			if (--Count == 0)
+			{
+				BackBuffer[Index] = 0;
+				ChangedCells.Add(Index);
+			}
+		}
+	}
+}
+
+AStrategyFogOfWar::AStrategyFogOfWar()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// gather after units have moved for the frame
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void AStrategyFogOfWar::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const int32 NumCells = GridSize * GridSize;
+
+	State = MakeShared<FStrategyFogState, ESPMode::ThreadSafe>();
+	State->GridSize = GridSize;
+	State->EyeHeight = EyeHeight;
+	State->VisionCounts.SetNumZeroed(NumCells * NumTeams);
+	State->BackBuffer.SetNumZeroed(NumCells * NumTeams);
+	State->VisitMarks.SetNumZeroed(NumCells);
+
+	// ignore the height map if it was baked with different grid settings
+	if (BakedHeights.Num() == NumCells)
+	{
+		State->Heights = BakedHeights;
+	}
+	else if (BakedHeights.Num() > 0)
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Fog of war height map doesn't match the grid size, rebake it. Occlusion is disabled."));
+	}
+
+	FrontBuffer.SetNumZeroed(NumCells * NumTeams);
+}
+
+void AStrategyFogOfWar::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// the job owns the state, so let it finish before we release it
+	if (bTaskInFlight)
+	{
+		VisibilityTask.Wait();
+		bTaskInFlight = false;
+	}
+
+	State.Reset();
+	TrackedUnits.Empty();
+	PendingChanges.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AStrategyFogOfWar::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyFogGather);
+
+	// swap in the results of the last job once it's done. We never wait on it
+	if (bTaskInFlight && VisibilityTask.IsCompleted())
+	{
+		Swap(FrontBuffer, State->BackBuffer);
+		bTaskInFlight = false;
+	}
+
+	// keep gathering while the job runs, the changes will go out with the next one
+	GatherChanges();
+
+	if (!bTaskInFlight && PendingChanges.Num() > 0)
+	{
+		INC_DWORD_STAT_BY(STAT_StrategyFogRestamped, PendingChanges.Num());
+
+		VisibilityTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [JobState = State, Changes = MoveTemp(PendingChanges)]()
+		{
+			JobState->Process(Changes);
+		});
+
+		PendingChanges.Reset();
+		bTaskInFlight = true;
+	}
+}
+
+bool AStrategyFogOfWar::IsVisible(int32 Team, const FIntPoint& Cell) const
+{
+	// we have no visibility data for cells outside the grid or teams we don't track
+	if (Cell.X < 0 || Cell.Y < 0 || Cell.X >= GridSize || Cell.Y >= GridSize || Team < 0 || Team >= NumTeams || FrontBuffer.Num() == 0)
+	{
+		return true;
+	}
+
+	return FrontBuffer[Team * GridSize * GridSize + Cell.Y * GridSize + Cell.X] != 0;
+}
+
+bool AStrategyFogOfWar::IsLocationVisible(int32 Team, const FVector& Location) const
+{
+	FIntPoint Cell;
+
+	return !WorldToCell(Location, Cell) || IsVisible(Team, Cell);
+}
+
+bool AStrategyFogOfWar::IsUnitVisible(int32 Team, const AStrategyUnit* Unit) const
+{
+	if (!IsValid(Unit))
+	{
+		return false;
+	}
+
+	// we always see our own units
+	return Unit->GetTeamIndex() == Team || IsLocationVisible(Team, Unit->GetActorLocation());
+}
+
+bool AStrategyFogOfWar::WorldToCell(const FVector& Location, FIntPoint& OutCell) const
+{
+	const FVector Local = Location - GetGridOrigin();
+
+	OutCell.X = FMath::FloorToInt32(Local.X / CellSize);
+	OutCell.Y = FMath::FloorToInt32(Local.Y / CellSize);
+
+	return OutCell.X >= 0 && OutCell.Y >= 0 && OutCell.X < GridSize && OutCell.Y < GridSize;
+}
+
+TConstArrayView<uint8> AStrategyFogOfWar::GetVisibilityBuffer(int32 Team) const
+{
+	const int32 NumCells = GridSize * GridSize;
+
+	if (Team < 0 || Team >= NumTeams || FrontBuffer.Num() < NumCells * NumTeams)
+	{
+		return TConstArrayView<uint8>();
+	}
+
+	return TConstArrayView<uint8>(FrontBuffer.GetData() + Team * NumCells, NumCells);
+}
+
+void AStrategyFogOfWar::BakeHeightMap()
+{
+	UWorld* World = GetWorld();
+
+	if (!World)
+	{
+		return;
+	}
+
+	Modify();
+
+	const FVector Origin = GetGridOrigin();
+	const float BaseZ = GetActorLocation().Z;
+
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldStatic);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(StrategyFogBake), false, this);
+
+	BakedHeights.SetNumUninitialized(GridSize * GridSize);
+
+	int32 NumEmpty = 0;
+
+	for (int32 Y = 0; Y < GridSize; ++Y)
+	{
+		for (int32 X = 0; X < GridSize; ++X)
+		{
+			const FVector Center = Origin + FVector((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize, 0.0f);
+			const FVector Start(Center.X, Center.Y, BaseZ + BakeTraceHeight);
+			const FVector End(Center.X, Center.Y, BaseZ - BakeTraceHeight);
+
+			// the highest static surface in the cell is either its ground or a blocker standing on it
+			FHitResult Hit;
+
+			if (World->LineTraceSingleByObjectType(Hit, Start, End, ObjectParams, QueryParams))
+			{
+				BakedHeights[Y * GridSize + X] = Hit.ImpactPoint.Z;
+			}
+			else
+			{
+				BakedHeights[Y * GridSize + X] = TNumericLimits<float>::Lowest();
+				++NumEmpty;
+			}
+		}
+	}
+
+	UE_LOG(LogDreamEating, Display, TEXT("Baked fog of war height map: %d cells, %d without ground"), BakedHeights.Num(), NumEmpty);
+}
+
+void AStrategyFogOfWar::GatherChanges()
+{
+	UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>();
+
+	if (!Registry)
+	{
+		return;
+	}
+
+	++UpdateCounter;
+
+	for (AStrategyUnit* Unit : Registry->GetUnits())
+	{
+		if (!IsValid(Unit))
+		{
+			continue;
+		}
+
+		const int32 Team = Unit->GetTeamIndex();
+
+		// units on teams we don't track don't reveal anything
+		if (Team < 0 || Team >= NumTeams)
+		{
+			continue;
+		}
+
+		FIntPoint Cell;
+
+		if (!WorldToCell(Unit->GetActorLocation(), Cell))
+		{
+			continue;
+		}
+
+		const int32 RadiusCells = FMath::CeilToInt32(Unit->GetSightRadius() / CellSize);
+
+		FStrategyFogTrackedUnit* Tracked = TrackedUnits.Find(Unit);
+		const bool bChanged = !Tracked || Tracked->Cell != Cell || Tracked->Team != Team || Tracked->RadiusCells != RadiusCells;
+
+		if (!Tracked)
+		{
+			Tracked = &TrackedUnits.Add(Unit);
+		}
+
+		Tracked->LastSeenUpdate = UpdateCounter;
+
+		// only restamp units that changed cell, team or sight
+		if (bChanged)
+		{
+			Tracked->Cell = Cell;
+			Tracked->Team = Team;
+			Tracked->RadiusCells = RadiusCells;
+
+			FStrategyFogUnitChange& Change = PendingChanges.AddDefaulted_GetRef();
+			Change.Unit = Unit;
+			Change.Cell = Cell;
+			Change.Team = Team;
+			Change.RadiusCells = RadiusCells;
+		}
+	}
+
+	// remove the stamps of units that weren't seen this update
+	for (auto It = TrackedUnits.CreateIterator(); It; ++It)
+	{
+		if (It.Value().LastSeenUpdate != UpdateCounter)
+		{
+			FStrategyFogUnitChange& Change = PendingChanges.AddDefaulted_GetRef();
+			Change.Unit = It.Key();
+			Change.Team = It.Value().Team;
+			Change.RadiusCells = -1;
+
+			It.RemoveCurrent();
+		}
+	}
+}
+
+FVector AStrategyFogOfWar::GetGridOrigin() const
+{
+	const float HalfExtent = GridSize * CellSize * 0.5f;
+
+	return GetActorLocation() - FVector(HalfExtent, HalfExtent, 0.0f);
+}
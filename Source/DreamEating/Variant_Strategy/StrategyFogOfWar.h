@@ -0,0 +1,196 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Tasks/Task.h"
+#include "UObject/ObjectKey.h"
+#include "StrategyFogOfWar.generated.h"
+
+class AStrategyUnit;
+
+/**
+ *  Vision change for a single unit, passed to the visibility job
+ */
+struct FStrategyFogUnitChange
+{
+	/** Unit whose vision changed */
+	TObjectKey<AStrategyUnit> Unit;
+
+	/** Grid cell the unit is standing in */
+	FIntPoint Cell = FIntPoint::ZeroValue;
+
+	/** Team the unit reveals the grid for */
+	int32 Team = 0;
+
+	/** Sight radius in cells. Negative if the unit should stop revealing the grid */
+	int32 RadiusCells = -1;
+};
+
+/**
+ *  Vision last submitted for a unit, tracked on the game thread
+ */
+struct FStrategyFogTrackedUnit
+{
+	/** Grid cell the unit was standing in */
+	FIntPoint Cell = FIntPoint::ZeroValue;
+
+	/** Team the unit revealed the grid for */
+	int32 Team = 0;
+
+	/** Sight radius in cells */
+	int32 RadiusCells = 0;
+
+	/** Last update the unit was seen in the registry */
+	uint32 LastSeenUpdate = 0;
+};
+
+/**
+ *  Visibility grid state owned by the visibility job.
+ *  Only touched by the game thread while no job is in flight.
+ */
+struct FStrategyFogState
+{
+	/** Number of cells along each side of the grid */
+	int32 GridSize = 0;
+
+	/** Height of a unit's eyes above the ground, in cm */
+	float EyeHeight = 0.0f;
+
+	/** Baked ground height of each cell. Empty if there's no occlusion */
+	TArray<float> Heights;
+
+	/** Number of units seeing each cell, per team */
+	TArray<uint16> VisionCounts;
+
+	/** Visible flag for each cell, per team. Written by the job and swapped with the front buffer on completion */
+	TArray<uint8> BackBuffer;
+
+	/** Team offset cells stamped by each unit */
+	TMap<TObjectKey<AStrategyUnit>, TArray<int32>> Stamps;
+
+	/** Cells changed by the last job, used to bring the back buffer up to date after a swap */
+	TArray<int32> ChangedCells;
+
+	/** Last visit marker for each cell, used to dedupe cells while stamping */
+	TArray<uint32> VisitMarks;
+
+	/** Current visit marker */
+	uint32 VisitMark = 0;
+
+	/** Applies the given vision changes to the grid */
+	void Process(const TArray<FStrategyFogUnitChange>& Changes);
+
+	/** Gathers the cells visible from the given cell, with line of sight checked against the height map */
+	void ComputeStamp(const FIntPoint& Origin, int32 RadiusCells, TArray<int32>& OutCells);
+
+	/** Adds or removes a unit's stamp from the vision counts */
+	void ApplyStamp(const TArray<int32>& Cells, bool bAdd);
+};
+
+/**
+ *  Team fog of war for the Strategy variant.
+ *  Keeps a per team visibility grid that only restamps units whose cell, team or sight
+ *  radius changed since the last update. Sight is occluded by a height map baked in the editor.
+ *  Stamping runs as a background task, and its results are double buffered so visibility
+ *  queries from selection and UI never wait on the job.
+ */
+UCLASS()
+class AStrategyFogOfWar : public AActor
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Number of cells along each side of the grid. The grid is centered on this actor */
+	UPROPERTY(EditAnywhere, Category="Fog of War", meta = (ClampMin = 1, ClampMax = 2048))
+	int32 GridSize = 512;
+
+	/** Size of each grid cell */
+	UPROPERTY(EditAnywhere, Category="Fog of War", meta = (ClampMin = 1, Units = "cm"))
+	float CellSize = 100.0f;
+
+	/** Number of teams to track visibility for */
+	UPROPERTY(EditAnywhere, Category="Fog of War", meta = (ClampMin = 1, ClampMax = 8))
+	int32 NumTeams = 2;
+
+	/** Height of a unit's eyes above the ground. Cells higher than this block sight */
+	UPROPERTY(EditAnywhere, Category="Fog of War", meta = (ClampMin = 0, Units = "cm"))
+	float EyeHeight = 150.0f;
+
+	/** Vertical range traced above and below this actor when baking the height map */
+	UPROPERTY(EditAnywhere, Category="Fog of War|Bake", meta = (ClampMin = 0, Units = "cm"))
+	float BakeTraceHeight = 10000.0f;
+
+	/** Baked ground and blocker height of each cell */
+	UPROPERTY()
+	TArray<float> BakedHeights;
+
+	/** Grid state owned by the visibility job */
+	TSharedPtr<FStrategyFogState, ESPMode::ThreadSafe> State;
+
+	/** Visible flag for each cell, per team. Read by visibility queries */
+	TArray<uint8> FrontBuffer;
+
+	/** Vision last submitted for each unit */
+	TMap<TObjectKey<AStrategyUnit>, FStrategyFogTrackedUnit> TrackedUnits;
+
+	/** Vision changes gathered for the next job */
+	TArray<FStrategyFogUnitChange> PendingChanges;
+
+	/** Visibility job in flight */
+	UE::Tasks::FTask VisibilityTask;
+
+	/** If true, the visibility job has results waiting to be swapped in */
+	bool bTaskInFlight = false;
+
+	/** Incremented on every update, used to find units that left the registry */
+	uint32 UpdateCounter = 0;
+
+public:
+
+	/** Constructor */
+	AStrategyFogOfWar();
+
+	/** Initialization */
+	virtual void BeginPlay() override;
+
+	/** Cleanup */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Swaps in finished results and launches the next visibility job */
+	virtual void Tick(float DeltaTime) override;
+
+public:
+
+	/** Returns true if the given cell is visible to the team. Cells outside the grid are always visible */
+	bool IsVisible(int32 Team, const FIntPoint& Cell) const;
+
+	/** Returns true if the given world location is visible to the team */
+	bool IsLocationVisible(int32 Team, const FVector& Location) const;
+
+	/** Returns true if the unit is visible to the team. Units are always visible to their own team */
+	bool IsUnitVisible(int32 Team, const AStrategyUnit* Unit) const;
+
+	/** Converts a world location to a grid cell. Returns false if the location is outside the grid */
+	bool WorldToCell(const FVector& Location, FIntPoint& OutCell) const;
+
+	/** Returns the number of cells along each side of the grid */
+	int32 GetGridSize() const { return GridSize; }
+
+	/** Returns the visible flags of every cell for the given team, for UI drawing */
+	TConstArrayView<uint8> GetVisibilityBuffer(int32 Team) const;
+
+protected:
+
+	/** Traces down through each cell against static geometry to bake the height map used for occlusion */
+	UFUNCTION(CallInEditor, Category="Fog of War|Bake")
+	void BakeHeightMap();
+
+	/** Gathers the units whose vision changed since the last update */
+	void GatherChanges();
+
+	/** Returns the world location of the grid's minimum corner */
+	FVector GetGridOrigin() const;
+};
@@ -0,0 +1,458 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyNavGraph.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "Algo/Reverse.h"
+#include "Engine/World.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Nav Graph Route Search"), STAT_StrategyNavGraphSearch, STATGROUP_DreamEating);
+DECLARE_CYCLE_STAT(TEXT("Nav Graph Rebuild"), STAT_StrategyNavGraphRebuild, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav Graph Clusters"), STAT_StrategyNavGraphClusters, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav Graph Portals"), STAT_StrategyNavGraphPortals, STATGROUP_DreamEating);
+
+static bool GStrategyHierarchicalPaths = true;
+static FAutoConsoleVariableRef CVarStrategyHierarchicalPaths(
+	TEXT("DreamEating.Strategy.HierarchicalPaths"),
+	GStrategyHierarchicalPaths,
+	TEXT("If true, Strategy units plan long moves on the abstract cluster graph and only refine the next few clusters with regular pathfinding."),
+	ECVF_Default);
+
+static int32 GStrategyRefineClusters = 2;
+static FAutoConsoleVariableRef CVarStrategyRefineClusters(
+	TEXT("DreamEating.Strategy.RefineClusters"),
+	GStrategyRefineClusters,
+	TEXT("Number of clusters a Strategy unit refines with regular pathfinding at a time when following a hierarchical route."),
+	ECVF_Default);
+
+static int32 GStrategyRouteSearchNodes = 8192;
+static FAutoConsoleVariableRef CVarStrategyRouteSearchNodes(
+	TEXT("DreamEating.Strategy.RouteSearchNodes"),
+	GStrategyRouteSearchNodes,
+	TEXT("Max number of portals expanded by a single hierarchical route search before it gives up."),
+	ECVF_Default);
+
+bool UStrategyNavGraph::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStrategyNavGraph::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// subscribe to navmesh rebuilds so we can update dynamic tiles
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(&InWorld))
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UStrategyNavGraph::OnNavigationGenerationFinished);
+	}
+}
+
+void UStrategyNavGraph::Deinitialize()
+{
+	// unsubscribe from the navigation system
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &UStrategyNavGraph::OnNavigationGenerationFinished);
+	}
+
+	Clusters.Empty();
+	Portals.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UStrategyNavGraph::FindRoute(const FVector& Start, const FVector& Goal, TArray<FVector>& OutWaypoints)
+{
+	OutWaypoints.Reset();
+
+	if (!IsEnabled())
+	{
+		return false;
+	}
+
+	const ARecastNavMesh* NavMesh = GetGraphNavMesh();
+
+	if (!NavMesh)
+	{
+		return false;
+	}
+
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyNavGraphSearch);
+	DREAMEATING_PERF_SCOPE(AI);
+
+	// find the clusters under both ends of the route
+	const FVector Extent = NavMesh->GetDefaultQueryExtent();
+	FNavLocation StartLocation, GoalLocation;
+	uint32 StartCluster = 0;
+	uint32 GoalCluster = 0;
+
+	if (!NavMesh->ProjectPoint(Start, StartLocation, Extent) || !NavMesh->ProjectPoint(Goal, GoalLocation, Extent))
+	{
+		return false;
+	}
+
+	if (!NavMesh->GetPolyTileIndex(StartLocation.NodeRef, StartCluster) || !NavMesh->GetPolyTileIndex(GoalLocation.NodeRef, GoalCluster))
+	{
+		return false;
+	}
+
+	// short moves don't need the abstract graph
+	if (StartCluster == GoalCluster)
+	{
+		return false;
+	}
+
+	const FStrategyNavCluster* StartClusterData = Clusters.Find(StartCluster);
+
+	if (!StartClusterData || !Clusters.Contains(GoalCluster))
+	{
+		return false;
+	}
+
+	// A* over the portals. The start and goal locations are virtual nodes
+	struct FSearchNode
+	{
+		float Cost = 0.0f;
+		uint64 Parent = 0;
+		bool bClosed = false;
+	};
+
+	struct FOpenEntry
+	{
+		uint64 Key;
+		float TotalCost;
+	};
+
+	const uint64 StartKey = MAX_uint64 - 1;
+	const uint64 GoalKey = MAX_uint64;
+
+	TMap<uint64, FSearchNode> Nodes;
+	TArray<FOpenEntry> Open;
+
+	const auto OpenLess = [](const FOpenEntry& A, const FOpenEntry& B)
+	{
+		return A.TotalCost < B.TotalCost;
+	};
+
+	const auto Relax = [&](uint64 Key, const FVector& Location, float Cost, uint64 Parent)
+	{
+		FSearchNode* Node = Nodes.Find(Key);
+
+		if (Node && (Node->bClosed || Node->Cost <= Cost))
+		{
+			return;
+		}
+
+		if (!Node)
+		{
+			Node = &Nodes.Add(Key);
+		}
+
+		Node->Cost = Cost;
+		Node->Parent = Parent;
+
+		Open.HeapPush(FOpenEntry{ Key, Cost + static_cast<float>(FVector::Dist(Location, GoalLocation.Location)) }, OpenLess);
+	};
+
+	// seed the search with the portals out of the start cluster
+	for (const uint64 PortalKey : StartClusterData->Portals)
+	{
+		if (const FStrategyNavPortal* Portal = Portals.Find(PortalKey))
+		{
+			Relax(PortalKey, Portal->Location, static_cast<float>(FVector::Dist(StartLocation.Location, Portal->Location)), StartKey);
+		}
+	}
+
+	bool bFoundRoute = false;
+	int32 Expanded = 0;
+
+	while (Open.Num() > 0 && Expanded < GStrategyRouteSearchNodes)
+	{
+		FOpenEntry Entry;
+		Open.HeapPop(Entry, OpenLess, EAllowShrinking::No);
+
+		if (Entry.Key == GoalKey)
+		{
+			bFoundRoute = true;
+			break;
+		}
+
+		// skip stale entries for nodes we've already expanded
+		FSearchNode& Node = Nodes.FindChecked(Entry.Key);
+
+		if (Node.bClosed)
+		{
+			continue;
+		}
+
+		Node.bClosed = true;
+		++Expanded;
+
+		// copy what we need, since relaxing may reallocate the node map
+		const float NodeCost = Node.Cost;
+		const FStrategyNavPortal Portal = Portals.FindChecked(Entry.Key);
+
+		// connect to the goal if this portal touches its cluster
+		if (Portal.ClusterA == GoalCluster || Portal.ClusterB == GoalCluster)
+		{
+			Relax(GoalKey, GoalLocation.Location, NodeCost + static_cast<float>(FVector::Dist(Portal.Location, GoalLocation.Location)), Entry.Key);
+		}
+
+		// expand every other portal in both clusters this portal connects
+		for (const uint32 ClusterIndex : { Portal.ClusterA, Portal.ClusterB })
+		{
+			const FStrategyNavCluster* Cluster = Clusters.Find(ClusterIndex);
+
+			if (!Cluster)
+			{
+				continue;
+			}
+
+			for (const uint64 NextKey : Cluster->Portals)
+			{
+				const FStrategyNavPortal* NextPortal = Portals.Find(NextKey);
+
+				if (NextKey != Entry.Key && NextPortal)
+				{
+					Relax(NextKey, NextPortal->Location, NodeCost + static_cast<float>(FVector::Dist(Portal.Location, NextPortal->Location)), Entry.Key);
+				}
+			}
+		}
+	}
+
+	if (!bFoundRoute)
+	{
+		UE_LOG(LogDreamEating, Verbose, TEXT("No hierarchical route found after expanding %d portals"), Expanded);
+		return false;
+	}
+
+	// walk back from the goal to get the portal waypoints
+	for (uint64 Key = Nodes.FindChecked(GoalKey).Parent; Key != StartKey; Key = Nodes.FindChecked(Key).Parent)
+	{
+		OutWaypoints.Add(Portals.FindChecked(Key).Location);
+	}
+
+	Algo::Reverse(OutWaypoints);
+
+	return true;
+}
+
+int32 UStrategyNavGraph::GetRefineClusterCount()
+{
+	return FMath::Max(GStrategyRefineClusters, 1);
+}
+
+bool UStrategyNavGraph::IsEnabled()
+{
+	return GStrategyHierarchicalPaths;
+}
+
+void UStrategyNavGraph::BuildGraph(const ARecastNavMesh* NavMesh)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyNavGraphRebuild);
+
+	Clusters.Empty();
+	Portals.Empty();
+
+	GraphNavMesh = NavMesh;
+
+	// one cluster per navmesh tile
+	const int32 TileCount = NavMesh->GetNavMeshTilesCount();
+
+	for (int32 TileIndex = 0; TileIndex < TileCount; ++TileIndex)
+	{
+		RebuildCluster(NavMesh, TileIndex);
+	}
+
+	SET_DWORD_STAT(STAT_StrategyNavGraphClusters, Clusters.Num());
+	SET_DWORD_STAT(STAT_StrategyNavGraphPortals, Portals.Num());
+
+	UE_LOG(LogDreamEating, Log, TEXT("Built Strategy nav graph with %d clusters and %d portals"), Clusters.Num(), Portals.Num());
+}
+
+void UStrategyNavGraph::RebuildCluster(const ARecastNavMesh* NavMesh, uint32 TileIndex)
+{
+	// drop the old cluster data
+	RemoveCluster(TileIndex);
+
+	TArray<FNavPoly> Polys;
+
+	if (!NavMesh->GetPolysInTile(TileIndex, Polys) || Polys.IsEmpty())
+	{
+		return;
+	}
+
+	FStrategyNavCluster& Cluster = Clusters.Add(TileIndex);
+	Cluster.SignaturePoly = Polys[0].Ref;
+
+	// gather the midpoints of every edge that crosses into another tile
+	TMap<uint32, TArray<FVector>> CrossingEdges;
+	TArray<FNavigationPortalEdge> Edges;
+	uint32 NeighborTile = 0;
+
+	for (const FNavPoly& Poly : Polys)
+	{
+		Edges.Reset();
+
+		if (!NavMesh->GetPolyNeighbors(Poly.Ref, Edges))
+		{
+			continue;
+		}
+
+		for (const FNavigationPortalEdge& Edge : Edges)
+		{
+			if (NavMesh->GetPolyTileIndex(Edge.ToRef, NeighborTile) && NeighborTile != TileIndex)
+			{
+				CrossingEdges.FindOrAdd(NeighborTile).Add((Edge.Left + Edge.Right) * 0.5f);
+			}
+		}
+	}
+
+	// make one portal per neighbor tile
+	for (const TPair<uint32, TArray<FVector>>& Crossing : CrossingEdges)
+	{
+		// place the portal on the real edge closest to the average crossing point
+		FVector Average = FVector::ZeroVector;
+
+		for (const FVector& Midpoint : Crossing.Value)
+		{
+			Average += Midpoint;
+		}
+
+		Average /= Crossing.Value.Num();
+
+		FVector PortalLocation = Crossing.Value[0];
+
+		for (const FVector& Midpoint : Crossing.Value)
+		{
+			if (FVector::DistSquared(Midpoint, Average) < FVector::DistSquared(PortalLocation, Average))
+			{
+				PortalLocation = Midpoint;
+			}
+		}
+
+		const uint64 PortalKey = MakePortalKey(TileIndex, Crossing.Key);
+
+		FStrategyNavPortal& Portal = Portals.Add(PortalKey);
+		Portal.Location = PortalLocation;
+		Portal.ClusterA = FMath::Min(TileIndex, Crossing.Key);
+		Portal.ClusterB = FMath::Max(TileIndex, Crossing.Key);
+
+		Cluster.Portals.Add(PortalKey);
+
+		// link the portal from the other side if that cluster has already been built
+		if (FStrategyNavCluster* NeighborCluster = Clusters.Find(Crossing.Key))
+		{
+			NeighborCluster->Portals.AddUnique(PortalKey);
+		}
+	}
+}
+
+void UStrategyNavGraph::RemoveCluster(uint32 TileIndex)
+{
+	FStrategyNavCluster RemovedCluster;
+
+	if (!Clusters.RemoveAndCopyValue(TileIndex, RemovedCluster))
+	{
+		return;
+	}
+
+	// remove the cluster's portals from both sides
+	for (const uint64 PortalKey : RemovedCluster.Portals)
+	{
+		FStrategyNavPortal RemovedPortal;
+
+		if (Portals.RemoveAndCopyValue(PortalKey, RemovedPortal))
+		{
+			const uint32 OtherCluster = RemovedPortal.ClusterA == TileIndex ? RemovedPortal.ClusterB : RemovedPortal.ClusterA;
+
+			if (FStrategyNavCluster* Neighbor = Clusters.Find(OtherCluster))
+			{
+				Neighbor->Portals.RemoveSingleSwap(PortalKey);
+			}
+		}
+	}
+}
+
+const ARecastNavMesh* UStrategyNavGraph::GetGraphNavMesh()
+{
+	const ARecastNavMesh* NavMesh = GraphNavMesh.Get();
+
+	// build the graph on first use
+	if (!NavMesh)
+	{
+		if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavMesh = Cast<ARecastNavMesh>(NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate));
+
+			if (NavMesh)
+			{
+				BuildGraph(NavMesh);
+			}
+		}
+	}
+
+	return NavMesh;
+}
+
+void UStrategyNavGraph::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	const ARecastNavMesh* NavMesh = GraphNavMesh.Get();
+
+	// ignore other navmeshes, and wait for the first route query to build the graph
+	if (!NavMesh || NavData != NavMesh)
+	{
+		return;
+	}
+
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyNavGraphRebuild);
+
+	const int32 TileCount = NavMesh->GetNavMeshTilesCount();
+	int32 RebuiltClusters = 0;
+
+	FVector PolyCenter;
+	TArray<FNavPoly> Polys;
+
+	for (int32 TileIndex = 0; TileIndex < TileCount; ++TileIndex)
+	{
+		if (const FStrategyNavCluster* Cluster = Clusters.Find(TileIndex))
+		{
+			// rebuilt tiles get a new salt, so the old signature poly no longer resolves
+			if (NavMesh->GetPolyCenter(Cluster->SignaturePoly, PolyCenter))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			// skip tiles that are still empty
+			Polys.Reset();
+
+			if (!NavMesh->GetPolysInTile(TileIndex, Polys) || Polys.IsEmpty())
+			{
+				continue;
+			}
+		}
+
+		RebuildCluster(NavMesh, TileIndex);
+		++RebuiltClusters;
+	}
+
+	SET_DWORD_STAT(STAT_StrategyNavGraphClusters, Clusters.Num());
+	SET_DWORD_STAT(STAT_StrategyNavGraphPortals, Portals.Num());
+
+	if (RebuiltClusters > 0)
+	{
+		UE_LOG(LogDreamEating, Verbose, TEXT("Rebuilt %d Strategy nav graph clusters"), RebuiltClusters);
+	}
+}
+
+uint64 UStrategyNavGraph::MakePortalKey(uint32 ClusterA, uint32 ClusterB)
+{
+	return (static_cast<uint64>(FMath::Min(ClusterA, ClusterB)) << 32) | FMath::Max(ClusterA, ClusterB);
+}
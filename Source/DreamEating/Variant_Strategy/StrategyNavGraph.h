@@ -0,0 +1,105 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationSystemTypes.h"
+#include "StrategyNavGraph.generated.h"
+
+class ANavigationData;
+class ARecastNavMesh;
+
+/**
+ *  Crossing point between two adjacent navmesh clusters
+ */
+struct FStrategyNavPortal
+{
+	/** Midpoint of the shared navmesh edge chosen for this portal */
+	FVector Location = FVector::ZeroVector;
+
+	/** Lower cluster index of the pair */
+	uint32 ClusterA = 0;
+
+	/** Higher cluster index of the pair */
+	uint32 ClusterB = 0;
+};
+
+/**
+ *  A navmesh tile in the abstract graph
+ */
+struct FStrategyNavCluster
+{
+	/** Poly ref of the first poly in the tile. Its salt changes when the tile is rebuilt */
+	NavNodeRef SignaturePoly = INVALID_NAVNODEREF;
+
+	/** Keys of the portals leading out of this cluster */
+	TArray<uint64> Portals;
+};
+
+/**
+ *  Hierarchical pathfinding layer for large Strategy maps.
+ *  Abstracts the navmesh into clusters (one per navmesh tile) connected through portals
+ *  placed on shared tile edges, and runs A* over that coarse graph so units only need
+ *  regular navmesh pathfinding for the next couple of clusters on their route.
+ *  Clusters are rebuilt incrementally when dynamic navmesh tiles change.
+ */
+UCLASS()
+class UStrategyNavGraph : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Clusters, keyed by navmesh tile index */
+	TMap<uint32, FStrategyNavCluster> Clusters;
+
+	/** Portals, keyed by their cluster pair */
+	TMap<uint64, FStrategyNavPortal> Portals;
+
+	/** Navmesh the graph was built from */
+	TWeakObjectPtr<const ARecastNavMesh> GraphNavMesh;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Subscribes to navigation rebuild events */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+public:
+
+	/** Runs a coarse search between the two locations and returns the portal waypoints crossed on the way. Returns false if both ends are in the same cluster or no route exists */
+	bool FindRoute(const FVector& Start, const FVector& Goal, TArray<FVector>& OutWaypoints);
+
+	/** Returns the number of clusters units should refine with regular pathfinding at a time */
+	static int32 GetRefineClusterCount();
+
+	/** Returns true if hierarchical routes are enabled */
+	static bool IsEnabled();
+
+protected:
+
+	/** Builds the whole graph from the given navmesh */
+	void BuildGraph(const ARecastNavMesh* NavMesh);
+
+	/** Rebuilds a single cluster and its portals. Removes it if the tile is now empty */
+	void RebuildCluster(const ARecastNavMesh* NavMesh, uint32 TileIndex);
+
+	/** Removes a cluster and every portal touching it */
+	void RemoveCluster(uint32 TileIndex);
+
+	/** Returns the navmesh the graph should be built from, building it first if needed */
+	const ARecastNavMesh* GetGraphNavMesh();
+
+	/** Called when the navigation system finishes rebuilding dirty tiles */
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* NavData);
+
+	/** Makes the portal key for a pair of clusters */
+	static uint64 MakePortalKey(uint32 ClusterA, uint32 ClusterB);
+};
@@ -0,0 +1,433 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyOrderDispatcher.h"
+#include "StrategyUnit.h"
+#include "StrategyUnitRegistry.h"
+#include "StrategyNavGraph.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "HAL/IConsoleManager.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Order Dispatch"), STAT_StrategyOrderDispatch, STATGROUP_DreamEating);
+DECLARE_CYCLE_STAT(TEXT("Arrival Interactions"), STAT_StrategyArrivalInteractions, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Orders"), STAT_StrategyActiveOrders, STATGROUP_DreamEating);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Submitted"), STAT_StrategyPathQueriesSubmitted, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Queries In Flight"), STAT_StrategyPathQueriesInFlight, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Queries Pending"), STAT_StrategyPathQueriesPending, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Paths Rejected"), STAT_StrategyCachedPathRejections, STATGROUP_DreamEating);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Order Click To First Move (ms)"), STAT_StrategyOrderFirstMoveLatency, STATGROUP_DreamEating);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Order Click To First Path (ms)"), STAT_StrategyOrderFirstPathLatency, STATGROUP_DreamEating);
+
+static int32 GStrategyPathQueriesPerFrame = 32;
+static FAutoConsoleVariableRef CVarStrategyPathQueriesPerFrame(
+	TEXT("DreamEating.Strategy.PathQueriesPerFrame"),
+	GStrategyPathQueriesPerFrame,
+	TEXT("Max number of async path queries the Strategy order dispatcher submits per frame."),
+	ECVF_Default);
+
+bool UStrategyOrderDispatcher::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStrategyOrderDispatcher::Deinitialize()
+{
+	// abort any queries still in flight
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		for (const TPair<uint32, FStrategyPathRequest>& CurrentQuery : InFlightQueries)
+		{
+			NavSys->AbortAsyncFindPathRequest(CurrentQuery.Key);
+		}
+	}
+
+	InFlightQueries.Empty();
+	PendingRequests.Empty();
+	UnitOrders.Empty();
+	UnitQueries.Empty();
+	Orders.Empty();
+	PendingArrivals.Empty();
+
+	Super::Deinitialize();
+}
+
+void UStrategyOrderDispatcher::Tick(float DeltaTime)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyOrderDispatch);
+	DREAMEATING_PERF_SCOPE(AI);
+
+	// resolve last frame's arrivals
+	ResolveArrivals();
+
+	// retire orders nobody is executing anymore
+	for (auto It = Orders.CreateIterator(); It; ++It)
+	{
+		if (It.Value().ActiveParticipants <= 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// submit the next batch of queries
+	int32 Submitted = 0;
+
+	while (PendingHead < PendingRequests.Num() && Submitted < GStrategyPathQueriesPerFrame)
+	{
+		const FStrategyPathRequest& Request = PendingRequests[PendingHead];
+		++PendingHead;
+
+		// skip requests superseded by a newer order or for units that were destroyed
+		if (IsCurrent(Request))
+		{
+			SubmitQuery(Request);
+			++Submitted;
+		}
+	}
+
+	// recycle the queue once it's been drained
+	if (PendingHead >= PendingRequests.Num())
+	{
+		PendingRequests.Reset();
+		PendingHead = 0;
+	}
+
+	INC_DWORD_STAT_BY(STAT_StrategyPathQueriesSubmitted, Submitted);
+	SET_DWORD_STAT(STAT_StrategyPathQueriesInFlight, InFlightQueries.Num());
+	SET_DWORD_STAT(STAT_StrategyPathQueriesPending, PendingRequests.Num() - PendingHead);
+	SET_DWORD_STAT(STAT_StrategyActiveOrders, Orders.Num());
+}
+
+TStatId UStrategyOrderDispatcher::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStrategyOrderDispatcher, STATGROUP_Tickables);
+}
+
+uint32 UStrategyOrderDispatcher::BeginOrder(const FVector& Goal, float InteractionRadius, const FVector& RouteStart)
+{
+	// start tracking latency for the new order
+	LastOrderTime = FPlatformTime::Seconds();
+	bWaitingForFirstMove = true;
+	bWaitingForFirstPath = true;
+
+	++LastOrderID;
+
+	// start tracking the order's lifecycle
+	FStrategyOrder& Order = Orders.Add(LastOrderID);
+	Order.Goal = Goal;
+	Order.InteractionRadius = InteractionRadius;
+
+	// search the abstract graph once for the whole order, instead of once per unit
+	if (UStrategyNavGraph* NavGraph = GetWorld()->GetSubsystem<UStrategyNavGraph>())
+	{
+		NavGraph->FindRoute(RouteStart, Goal, Order.RouteWaypoints);
+	}
+
+	return LastOrderID;
+}
+
+void UStrategyOrderDispatcher::QueueMove(uint32 OrderID, AStrategyUnit* Unit, const FVector& Goal, float AcceptanceRadius, bool bIntentMove)
+{
+	if (!IsValid(Unit))
+	{
+		return;
+	}
+
+	// cancel anything left over from a previous order
+	CancelUnit(Unit);
+
+	// this is now the unit's current order
+	UnitOrders.Add(Unit, OrderID);
+
+	// follow the order's coarse route. Only its first segment needs a navmesh query
+	float SegmentAcceptanceRadius = AcceptanceRadius;
+	FVector SegmentGoal = Goal;
+
+	if (FStrategyOrder* Order = Orders.Find(OrderID))
+	{
+		Order->Participants.Add(Unit);
+		++Order->ActiveParticipants;
+
+		SegmentGoal = Unit->SetRoute(Order->RouteWaypoints, Goal, AcceptanceRadius, SegmentAcceptanceRadius);
+	}
+
+	// until the path arrives, the end of an earlier move, like the intent move, isn't an arrival
+	Unit->SetWaitingForPath(true);
+
+	// start moving in a straight line while we wait for the path
+	if (bIntentMove && Unit->MoveDirectlyToLocation(SegmentGoal, SegmentAcceptanceRadius))
+	{
+		NotifyUnitStartedMoving(OrderID, false);
+	}
+
+	// queue the path query
+	FStrategyPathRequest& Request = PendingRequests.AddDefaulted_GetRef();
+	Request.Unit = Unit;
+	Request.UnitKey = Unit;
+	Request.Goal = SegmentGoal;
+	Request.AcceptanceRadius = SegmentAcceptanceRadius;
+	Request.OrderID = OrderID;
+	Request.RouteSegment = Unit->GetRouteSegment();
+}
+
+void UStrategyOrderDispatcher::CancelUnit(AStrategyUnit* Unit)
+{
+	// forget the unit's order so any pending requests get skipped
+	uint32 PreviousOrderID = 0;
+
+	if (UnitOrders.RemoveAndCopyValue(Unit, PreviousOrderID))
+	{
+		if (FStrategyOrder* PreviousOrder = Orders.Find(PreviousOrderID))
+		{
+			--PreviousOrder->ActiveParticipants;
+		}
+	}
+
+	// abort the in flight query, if any
+	uint32 QueryID = 0;
+
+	if (UnitQueries.RemoveAndCopyValue(Unit, QueryID))
+	{
+		InFlightQueries.Remove(QueryID);
+
+		if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavSys->AbortAsyncFindPathRequest(QueryID);
+		}
+	}
+}
+
+void UStrategyOrderDispatcher::NotifyUnitArrived(AStrategyUnit* Unit)
+{
+	// ignore units that aren't executing an order
+	uint32 OrderID = 0;
+
+	if (!UnitOrders.RemoveAndCopyValue(Unit, OrderID))
+	{
+		return;
+	}
+
+	if (FStrategyOrder* Order = Orders.Find(OrderID))
+	{
+		Order->Arrived.Add(Unit);
+		--Order->ActiveParticipants;
+	}
+
+	// resolve interactions on the next pass
+	FStrategyArrival& Arrival = PendingArrivals.AddDefaulted_GetRef();
+	Arrival.Unit = Unit;
+	Arrival.OrderID = OrderID;
+}
+
+bool UStrategyOrderDispatcher::IsCurrent(const FStrategyPathRequest& Request) const
+{
+	const AStrategyUnit* Unit = Request.Unit.Get();
+
+	if (!IsValid(Unit))
+	{
+		return false;
+	}
+
+	const uint32* CurrentOrder = UnitOrders.Find(Unit);
+	return CurrentOrder && *CurrentOrder == Request.OrderID && Unit->GetRouteSegment() == Request.RouteSegment;
+}
+
+void UStrategyOrderDispatcher::SubmitQuery(FStrategyPathRequest Request)
+{
+	AStrategyUnit* Unit = Request.Unit.Get();
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	// build the query through the unit's AI controller so it uses the same filter and agent as a regular move
+	FPathFindingQuery Query;
+
+	if (!NavSys || !Unit->BuildPathQuery(Request.Goal, Request.AcceptanceRadius, Query))
+	{
+		UE_LOG(LogDreamEating, Verbose, TEXT("Could not build a path query for %s"), *GetNameSafe(Unit));
+
+		// end the move so the order doesn't wait on this unit forever
+		Unit->AbortMove();
+		return;
+	}
+
+	// try the path cache before going async
+	UDreamEatingPathCache* PathCache = GetWorld()->GetSubsystem<UDreamEatingPathCache>();
+	const ANavigationData* NavData = Query.NavData.Get();
+
+	if (PathCache && NavData)
+	{
+		Request.bCacheResult = PathCache->MakeKey(*NavData, Query.StartLocation, Query.EndLocation, Unit->GetNavigationFilterClass(), Request.CacheKey);
+
+		if (Request.bCacheResult)
+		{
+			FNavPathSharedPtr CachedPath = PathCache->FindPath(*NavData, Request.CacheKey, Query.StartLocation, Query.EndLocation, Query.QueryFilter, Query.Owner.Get());
+
+			if (CachedPath.IsValid())
+			{
+				if (Unit->FollowPath(CachedPath, Request.Goal, Request.AcceptanceRadius))
+				{
+					NotifyUnitStartedMoving(Request.OrderID, true);
+					return;
+				}
+
+				// the unit's path following, e.g. crowd following, wouldn't take the cached path. Fall back to a full query instead of stranding the unit
+				++CachedPathRejections;
+				INC_DWORD_STAT(STAT_StrategyCachedPathRejections);
+
+				UE_LOG(LogDreamEating, Warning, TEXT("%s rejected a cached path, running a full path query instead"), *GetNameSafe(Unit));
+			}
+		}
+	}
+
+	Request.SubmitTime = FPlatformTime::Seconds();
+
+	const uint32 QueryID = NavSys->FindPathAsync(Unit->GetNavAgentPropertiesRef(), Query, FNavPathQueryDelegate::CreateUObject(this, &UStrategyOrderDispatcher::OnPathQueryFinished), EPathFindingMode::Regular);
+
+	if (QueryID == INVALID_NAVQUERYID)
+	{
+		UE_LOG(LogDreamEating, Verbose, TEXT("Could not submit a path query for %s"), *GetNameSafe(Unit));
+
+		// end the move so the order doesn't wait on this unit forever
+		Unit->AbortMove();
+		return;
+	}
+
+	InFlightQueries.Add(QueryID, Request);
+	UnitQueries.Add(Unit, QueryID);
+
+	++TotalPathQueries;
+}
+
+void UStrategyOrderDispatcher::OnPathQueryFinished(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FStrategyPathRequest Request;
+
+	// ignore queries we've already cancelled
+	if (!InFlightQueries.RemoveAndCopyValue(QueryID, Request))
+	{
+		return;
+	}
+
+	// forget the query even if the unit is gone, so destroyed units don't leave stale entries
+	UnitQueries.Remove(Request.UnitKey);
+
+	AStrategyUnit* Unit = Request.Unit.Get();
+
+	if (!IsValid(Unit))
+	{
+		return;
+	}
+
+	// share the result with future orders between the same tiles
+	if (Result == ENavigationQueryResult::Success && Request.bCacheResult)
+	{
+		if (UDreamEatingPathCache* PathCache = GetWorld()->GetSubsystem<UDreamEatingPathCache>())
+		{
+			// credit future hits with how long this query kept the unit waiting
+			PathCache->StorePath(Request.CacheKey, Path, (FPlatformTime::Seconds() - Request.SubmitTime) * 1000.0);
+		}
+	}
+
+	// skip if a newer order has been issued to this unit, or it has moved on to another route segment in the meantime
+	if (!IsCurrent(Request))
+	{
+		return;
+	}
+
+	// start following the path
+	if (Result == ENavigationQueryResult::Success && Unit->FollowPath(Path, Request.Goal, Request.AcceptanceRadius))
+	{
+		NotifyUnitStartedMoving(Request.OrderID, true);
+		return;
+	}
+
+	// no path to the goal. End the move as if the unit had arrived, so it retires from the order
+	// and listeners waiting on OnMoveCompleted don't hang
+	UE_LOG(LogDreamEating, Verbose, TEXT("No path for %s, ending its move"), *GetNameSafe(Unit));
+
+	Unit->AbortMove();
+}
+
+void UStrategyOrderDispatcher::ResolveArrivals()
+{
+	if (PendingArrivals.IsEmpty())
+	{
+		return;
+	}
+
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyArrivalInteractions);
+	DREAMEATING_PERF_SCOPE(AI);
+
+	UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>();
+	TArray<AStrategyUnit*> NearbyUnits;
+
+	for (const FStrategyArrival& Arrival : PendingArrivals)
+	{
+		AStrategyUnit* Unit = Arrival.Unit.Get();
+		FStrategyOrder* Order = Orders.Find(Arrival.OrderID);
+
+		// only the first unit to arrive gets to interact
+		if (!IsValid(Unit) || !Order || !Order->bAllowInteraction)
+		{
+			continue;
+		}
+
+		Order->bAllowInteraction = false;
+
+		// is the unit close enough to the goal?
+		if (!Registry || FVector::Dist2D(Order->Goal, Unit->GetActorLocation()) >= Order->InteractionRadius)
+		{
+			continue;
+		}
+
+		// find the units within reach of the goal
+		NearbyUnits.Reset();
+		Registry->QueryUnitsInRadius(Order->Goal, Order->InteractionRadius + Registry->GetMaxInteractionReach(), NearbyUnits);
+
+		for (AStrategyUnit* NearbyUnit : NearbyUnits)
+		{
+			// skip the units that took part in this order
+			if (Order->Participants.Contains(NearbyUnit))
+			{
+				continue;
+			}
+
+			if (FVector::Dist2D(Order->Goal, NearbyUnit->GetActorLocation()) <= Order->InteractionRadius + NearbyUnit->GetInteractionReach())
+			{
+				NearbyUnit->Interact(Unit);
+				++TotalInteractions;
+			}
+		}
+	}
+
+	PendingArrivals.Reset();
+}
+
+void UStrategyOrderDispatcher::NotifyUnitStartedMoving(uint32 OrderID, bool bFollowingPath)
+{
+	// only track latency for the last order
+	if (OrderID != LastOrderID)
+	{
+		return;
+	}
+
+	const float Latency = static_cast<float>((FPlatformTime::Seconds() - LastOrderTime) * 1000.0);
+
+	if (bWaitingForFirstMove)
+	{
+		bWaitingForFirstMove = false;
+		LastFirstMoveLatency = Latency;
+
+		SET_FLOAT_STAT(STAT_StrategyOrderFirstMoveLatency, Latency);
+	}
+
+	if (bFollowingPath && bWaitingForFirstPath)
+	{
+		bWaitingForFirstPath = false;
+		LastFirstPathLatency = Latency;
+
+		SET_FLOAT_STAT(STAT_StrategyOrderFirstPathLatency, Latency);
+	}
+}
@@ -0,0 +1,221 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationSystemTypes.h"
+#include "UObject/ObjectKey.h"
+#include "DreamEatingPathCache.h"
+#include "StrategyOrderDispatcher.generated.h"
+
+class AStrategyUnit;
+
+/**
+ *  A single unit move waiting for, or waiting on, an async path query
+ */
+struct FStrategyPathRequest
+{
+	/** Unit that will follow the path */
+	TWeakObjectPtr<AStrategyUnit> Unit;
+
+	/** Key of the unit, still valid after the unit is destroyed */
+	TObjectKey<AStrategyUnit> UnitKey;
+
+	/** World location the unit is moving to */
+	FVector Goal = FVector::ZeroVector;
+
+	/** Acceptance radius for the move */
+	float AcceptanceRadius = 0.0f;
+
+	/** Order this move belongs to */
+	uint32 OrderID = 0;
+
+	/** Unit route segment this move is for. Results for a segment the unit has moved past are dropped */
+	uint32 RouteSegment = 0;
+
+	/** Path cache key for this move */
+	FDreamEatingPathCacheKey CacheKey;
+
+	/** If true, the path result should be stored in the path cache */
+	bool bCacheResult = false;
+
+	/** Platform time the async query was submitted */
+	double SubmitTime = 0.0;
+};
+
+/**
+ *  Lifecycle of a single move order
+ */
+struct FStrategyOrder
+{
+	/** World location the order was issued to */
+	FVector Goal = FVector::ZeroVector;
+
+	/** Radius around the goal where the first arriving unit interacts with other units */
+	float InteractionRadius = 0.0f;
+
+	/** If true, the next unit to arrive may still trigger an interaction */
+	bool bAllowInteraction = true;
+
+	/** Coarse route to the goal, planned once for the whole order and shared by every participant */
+	TArray<FVector> RouteWaypoints;
+
+	/** Units that received this order */
+	TSet<TObjectKey<AStrategyUnit>> Participants;
+
+	/** Participants that have arrived */
+	TSet<TObjectKey<AStrategyUnit>> Arrived;
+
+	/** Number of participants still executing this order */
+	int32 ActiveParticipants = 0;
+};
+
+/**
+ *  A unit arrival waiting to be resolved
+ */
+struct FStrategyArrival
+{
+	/** Unit that arrived */
+	TWeakObjectPtr<AStrategyUnit> Unit;
+
+	/** Order the unit was executing */
+	uint32 OrderID = 0;
+};
+
+/**
+ *  Dispatches Strategy unit move orders to the navigation system's async query path.
+ *  Path queries are submitted in fixed size batches each frame, and units start
+ *  following their paths as the results arrive.
+ *  Moves between navmesh tiles already in the path cache skip the query entirely.
+ *  Issuing a new order to a unit cancels any query still pending from an older order.
+ *  Also tracks each order's participants and arrivals, and resolves arrival interactions
+ *  in a single batched proximity pass per frame.
+ */
+UCLASS()
+class UStrategyOrderDispatcher : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Moves waiting to be submitted to the navigation system */
+	TArray<FStrategyPathRequest> PendingRequests;
+
+	/** Index of the next pending request to submit */
+	int32 PendingHead = 0;
+
+	/** Moves with a path query in flight, keyed by async query ID */
+	TMap<uint32, FStrategyPathRequest> InFlightQueries;
+
+	/** Latest order issued to each unit */
+	TMap<TObjectKey<AStrategyUnit>, uint32> UnitOrders;
+
+	/** In flight async query for each unit */
+	TMap<TObjectKey<AStrategyUnit>, uint32> UnitQueries;
+
+	/** Orders with participants still executing them */
+	TMap<uint32, FStrategyOrder> Orders;
+
+	/** Arrivals waiting for the next interaction pass */
+	TArray<FStrategyArrival> PendingArrivals;
+
+	/** ID of the last order issued */
+	uint32 LastOrderID = 0;
+
+	/** Platform time when the last order was issued */
+	double LastOrderTime = 0.0;
+
+	/** If true, we're still waiting for any unit in the last order to start moving */
+	bool bWaitingForFirstMove = false;
+
+	/** If true, we're still waiting for the first path result of the last order */
+	bool bWaitingForFirstPath = false;
+
+	/** Click to first movement latency of the last order, in milliseconds */
+	float LastFirstMoveLatency = 0.0f;
+
+	/** Click to first path following latency of the last order, in milliseconds */
+	float LastFirstPathLatency = 0.0f;
+
+	/** Total number of path queries submitted since initialization */
+	int32 TotalPathQueries = 0;
+
+	/** Number of cached paths a unit's path following refused since initialization. Should stay at zero */
+	int32 CachedPathRejections = 0;
+
+	/** Total number of arrival interactions since initialization */
+	int32 TotalInteractions = 0;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+	/** Resolves arrivals and submits the next batch of pending path queries */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Starts a new order to the given goal and returns its ID. Plans the order's coarse route from RouteStart. Must be called before queueing the order's moves */
+	uint32 BeginOrder(const FVector& Goal, float InteractionRadius, const FVector& RouteStart);
+
+	/** Queues a unit move for the given order. Supersedes any move still pending for this unit. Optionally starts a straight line intent move right away */
+	void QueueMove(uint32 OrderID, AStrategyUnit* Unit, const FVector& Goal, float AcceptanceRadius, bool bIntentMove);
+
+	/** Cancels any pending or in flight move for the given unit */
+	void CancelUnit(AStrategyUnit* Unit);
+
+	/** Records that a unit has finished executing its current order */
+	void NotifyUnitArrived(AStrategyUnit* Unit);
+
+	/** Returns true if the unit is still executing an order */
+	bool IsExecutingOrder(const AStrategyUnit* Unit) const { return UnitOrders.Contains(Unit); }
+
+	/** Returns the order with the given ID, if it still has active participants */
+	const FStrategyOrder* FindOrder(uint32 OrderID) const { return Orders.Find(OrderID); }
+
+	/** Returns true if no unit in the last order has started moving yet */
+	bool IsWaitingForFirstMove() const { return bWaitingForFirstMove; }
+
+	/** Returns true if no unit in the last order has started following a path yet */
+	bool IsWaitingForFirstPath() const { return bWaitingForFirstPath; }
+
+	/** Returns the click to first movement latency of the last order, in milliseconds */
+	float GetLastFirstMoveLatency() const { return LastFirstMoveLatency; }
+
+	/** Returns the click to first path following latency of the last order, in milliseconds */
+	float GetLastFirstPathLatency() const { return LastFirstPathLatency; }
+
+	/** Returns the total number of path queries submitted */
+	int32 GetTotalPathQueries() const { return TotalPathQueries; }
+
+	/** Returns the number of cached paths a unit's path following refused */
+	int32 GetCachedPathRejections() const { return CachedPathRejections; }
+
+	/** Returns the total number of arrival interactions */
+	int32 GetTotalInteractions() const { return TotalInteractions; }
+
+protected:
+
+	/** Returns true if the request still belongs to the latest order issued to its unit, and to the segment the unit is on */
+	bool IsCurrent(const FStrategyPathRequest& Request) const;
+
+	/** Submits an async path query for the given request */
+	void SubmitQuery(FStrategyPathRequest Request);
+
+	/** Called by the navigation system when an async path query finishes */
+	void OnPathQueryFinished(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/** Resolves the interactions for every arrival since the last frame */
+	void ResolveArrivals();
+
+	/** Updates the latency stats after a unit from the last order starts moving */
+	void NotifyUnitStartedMoving(uint32 OrderID, bool bFollowingPath);
+};
@@ -15,7 +15,18 @@
 #include "Kismet/GameplayStatics.h"
 #include "StrategyUnit.h"
 #include "NavigationSystem.h"
-#include "Engine/OverlapResult.h"
+#include "StrategyOrderDispatcher.h"
+#include "StrategyFogOfWar.h"
+#include "DreamEatingGroundGrid.h"
+#include "DreamEatingSceneQueries.h"
+#include "DreamEatingEffects.h"
+#include "DreamEatingDeterminism.h"
+#include "DreamEatingFormation.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEatingHitchMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Move Units Command"), STAT_StrategyMoveUnitsCommand, STATGROUP_DreamEating);
 
 AStrategyPlayerController::AStrategyPlayerController()
 {
@@ -72,7 +83,6 @@ void AStrategyPlayerController::SetupInputComponent()
 			EnhancedInputComponent->BindAction(InteractHoldAction, ETriggerEvent::Started, this, &AStrategyPlayerController::InteractHoldStarted);
 			EnhancedInputComponent->BindAction(InteractHoldAction, ETriggerEvent::Triggered, this, &AStrategyPlayerController::InteractHoldTriggered);
 
-			EnhancedInputComponent->BindAction(InteractClickAction, ETriggerEvent::Started, this, &AStrategyPlayerController::InteractClickStarted);
 			EnhancedInputComponent->BindAction(InteractClickAction, ETriggerEvent::Completed, this, &AStrategyPlayerController::InteractClickCompleted);
 
 			// Touch Interaction
@@ -105,6 +115,9 @@ void AStrategyPlayerController::OnPossess(APawn* InPawn)
 	// cast the HUD pointer
 	StrategyHUD = Cast<AStrategyHUD>(GetHUD());
 	check(StrategyHUD);
+
+	// find the fog of war so selection can skip hidden units
+	FogOfWar = Cast<AStrategyFogOfWar>(UGameplayStatics::GetActorOfClass(GetWorld(), AStrategyFogOfWar::StaticClass()));
 }
 
 void AStrategyPlayerController::DragSelectUnits(const TArray<AStrategyUnit*>& Units)
@@ -118,8 +131,15 @@ void AStrategyPlayerController::DragSelectUnits(const TArray<AStrategyUnit*>& Un
 		// select each new unit
 		for (AStrategyUnit* CurrentUnit : Units)
 		{
+			// skip units hidden by the fog of war
+			if (!CanSelectUnit(CurrentUnit))
+			{
+				continue;
+			}
+
 			// add the unit to the selection list
 			ControlledUnits.Add(CurrentUnit);
+			++SelectionVersion;
 
 			// select the unit
 			CurrentUnit->UnitSelected();
@@ -129,7 +149,7 @@ void AStrategyPlayerController::DragSelectUnits(const TArray<AStrategyUnit*>& Un
 
 const TArray<AStrategyUnit*>& AStrategyPlayerController::GetSelectedUnits()
 {
-	return ControlledUnits;
+	return ControlledUnits.GetItems();
 }
 
 void AStrategyPlayerController::MoveCamera(const FInputActionValue& Value)
@@ -233,13 +253,6 @@ void AStrategyPlayerController::InteractHoldTriggered(const FInputActionValue& V
 	DoDragScrollCommand();
 }
 
-void AStrategyPlayerController::InteractClickStarted(const FInputActionValue& Value)
-{
-
-	// reset the interaction flag
-	ResetInteraction();
-}
-
 void AStrategyPlayerController::InteractClickCompleted(const FInputActionValue& Value)
 {
 
@@ -346,8 +359,6 @@ void AStrategyPlayerController::DoSelectionCommand()
 {
 
 	// do a sphere sweep to look for actors to select
-	FHitResult OutHit;
-
 	const FVector Start = CachedSelection;
 	const FVector End = Start + FVector::UpVector * 350.0f;
 
@@ -362,22 +373,48 @@ void AStrategyPlayerController::DoSelectionCommand()
 	QueryParams.AddIgnoredActor(GetPawn());
 	QueryParams.bTraceComplex = true;
 
-	GetWorld()->SweepSingleByObjectType(OutHit, Start, End, FQuat::Identity, ObjectParams, InteractionSphere, QueryParams);
-
 	// if we're using the mouse and are not holding the selection modifier key, deselect any units first
-	if (InputMode == SIM_Mouse && !bSelectionModifier)
+	const bool bDeselectFirst = InputMode == SIM_Mouse && !bSelectionModifier;
+
+	// mouse selection can wait a frame, so let the sweep run with the async trace batch.
+	// A touch tap that misses every unit is a move command, so it runs right away to act on the frame it's issued
+	const EDreamEatingQueryLatency Latency = InputMode == SIM_Touch ? EDreamEatingQueryLatency::Immediate : EDreamEatingQueryLatency::NextFrame;
+
+	if (UDreamEatingSceneQueries* SceneQueries = GetWorld()->GetSubsystem<UDreamEatingSceneQueries>())
+	{
+		SceneQueries->SweepByObjectType(Latency, Start, End, ObjectParams, InteractionSphere, QueryParams,
+			FDreamEatingQueryDelegate::CreateUObject(this, &AStrategyPlayerController::OnSelectionSweepFinished, bDeselectFirst));
+	}
+	else
+	{
+		FHitResult OutHit;
+		const bool bHit = GetWorld()->SweepSingleByObjectType(OutHit, Start, End, FQuat::Identity, ObjectParams, InteractionSphere, QueryParams);
+
+		OnSelectionSweepFinished(bHit, OutHit, bDeselectFirst);
+	}
+}
+
+void AStrategyPlayerController::OnSelectionSweepFinished(bool bBlockingHit, const FHitResult& OutHit, bool bDeselectFirst)
+{
+	if (bDeselectFirst)
 	{
 
 		DoDeselectAllCommand();
 	}
 
 	// did we hit a unit?
-	if (OutHit.bBlockingHit)
+	if (bBlockingHit)
 	{
 
 		// update the target unit
 		TargetUnit = Cast<AStrategyUnit>(OutHit.GetActor());
 
+		// ignore units hidden by the fog of war
+		if (TargetUnit && !CanSelectUnit(TargetUnit))
+		{
+			TargetUnit = nullptr;
+		}
+
 		if (TargetUnit)
 		{
 
@@ -387,6 +424,7 @@ void AStrategyPlayerController::DoSelectionCommand()
 
 				// remove the units from the controlled list
 				ControlledUnits.Remove(TargetUnit);
+				++SelectionVersion;
 
 				// tell the unit it's been deselected
 				TargetUnit->UnitDeselected();
@@ -396,6 +434,7 @@ void AStrategyPlayerController::DoSelectionCommand()
 
 				// add the unit to the controlled list
 				ControlledUnits.Add(TargetUnit);
+				++SelectionVersion;
 
 				// tell the unit it's been selected
 				TargetUnit->UnitSelected();
@@ -439,8 +478,8 @@ void AStrategyPlayerController::DoSelectAllOnScreenCommand()
 		// cast back to our unit class
 		if (AStrategyUnit* CurrentUnit = Cast<AStrategyUnit>(CurrentActor))
 		{
-			// has the actor been recently rendered?
-			if (CurrentActor->WasRecentlyRendered(0.2f))
+			// has the actor been recently rendered, and is it visible through the fog of war?
+			if (CurrentActor->WasRecentlyRendered(0.2f) && CanSelectUnit(CurrentUnit))
 			{
 
 				// is the actor not on our controlled units list?
@@ -448,6 +487,7 @@ void AStrategyPlayerController::DoSelectAllOnScreenCommand()
 				{
 					// add it to the controlled units list
 					ControlledUnits.Add(CurrentUnit);
+					++SelectionVersion;
 
 					// notify it of selection
 					CurrentUnit->UnitSelected();
@@ -473,7 +513,8 @@ void AStrategyPlayerController::DoDeselectAllCommand()
 	}
 
 	// clear the controlled units list
-	ControlledUnits.Empty();
+	ControlledUnits.Reset();
+	++SelectionVersion;
 }
 
 void AStrategyPlayerController::DoDragScrollCommand()
@@ -510,6 +551,8 @@ void AStrategyPlayerController::DoDragScrollCommand()
 
 void AStrategyPlayerController::DoMoveUnitsCommand()
 {
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyMoveUnitsCommand);
+	DREAMEATING_PERF_SCOPE(Selection);
 
 	// set the movement goal
 	FVector CurrentMoveGoal;
@@ -531,8 +574,25 @@ void AStrategyPlayerController::DoMoveUnitsCommand()
 	// get the closest selected unit to the move goal. This will be our lead unit
 	AStrategyUnit* Closest = GetClosestSelectedUnitToLocation(CurrentMoveGoal);
 
-	// this will be set to true if any of the move requests fail
-	bool bInteractionFailed = false;
+	// path queries are batched and resolved asynchronously by the order dispatcher,
+	// so check that the goal is reachable up front to decide on the cursor feedback
+	FNavLocation ProjectedGoal;
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	const bool bInteractionFailed = !NavSys || !NavSys->ProjectPointToNavigation(CurrentMoveGoal, ProjectedGoal);
+
+	// start a new order. This supersedes any moves still pending for these units,
+	// and lets the first unit to arrive interact with other units around the goal
+	UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>();
+	check(Dispatcher);
+
+	// the coarse route is planned once from the lead unit and shared by the whole group
+	const uint32 OrderID = Dispatcher->BeginOrder(CurrentMoveGoal, InteractionRadius, IsValid(Closest) ? Closest->GetNavAgentLocation() : CurrentMoveGoal);
+
+	FDreamEatingGameplayEvents::Record(EDreamEatingGameplayEvent::Order, ControlledUnits.Num(), CurrentMoveGoal);
+
+	// scatter points come from a seeded stream so orders replay the same way in deterministic runs
+	FRandomStream& ScatterStream = UDreamEatingDeterminism::GetRandomStream(this, EDreamEatingRandomStream::StrategyScatter);
 
 	// process each unit in the controlled list
 	for (AStrategyUnit* CurrentUnit : ControlledUnits)
@@ -549,119 +609,61 @@ void AStrategyPlayerController::DoMoveUnitsCommand()
 			if (CurrentUnit != Closest)
 			{
 
-				UNavigationSystemV1::K2_GetRandomLocationInNavigableRadius(GetWorld(), CurrentMoveGoal, MoveGoal, InteractionRadius * 0.66f);
-			}
-
-			// subscribe to the unit's move completed delegate
-			CurrentUnit->OnMoveCompleted.AddDynamic(this, &AStrategyPlayerController::OnMoveCompleted);
+				FNavLocation ScatterGoal;
 
-			// set up movement to the goal location
-			if (!CurrentUnit->MoveToLocation(MoveGoal, InteractionRadius * 0.66f))
-			{
-				// the move request failed, so flag it
-				bInteractionFailed = true;
+				if (NavSys && NavSys->ProjectPointToNavigation(FDreamEatingFormation::SampleDisc(ScatterStream, CurrentMoveGoal, InteractionRadius * 0.66f), ScatterGoal))
+				{
+					MoveGoal = ScatterGoal.Location;
+				}
 			}
+
+			// queue the move on the dispatcher
+			Dispatcher->QueueMove(OrderID, CurrentUnit, MoveGoal, InteractionRadius * 0.66f, bUseIntentMoves);
 		}
 
 	}
 
 	// play the cursor feedback depending on whether our move succeeded or not
+	if (UDreamEatingEffects* Effects = GetWorld()->GetSubsystem<UDreamEatingEffects>())
+	{
+		Effects->SpawnEffect(bInteractionFailed ? NegativeCursorFX : PositiveCursorFX, CachedInteraction, FRotator::ZeroRotator, FVector(1.0f, 1.0f, 1.0f), EDreamEatingEffectPriority::Feedback);
+	}
+
 	BP_CursorFeedback(CachedInteraction, !bInteractionFailed);
 
 }
 
-void AStrategyPlayerController::OnMoveCompleted(AStrategyUnit* MovedUnit)
+void AStrategyPlayerController::MoveSelectedUnitsTo(const FVector& Goal)
 {
-	// is the unit valid?
-	if (IsValid(MovedUnit))
-	{
-		// unsubscribe from the delegate
-		MovedUnit->OnMoveCompleted.RemoveDynamic(this, &AStrategyPlayerController::OnMoveCompleted);
-		
-		// skip if interactions are locked
-		if (!bAllowInteraction)
-		{
-			return;
-		}
-
-		// disallow additional interactions until we reset
-		bAllowInteraction = false;
-
-		// is the unit close enough to the cached interaction location?
-		if(FVector::Dist2D(CachedInteraction, MovedUnit->GetActorLocation()) < InteractionRadius)
-		{
-
-			// do an overlap test to find nearby interactive objects
-			TArray<FOverlapResult> OutOverlaps;
-
-			FCollisionShape CollisionSphere;
-			CollisionSphere.SetSphere(InteractionRadius);
-
-			FCollisionObjectQueryParams ObjectParams;
-			ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
-			
-			FCollisionQueryParams QueryParams;
+	// the move command reads its goal from the cached input location for the current input mode
+	CachedInteraction = Goal;
+	CachedSelection = Goal;
 
-			QueryParams.AddIgnoredActor(MovedUnit);
-
-			for(const AStrategyUnit* CurSelected : ControlledUnits)
-			{
-				QueryParams.AddIgnoredActor(CurSelected);
-			}
+	DoMoveUnitsCommand();
+}
 
-			if (GetWorld()->OverlapMultiByObjectType(OutOverlaps, CachedInteraction, FQuat::Identity, ObjectParams, CollisionSphere, QueryParams))
-			{
-				for (const FOverlapResult& CurrentOverlap : OutOverlaps)
-				{
-					if (AStrategyUnit* CurrentUnit = Cast<AStrategyUnit>(CurrentOverlap.GetActor()))
-					{
-						CurrentUnit->Interact(MovedUnit);
-					}
-				}
-			}
-		}
-	}
+bool AStrategyPlayerController::CanSelectUnit(const AStrategyUnit* Unit) const
+{
+	// without a fog of war, every unit is visible
+	return !FogOfWar || FogOfWar->IsUnitVisible(TeamIndex, Unit);
 }
 
 AStrategyUnit* AStrategyPlayerController::GetClosestSelectedUnitToLocation(FVector TargetLocation)
 {
-	// closest unit and distance
-	AStrategyUnit* OutUnit = nullptr;
-	float Closest = 0.0f;
-
-	// process each unit on the list
-	for (AStrategyUnit* CurrentUnit : ControlledUnits)
+	// find the closest unit on the list, skipping destroyed ones
+	const int32 ClosestIndex = FDreamEatingSelection::FindClosest2D(TConstArrayView<AStrategyUnit*>(ControlledUnits.GetItems()), TargetLocation, [](AStrategyUnit* CurrentUnit, FVector& OutLocation)
 	{
-		if (CurrentUnit != nullptr)
+		if (CurrentUnit == nullptr)
 		{
-			// have we selected a unit already?
-			if (OutUnit != nullptr)
-			{
-				// calculate the squared distance to the target location
-				float Dist = FVector::DistSquared2D(TargetLocation, CurrentUnit->GetActorLocation());
-
-				// is this unit closer?
-				if (Dist < Closest)
-				{
-					// update the closest unit and distance
-					OutUnit = CurrentUnit;
-					Closest = Dist;
-				}
-
-			} else {
-
-				// no previously selected unit, so use this one
-				OutUnit = CurrentUnit;
-
-				// initialize the closest distance
-				Closest = FVector::DistSquared2D(TargetLocation, CurrentUnit->GetActorLocation());
-			}
+			return false;
 		}
-		
-	}
+
+		OutLocation = CurrentUnit->GetActorLocation();
+		return true;
+	});
 
 	// return the selected unit
-	return OutUnit;
+	return ClosestIndex != INDEX_NONE ? ControlledUnits.GetItems()[ClosestIndex] : nullptr;
 }
 
 FVector2D AStrategyPlayerController::GetMouseLocation()
@@ -680,6 +682,33 @@ FVector2D AStrategyPlayerController::GetMouseLocation()
 
 bool AStrategyPlayerController::GetLocationUnderCursor(FVector& Location)
 {
+	// use the baked ground grid if the level has one
+	if (UDreamEatingGroundGrid* GroundGrid = GetWorld()->GetSubsystem<UDreamEatingGroundGrid>())
+	{
+		if (GroundGrid->GetGroundUnderCursor(this, Location))
+		{
+			return true;
+		}
+	}
+
+	// commands need their location this frame, so trace immediately
+	if (UDreamEatingSceneQueries* SceneQueries = GetWorld()->GetSubsystem<UDreamEatingSceneQueries>())
+	{
+		bool bHit = false;
+
+		SceneQueries->TraceUnderCursor(EDreamEatingQueryLatency::Immediate, this, UEngineTypes::ConvertToCollisionChannel(SelectionTraceChannel), true,
+			FDreamEatingQueryDelegate::CreateLambda([&Location, &bHit](bool bBlockingHit, const FHitResult& OutHit)
+			{
+				if (bBlockingHit)
+				{
+					Location = OutHit.Location;
+					bHit = true;
+				}
+			}));
+
+		return bHit;
+	}
+
 	// trace the visibility channel at the cursor location
 	FHitResult OutHit;
 
@@ -703,6 +732,17 @@ FVector AStrategyPlayerController::ProjectTouchPointToWorldSpace()
 
 	GetInputTouchState(ETouchIndex::Touch1, TouchX, TouchY, bPressed);
 
+	// use the baked ground grid if the level has one, so uneven ground projects correctly
+	if (UDreamEatingGroundGrid* GroundGrid = GetWorld()->GetSubsystem<UDreamEatingGroundGrid>())
+	{
+		FVector GroundLocation;
+
+		if (GroundGrid->GetGroundUnderScreenPosition(this, FVector2D(TouchX, TouchY), GroundLocation))
+		{
+			return GroundLocation;
+		}
+	}
+
 	FVector WorldLocation = FVector::ZeroVector;
 	FVector WorldDirection = FVector::ZeroVector;
 
@@ -718,8 +758,3 @@ FVector AStrategyPlayerController::ProjectTouchPointToWorldSpace()
 	// failed to deproject, return a zero vector
 	return FVector::ZeroVector;
 }
-
-void AStrategyPlayerController::ResetInteraction()
-{
-	bAllowInteraction = true;
-}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "DreamEatingSelection.h"
 #include "StrategyPlayerController.generated.h"
 
 class AStrategyPawn;
@@ -12,6 +13,7 @@ class UNiagaraSystem;
 struct FInputActionValue;
 class AStrategyHUD;
 class AStrategyNPC;
+class AStrategyFogOfWar;
 class UInputAction;
 
 /** Enum to determine the last used input type */
@@ -58,9 +60,6 @@ protected:
 	/** If true, double-tap touch select all mode is active */
 	bool bDoubleTapActive = false;
 
-	/** If true, allow the player to interact with game objects */
-	bool bAllowInteraction = true;
-
 	/** Input Action for moving the camera */
 	UPROPERTY(EditAnywhere, Category="Input")
 	UInputAction* MoveCameraAction;
@@ -160,6 +159,25 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Camera", meta = (ClampMin = 0, ClampMax = 10000))
 	float DragMultiplier = 0.1f;
 
+	/** Effect to spawn at the cursor when a move or interaction command succeeds */
+	UPROPERTY(EditAnywhere, Category="Cursor")
+	UNiagaraSystem* PositiveCursorFX;
+
+	/** Effect to spawn at the cursor when a move or interaction command fails */
+	UPROPERTY(EditAnywhere, Category="Cursor")
+	UNiagaraSystem* NegativeCursorFX;
+
+	/** If true, units start a straight line move towards their goal while their path is being computed */
+	UPROPERTY(EditAnywhere, Category="Movement")
+	bool bUseIntentMoves = true;
+
+	/** Team this player controls. Units hidden from this team by the fog of war can't be selected */
+	UPROPERTY(EditAnywhere, Category = "Selection", meta = (ClampMin = 0))
+	int32 TeamIndex = 0;
+
+	/** Fog of war in the level, if any */
+	TObjectPtr<AStrategyFogOfWar> FogOfWar;
+
 	/** Trace channel to use for selection trace checks */
 	UPROPERTY(EditAnywhere, Category = "Selection")
 	TEnumAsByte<ETraceTypeQuery> SelectionTraceChannel;
@@ -168,7 +186,10 @@ protected:
 	AStrategyUnit* TargetUnit = nullptr;
 
 	/** Currently selected unit list */
-	TArray<AStrategyUnit*> ControlledUnits;
+	TDreamEatingSelectionSet<AStrategyUnit*> ControlledUnits;
+
+	/** Incremented every time the selected unit list changes */
+	uint32 SelectionVersion = 0;
 
 public:
 
@@ -189,6 +210,18 @@ public:
 	/** Passes the list of selected units */
 	const TArray<AStrategyUnit*>& GetSelectedUnits();
 
+	/** Returns a counter that changes every time the selected unit list changes */
+	uint32 GetSelectionVersion() const { return SelectionVersion; }
+
+	/** Selects every unit on screen, as the select all input does. Used by benchmarks and scripted input */
+	void SelectAllOnScreen() { DoSelectAllOnScreenCommand(); }
+
+	/** Deselects every unit, as the deselect input does. Used by benchmarks and scripted input */
+	void DeselectAll() { DoDeselectAllCommand(); }
+
+	/** Orders the selected units to the given location, as an interaction click there does. Used by benchmarks and scripted input */
+	void MoveSelectedUnitsTo(const FVector& Goal);
+
 protected:
 
 	/** Moves the camera by the given input */
@@ -221,9 +254,6 @@ protected:
 	/** Interaction hold input triggered */
 	void InteractHoldTriggered(const FInputActionValue& Value);
 
-	/** Interaction click input started */
-	void InteractClickStarted(const FInputActionValue& Value);
-
 	/** Interaction click input completed */
 	void InteractClickCompleted(const FInputActionValue& Value);
 
@@ -251,6 +281,9 @@ protected:
 	/** Attempt to select or deselect units at the cached location */
 	void DoSelectionCommand();
 
+	/** Selects or deselects the unit found by the selection sweep */
+	void OnSelectionSweepFinished(bool bBlockingHit, const FHitResult& OutHit, bool bDeselectFirst);
+
 	/** Select all units currently on screen */
 	void DoSelectAllOnScreenCommand();
 
@@ -263,9 +296,8 @@ protected:
 	/** Move all selected units */
 	void DoMoveUnitsCommand();
 
-	/** Called when a unit move is completed */
-	UFUNCTION()
-	void OnMoveCompleted(AStrategyUnit* MovedUnit);
+	/** Returns true if the unit isn't hidden from this player by the fog of war */
+	bool CanSelectUnit(const AStrategyUnit* Unit) const;
 
 	/** Sorts all controlled units based on their distance to the provided world location */
 	AStrategyUnit* GetClosestSelectedUnitToLocation(FVector TargetLocation);
@@ -279,10 +311,7 @@ protected:
 	/** Projects the current touch location into world space */
 	FVector ProjectTouchPointToWorldSpace();
 
-	/** Spawns the positive cursor effect */
+	/** Allows Blueprint handling of cursor feedback. Effects set in the cursor FX properties are already spawned natively */
 	UFUNCTION(BlueprintImplementableEvent, Category="Cursor", meta = (DisplayName="Cursor Feedback"))
 	void BP_CursorFeedback(FVector Location, bool bPositive);
-
-	/** Resets the interaction flag */
-	void ResetInteraction();
 };
@@ -4,23 +4,40 @@
 #include "StrategyUnit.h"
 #include "AIController.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Components/SphereComponent.h"
 #include "Navigation/PathFollowingComponent.h"
+#include "NavigationSystem.h"
+#include "StrategyNavGraph.h"
+#include "StrategyAIController.h"
+#include "StrategyUnitRegistry.h"
+#include "StrategyOrderDispatcher.h"
+#include "DreamEatingNavMovementComponent.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
 
-AStrategyUnit::AStrategyUnit()
+DECLARE_CYCLE_STAT(TEXT("Unit Move Completed"), STAT_StrategyUnitMoveCompleted, STATGROUP_DreamEating);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unit Path Requests"), STAT_StrategyUnitPathRequests, STATGROUP_DreamEating);
+
+AStrategyUnit::AStrategyUnit(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UDreamEatingNavMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	// ensure this unit has a valid AI controller to handle move requests
 	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
 
-	// create the interaction range sphere
+	// use the crowd-aware AI controller so groups avoid each other
+	AIControllerClass = AStrategyAIController::StaticClass();
+
+	// create the interaction range sphere. It doesn't need overlaps, so it stays out of the physics scene
 	InteractionRange = CreateDefaultSubobject<USphereComponent>(TEXT("Interaction Range"));
 	InteractionRange->SetupAttachment(RootComponent);
 
-	InteractionRange->SetSphereRadius(100.0f);
-	InteractionRange->SetCollisionProfileName(FName("OverlapAllDynamic"));
+	InteractionRange->SetSphereRadius(InteractionReach);
+	InteractionRange->SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+	InteractionRange->SetGenerateOverlapEvents(false);
 
 	// configure movement
 	GetCharacterMovement()->GravityScale = 1.5f;
@@ -31,12 +48,78 @@ AStrategyUnit::AStrategyUnit()
 	GetCharacterMovement()->bUseFlatBaseForFloorChecks = true;
 	GetCharacterMovement()->RotationRate = FRotator(0.0f, 640.0f, 0.0f);
 	GetCharacterMovement()->bOrientRotationToMovement = true;
-	GetCharacterMovement()->AvoidanceConsiderationRadius = 150.0f;
-	GetCharacterMovement()->AvoidanceWeight = 1.0f;
+	GetCharacterMovement()->bUseRVOAvoidance = false;
 	GetCharacterMovement()->bConstrainToPlane = true;
 	GetCharacterMovement()->bSnapToPlaneAtStart = true;
 	GetCharacterMovement()->SetFixedBrakingDistance(200.0f);
 	GetCharacterMovement()->SetFixedBrakingDistance(true);
+
+	// the crowd keeps units apart, so they don't need to sweep their movement
+	CastChecked<UDreamEatingNavMovementComponent>(GetCharacterMovement())->SetSweepMovement(false);
+}
+
+void AStrategyUnit::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// save the rotation rate so we can restore it after simulation LOD changes
+	FullDetailRotationRate = GetCharacterMovement()->RotationRate;
+
+	// register with the unit registry
+	if (UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>())
+	{
+		Registry->RegisterUnit(this);
+	}
+
+	// natively we don't tick, so only Blueprints with an Event Tick need batching
+	if (bUseAggregatedTick && PrimaryActorTick.bCanEverTick)
+	{
+		if (UDreamEatingTickManager* TickManager = GetWorld()->GetSubsystem<UDreamEatingTickManager>())
+		{
+			TickManager->RegisterActor(this, this);
+		}
+	}
+}
+
+void AStrategyUnit::SetSimulationLOD(int32 NewLOD, float TickInterval, bool bSnapRotation)
+{
+	SimulationLOD = NewLOD;
+
+	// throttle movement and animation updates together so the mesh doesn't outpace the capsule
+	GetCharacterMovement()->SetComponentTickInterval(TickInterval);
+	GetMesh()->SetComponentTickInterval(TickInterval);
+
+	// a negative rotation rate snaps to the movement direction instead of interpolating
+	GetCharacterMovement()->RotationRate = bSnapRotation ? FRotator(0.0f, -1.0f, 0.0f) : FullDetailRotationRate;
+}
+
+void AStrategyUnit::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	// unregister from the unit registry
+	if (UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>())
+	{
+		Registry->UnregisterUnit(this);
+	}
+
+	// drop out of any order we're still executing
+	if (UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>())
+	{
+		Dispatcher->CancelUnit(this);
+	}
+
+	// leave the tick batch
+	if (UDreamEatingTickManager* TickManager = GetWorld()->GetSubsystem<UDreamEatingTickManager>())
+	{
+		TickManager->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AStrategyUnit::AggregatedTick(float DeltaTime)
+{
+	// match the time dilation the actor tick function would have applied
+	Tick(DeltaTime * CustomTimeDilation);
 }
 
 void AStrategyUnit::NotifyControllerChanged()
@@ -59,6 +142,10 @@ void AStrategyUnit::StopMoving()
 {
 	// use the character movement component to stop movement
 	GetCharacterMovement()->StopMovementImmediately();
+
+	// drop the current route
+	RouteWaypoints.Reset();
+	bWaitingForPath = false;
 }
 
 void AStrategyUnit::UnitSelected()
@@ -90,26 +177,126 @@ void AStrategyUnit::Interact(AStrategyUnit* Interactor)
 	
 }
 
+void AStrategyUnit::NotifyBecameAware(AStrategyUnit* Other)
+{
+	if (!IsValid(Other))
+	{
+		return;
+	}
+
+	// pass control to BP
+	BP_BecameAware(Other);
+
+	// only respond on our own while we're not following an order
+	UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>();
+
+	if (Dispatcher && Dispatcher->IsExecutingOrder(this))
+	{
+		return;
+	}
+
+	const bool bHostile = Other->GetTeamIndex() != TeamIndex;
+
+	switch (AwarenessResponse)
+	{
+		case EStrategyAwarenessResponse::Interact:
+
+			Other->Interact(this);
+			break;
+
+		case EStrategyAwarenessResponse::Aggro:
+
+			// close in on the other unit
+			if (bHostile)
+			{
+				MoveToLocation(Other->GetActorLocation(), InteractionReach);
+			}
+			break;
+
+		case EStrategyAwarenessResponse::Flee:
+
+			// run directly away from the other unit
+			if (bHostile)
+			{
+				const FVector FleeDirection = (GetActorLocation() - Other->GetActorLocation()).GetSafeNormal2D();
+				MoveToLocation(GetActorLocation() + FleeDirection * FleeDistance, InteractionReach);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+void AStrategyUnit::NotifyLostAwareness(AStrategyUnit* Other)
+{
+	// pass control to BP
+	BP_LostAwareness(Other);
+}
+
 bool AStrategyUnit::MoveToLocation(const FVector& Location, float AcceptanceRadius)
 {
+	// plan the coarse route and move along its first segment
+	float SegmentAcceptanceRadius = AcceptanceRadius;
+	const FVector SegmentGoal = PlanRoute(Location, AcceptanceRadius, SegmentAcceptanceRadius);
+
+	return MoveToSegment(SegmentGoal, SegmentAcceptanceRadius);
+}
+
+FVector AStrategyUnit::PlanRoute(const FVector& Goal, float AcceptanceRadius, float& OutSegmentAcceptanceRadius)
+{
+	// search the abstract graph
+	TArray<FVector> Waypoints;
+
+	if (UStrategyNavGraph* NavGraph = GetWorld()->GetSubsystem<UStrategyNavGraph>())
+	{
+		NavGraph->FindRoute(GetNavAgentLocation(), Goal, Waypoints);
+	}
+
+	return SetRoute(Waypoints, Goal, AcceptanceRadius, OutSegmentAcceptanceRadius);
+}
+
+FVector AStrategyUnit::SetRoute(TConstArrayView<FVector> Waypoints, const FVector& Goal, float AcceptanceRadius, float& OutSegmentAcceptanceRadius)
+{
+	RouteWaypoints.Reset();
+	RouteGoal = Goal;
+	RouteAcceptanceRadius = AcceptanceRadius;
+	OutSegmentAcceptanceRadius = AcceptanceRadius;
+	++RouteSegment;
+
+	// routes that end within the refine window are just regular moves
+	const int32 RefineClusters = UStrategyNavGraph::GetRefineClusterCount();
+
+	if (Waypoints.Num() < RefineClusters)
+	{
+		return Goal;
+	}
+
+	RouteWaypoints.Append(Waypoints);
+
+	// refine only up to the portal out of the last cluster in the window
+	RouteIndex = RefineClusters - 1;
+	OutSegmentAcceptanceRadius = WaypointAcceptanceRadius;
+
+	return RouteWaypoints[RouteIndex];
+}
+
+bool AStrategyUnit::MoveToSegment(const FVector& Location, float AcceptanceRadius)
+{
+	// this move computes its own path
+	bWaitingForPath = false;
+
 	// ensure we have a valid AI Controller
 	if (AIController)
 	{
 		// set up the AI Move Request
-		FAIMoveRequest MoveReq;
-
-		MoveReq.SetGoalLocation(Location);
-		MoveReq.SetAcceptanceRadius(AcceptanceRadius);
-		MoveReq.SetAllowPartialPath(true);
-		MoveReq.SetUsePathfinding(true);
-		MoveReq.SetProjectGoalLocation(true);
-		MoveReq.SetRequireNavigableEndLocation(true);
-		MoveReq.SetNavigationFilter(AIController->GetDefaultNavigationFilterClass());
-		MoveReq.SetCanStrafe(false);
+		const FAIMoveRequest MoveReq = MakeMoveRequest(Location, AcceptanceRadius, true);
 
 		// request a move to the AI Controller
 		FNavPathSharedPtr FollowedPath;
 		const FPathFollowingRequestResult ResultData = AIController->MoveTo(MoveReq, &FollowedPath);
+
+		INC_DWORD_STAT(STAT_StrategyUnitPathRequests);
 		
 		// check the move result
 		switch (ResultData.Code)
@@ -120,10 +307,14 @@ bool AStrategyUnit::MoveToLocation(const FVector& Location, float AcceptanceRadi
 				return false;
 				break;
 
-			// already at goal. Return true and call the move completed delegate
+			// already at goal. Continue the route, or call the move completed delegate if we're done
 			case EPathFollowingRequestResult::AlreadyAtGoal:
 
-				OnMoveCompleted.Broadcast(this);
+				if (!AdvanceRoute())
+				{
+					NotifyMoveCompleted();
+				}
+
 				return true;
 				break;
 
@@ -139,8 +330,161 @@ bool AStrategyUnit::MoveToLocation(const FVector& Location, float AcceptanceRadi
 	return false;
 }
 
+bool AStrategyUnit::AdvanceRoute()
+{
+	if (RouteWaypoints.IsEmpty())
+	{
+		return false;
+	}
+
+	// refine the next window of clusters, or the last stretch to the goal
+	RouteIndex += UStrategyNavGraph::GetRefineClusterCount();
+	++RouteSegment;
+
+	if (RouteWaypoints.IsValidIndex(RouteIndex))
+	{
+		return MoveToSegment(RouteWaypoints[RouteIndex], WaypointAcceptanceRadius);
+	}
+
+	RouteWaypoints.Reset();
+
+	return MoveToSegment(RouteGoal, RouteAcceptanceRadius);
+}
+
+bool AStrategyUnit::MoveDirectlyToLocation(const FVector& Location, float AcceptanceRadius)
+{
+	// ensure we have a valid AI Controller
+	if (AIController)
+	{
+		// request a straight line move. This skips pathfinding entirely
+		const FPathFollowingRequestResult ResultData = AIController->MoveTo(MakeMoveRequest(Location, AcceptanceRadius, false));
+
+		return ResultData.Code == EPathFollowingRequestResult::RequestSuccessful;
+	}
+
+	return false;
+}
+
+bool AStrategyUnit::BuildPathQuery(const FVector& Location, float AcceptanceRadius, FPathFindingQuery& OutQuery) const
+{
+	// ensure we have a valid AI Controller
+	if (!AIController)
+	{
+		return false;
+	}
+
+	FAIMoveRequest MoveReq = MakeMoveRequest(Location, AcceptanceRadius, true);
+
+	// project the goal onto the navmesh, same as a regular move would
+	if (const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		FNavLocation ProjectedGoal;
+
+		if (!NavSys->ProjectPointToNavigation(Location, ProjectedGoal, INVALID_NAVEXTENT))
+		{
+			return false;
+		}
+
+		MoveReq.UpdateGoalLocation(ProjectedGoal.Location);
+	}
+
+	return AIController->BuildPathfindingQuery(MoveReq, OutQuery);
+}
+
+bool AStrategyUnit::FollowPath(FNavPathSharedPtr Path, const FVector& Location, float AcceptanceRadius)
+{
+	// ensure we have a valid AI Controller and path
+	if (AIController && Path.IsValid())
+	{
+		// hand the precomputed path to the path following component
+		const FAIRequestID RequestID = AIController->RequestMove(MakeMoveRequest(Location, AcceptanceRadius, true), Path);
+
+		// keep waiting if the path was refused, so the caller can still query a new one or abort
+		if (RequestID.IsValid())
+		{
+			bWaitingForPath = false;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void AStrategyUnit::AbortMove()
+{
+	RouteWaypoints.Reset();
+	bWaitingForPath = false;
+
+	// stopping an active move, e.g. an intent move, reports its completion through OnMoveFinished
+	UPathFollowingComponent* PFComp = AIController ? AIController->GetPathFollowingComponent() : nullptr;
+
+	if (PFComp && PFComp->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		AIController->StopMovement();
+		return;
+	}
+
+	NotifyMoveCompleted();
+}
+
+FAIMoveRequest AStrategyUnit::MakeMoveRequest(const FVector& Location, float AcceptanceRadius, bool bUsePathfinding) const
+{
+	FAIMoveRequest MoveReq;
+
+	MoveReq.SetGoalLocation(Location);
+	MoveReq.SetAcceptanceRadius(AcceptanceRadius);
+	MoveReq.SetAllowPartialPath(true);
+	MoveReq.SetUsePathfinding(bUsePathfinding);
+	MoveReq.SetProjectGoalLocation(true);
+	MoveReq.SetRequireNavigableEndLocation(true);
+	MoveReq.SetNavigationFilter(GetNavigationFilterClass());
+	MoveReq.SetCanStrafe(false);
+
+	return MoveReq;
+}
+
+TSubclassOf<UNavigationQueryFilter> AStrategyUnit::GetNavigationFilterClass() const
+{
+	return AIController ? AIController->GetDefaultNavigationFilterClass() : nullptr;
+}
+
 void AStrategyUnit::OnMoveFinished(FAIRequestID RequestID, const FPathFollowingResult& Result)
 {
+	// ignore moves that were replaced by a newer request, e.g. an intent move being replaced by its path
+	if (Result.HasFlag(FPathFollowingResultFlags::NewRequest))
+	{
+		return;
+	}
+
+	// an intent move ending before its path arrived, e.g. against a wall or already at the segment goal.
+	// Wait for the path instead of arriving or moving on to the next segment
+	if (bWaitingForPath)
+	{
+		return;
+	}
+
+	// keep going if we reached a portal on a hierarchical route
+	if (Result.IsSuccess() && AdvanceRoute())
+	{
+		return;
+	}
+
+	RouteWaypoints.Reset();
+
+	NotifyMoveCompleted();
+}
+
+void AStrategyUnit::NotifyMoveCompleted()
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyUnitMoveCompleted);
+	DREAMEATING_PERF_SCOPE(AI);
+
+	// let the order dispatcher track the arrival
+	if (UStrategyOrderDispatcher* Dispatcher = GetWorld()->GetSubsystem<UStrategyOrderDispatcher>())
+	{
+		Dispatcher->NotifyUnitArrived(this);
+	}
+
 	// call the delegate
 	OnMoveCompleted.Broadcast(this);
 }
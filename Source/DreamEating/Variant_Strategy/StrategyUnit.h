@@ -5,9 +5,21 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "AIController.h"
+#include "DreamEatingTickManager.h"
 #include "StrategyUnit.generated.h"
 
 class USphereComponent;
+struct FPathFindingQuery;
+
+/** How a unit responds on its own when it becomes aware of another unit */
+UENUM(BlueprintType)
+enum class EStrategyAwarenessResponse : uint8
+{
+	None		UMETA(DisplayName = "None"),
+	Interact	UMETA(DisplayName = "Interact"),
+	Aggro		UMETA(DisplayName = "Aggro"),
+	Flee		UMETA(DisplayName = "Flee")
+};
 
 /** Delegate to report that this unit has finished moving */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnUnitMoveCompletedDelegate, AStrategyUnit*, Unit);
@@ -17,13 +29,13 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnUnitMoveCompletedDelegate, AStrat
  *  Rather than react to inputs, it's controlled indirectly by the Strategy Player Controller
  */
 UCLASS(abstract)
-class AStrategyUnit : public ACharacter
+class AStrategyUnit : public ACharacter, public FDreamEatingAggregatedTickable
 {
 	GENERATED_BODY()
 
 private:
 
-	/** Interaction range sphere */
+	/** Interaction range sphere. Kept for Blueprints, interactions are resolved by the order dispatcher's proximity pass using InteractionReach */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
 	USphereComponent* InteractionRange;
 
@@ -32,13 +44,75 @@ protected:
 	/** Cast reference to the AI Controlling this unit */
 	TObjectPtr<AAIController> AIController;
 
+	/** Distance from the unit at which it can be reached by interactions */
+	UPROPERTY(EditAnywhere, Category="Interaction", meta = (ClampMin = 0, Units = "cm"))
+	float InteractionReach = 100.0f;
+
+	/** Team this unit belongs to. Aggro and flee responses only target other teams */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Awareness")
+	int32 TeamIndex = 0;
+
+	/** Radius within which this unit becomes aware of other units. Zero disables awareness */
+	UPROPERTY(EditAnywhere, Category="Awareness", meta = (ClampMin = 0, Units = "cm"))
+	float AwarenessRadius = 0.0f;
+
+	/** Radius this unit reveals through the fog of war */
+	UPROPERTY(EditAnywhere, Category="Awareness", meta = (ClampMin = 0, Units = "cm"))
+	float SightRadius = 1200.0f;
+
+	/** Autonomous response when this unit becomes aware of another unit while it's not executing an order */
+	UPROPERTY(EditAnywhere, Category="Awareness")
+	EStrategyAwarenessResponse AwarenessResponse = EStrategyAwarenessResponse::None;
+
+	/** Distance to run away when fleeing */
+	UPROPERTY(EditAnywhere, Category="Awareness", meta = (ClampMin = 0, Units = "cm"))
+	float FleeDistance = 1000.0f;
+
+	/** Acceptance radius used for intermediate portals on a hierarchical route */
+	UPROPERTY(EditAnywhere, Category="Movement", meta = (ClampMin = 0, Units = "cm"))
+	float WaypointAcceptanceRadius = 150.0f;
+
+	/** Portal waypoints of the current hierarchical route */
+	TArray<FVector> RouteWaypoints;
+
+	/** Index of the waypoint the unit is currently moving to */
+	int32 RouteIndex = 0;
+
+	/** Final goal of the current hierarchical route */
+	FVector RouteGoal = FVector::ZeroVector;
+
+	/** Acceptance radius for the final goal of the current hierarchical route */
+	float RouteAcceptanceRadius = 0.0f;
+
+	/** Incremented every time the unit starts a new route or route segment, so late path results for an older one can be told apart */
+	uint32 RouteSegment = 0;
+
+	/** If true, a path for the current segment is still being computed, so the end of any earlier move isn't an arrival */
+	bool bWaitingForPath = false;
+
+	/** Current simulation LOD level. 0 is full detail */
+	int32 SimulationLOD = 0;
+
+	/** Rotation rate set up for full detail simulation */
+	FRotator FullDetailRotationRate;
+
+	/** If true, a Blueprint Event Tick on this unit is batched with every other unit of the same class instead of ticking on its own */
+	UPROPERTY(EditAnywhere, Category="Ticking")
+	bool bUseAggregatedTick = true;
+
 public:
 
 	/** Constructor */
-	AStrategyUnit();
+	AStrategyUnit(const FObjectInitializer& ObjectInitializer);
 
 protected:
 
+	/** Registers this unit with the unit registry */
+	virtual void BeginPlay() override;
+
+	/** Unregisters this unit from the unit registry */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void NotifyControllerChanged() override;
 
 public:
@@ -58,11 +132,77 @@ public:
 	/** Attempts to move this unit to its */
 	bool MoveToLocation(const FVector& Location, float AcceptanceRadius);
 
+	/** Plans a coarse route to the goal on the Strategy nav graph. Returns the end of the first segment to refine with regular pathfinding, which is the goal itself for short moves */
+	FVector PlanRoute(const FVector& Goal, float AcceptanceRadius, float& OutSegmentAcceptanceRadius);
+
+	/** Starts following a coarse route planned ahead of time, e.g. shared by a whole order. Returns the end of the first segment, same as PlanRoute */
+	FVector SetRoute(TConstArrayView<FVector> Waypoints, const FVector& Goal, float AcceptanceRadius, float& OutSegmentAcceptanceRadius);
+
+	/** Starts a straight line move towards the location without pathfinding. Used as an intent move while a path is being computed */
+	bool MoveDirectlyToLocation(const FVector& Location, float AcceptanceRadius);
+
+	/** Builds a path finding query for a move to the given location, so it can be run asynchronously */
+	bool BuildPathQuery(const FVector& Location, float AcceptanceRadius, FPathFindingQuery& OutQuery) const;
+
+	/** Starts following a path computed ahead of time */
+	bool FollowPath(FNavPathSharedPtr Path, const FVector& Location, float AcceptanceRadius);
+
+	/** Ends the current move without reaching its goal, e.g. when no path could be found. Still reports the move as completed */
+	void AbortMove();
+
+	/** Marks the unit as waiting for the path of its current segment. Moves ending until it arrives, e.g. an intent move, don't complete the route */
+	void SetWaitingForPath(bool bWaiting) { bWaitingForPath = bWaiting; }
+
+	/** Returns the current route segment, see RouteSegment */
+	uint32 GetRouteSegment() const { return RouteSegment; }
+
+	/** Returns the distance from the unit at which it can be reached by interactions */
+	float GetInteractionReach() const { return InteractionReach; }
+
+	/** Returns the team this unit belongs to */
+	int32 GetTeamIndex() const { return TeamIndex; }
+
+	/** Returns the radius within which this unit becomes aware of other units */
+	float GetAwarenessRadius() const { return AwarenessRadius; }
+
+	/** Returns the radius this unit reveals through the fog of war */
+	float GetSightRadius() const { return SightRadius; }
+
+	/** Returns the current simulation LOD level */
+	int32 GetSimulationLOD() const { return SimulationLOD; }
+
+	/** Applies a simulation LOD level. Throttles movement and animation updates and optionally snaps rotation instead of smoothing it */
+	void SetSimulationLOD(int32 NewLOD, float TickInterval, bool bSnapRotation);
+
+	/** Runs the actor's own tick from the aggregated tick manager */
+	virtual void AggregatedTick(float DeltaTime) override;
+
+	/** Notifies this unit that another unit entered its awareness radius */
+	void NotifyBecameAware(AStrategyUnit* Other);
+
+	/** Notifies this unit that another unit left its awareness radius */
+	void NotifyLostAwareness(AStrategyUnit* Other);
+
+	/** Returns the navigation filter class used for this unit's moves */
+	TSubclassOf<UNavigationQueryFilter> GetNavigationFilterClass() const;
+
 protected:
 
+	/** Requests a pathfinding move along the current route segment */
+	bool MoveToSegment(const FVector& Location, float AcceptanceRadius);
+
+	/** Starts refining the next segment of the current route. Returns false if the route is finished */
+	bool AdvanceRoute();
+
+	/** Sets up an AI move request to the given location */
+	FAIMoveRequest MakeMoveRequest(const FVector& Location, float AcceptanceRadius, bool bUsePathfinding) const;
+
 	/** called by the AI controller when this unit has finished moving */
 	void OnMoveFinished(FAIRequestID RequestID, const FPathFollowingResult& Result);
 
+	/** Reports the end of the current move to the order dispatcher and any listeners */
+	void NotifyMoveCompleted();
+
 protected:
 
 	/** Blueprint handler for strategy game selection */
@@ -77,6 +217,14 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category="NPC", meta = (DisplayName="Interaction Behavior"))
 	void BP_InteractionBehavior(AStrategyUnit* Interactor);
 
+	/** Blueprint handler for another unit entering this unit's awareness radius */
+	UFUNCTION(BlueprintImplementableEvent, Category="NPC", meta = (DisplayName="Became Aware"))
+	void BP_BecameAware(AStrategyUnit* Other);
+
+	/** Blueprint handler for another unit leaving this unit's awareness radius */
+	UFUNCTION(BlueprintImplementableEvent, Category="NPC", meta = (DisplayName="Lost Awareness"))
+	void BP_LostAwareness(AStrategyUnit* Other);
+
 public:
 
 	FOnUnitMoveCompletedDelegate OnMoveCompleted;
@@ -0,0 +1,243 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyUnitLODSubsystem.h"
+#include "StrategyUnit.h"
+#include "StrategyUnitRegistry.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Algo/Sort.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Unit LOD Update"), STAT_StrategyUnitLOD, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Unit LOD Changes"), STAT_StrategyUnitLODChanges, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Units at LOD 0"), STAT_StrategyUnitLOD0, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Units at LOD 1"), STAT_StrategyUnitLOD1, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Units at LOD 2"), STAT_StrategyUnitLOD2, STATGROUP_DreamEating);
+
+/** Number of simulation LOD levels */
+static constexpr int32 NumUnitLODs = 3;
+
+static bool GStrategyUnitLODEnabled = true;
+static FAutoConsoleVariableRef CVarStrategyUnitLODEnabled(
+	TEXT("DreamEating.Strategy.UnitLOD"),
+	GStrategyUnitLODEnabled,
+	TEXT("If true, Strategy units lower their movement, animation and rotation update rates when zoomed out or far from the view."),
+	ECVF_Default);
+
+static float GStrategyUnitLOD1OrthoWidth = 1800.0f;
+static FAutoConsoleVariableRef CVarStrategyUnitLOD1OrthoWidth(
+	TEXT("DreamEating.Strategy.UnitLOD1OrthoWidth"),
+	GStrategyUnitLOD1OrthoWidth,
+	TEXT("Camera ortho width above which Strategy units drop to LOD 1."),
+	ECVF_Default);
+
+static float GStrategyUnitLOD2OrthoWidth = 2300.0f;
+static FAutoConsoleVariableRef CVarStrategyUnitLOD2OrthoWidth(
+	TEXT("DreamEating.Strategy.UnitLOD2OrthoWidth"),
+	GStrategyUnitLOD2OrthoWidth,
+	TEXT("Camera ortho width above which Strategy units drop to LOD 2."),
+	ECVF_Default);
+
+static float GStrategyUnitLODFarRatio = 0.75f;
+static FAutoConsoleVariableRef CVarStrategyUnitLODFarRatio(
+	TEXT("DreamEating.Strategy.UnitLODFarRatio"),
+	GStrategyUnitLODFarRatio,
+	TEXT("Distance from the view focus, as a ratio of the ortho width, beyond which Strategy units drop one extra LOD level."),
+	ECVF_Default);
+
+static float GStrategyUnitLODHysteresis = 0.1f;
+static FAutoConsoleVariableRef CVarStrategyUnitLODHysteresis(
+	TEXT("DreamEating.Strategy.UnitLODHysteresis"),
+	GStrategyUnitLODHysteresis,
+	TEXT("Fraction of each LOD threshold a unit has to move back past before returning to a more detailed level."),
+	ECVF_Default);
+
+static float GStrategyUnitLOD1TickRate = 20.0f;
+static FAutoConsoleVariableRef CVarStrategyUnitLOD1TickRate(
+	TEXT("DreamEating.Strategy.UnitLOD1TickRate"),
+	GStrategyUnitLOD1TickRate,
+	TEXT("Movement and animation tick rate in Hz for Strategy units at LOD 1."),
+	ECVF_Default);
+
+static float GStrategyUnitLOD2TickRate = 10.0f;
+static FAutoConsoleVariableRef CVarStrategyUnitLOD2TickRate(
+	TEXT("DreamEating.Strategy.UnitLOD2TickRate"),
+	GStrategyUnitLOD2TickRate,
+	TEXT("Movement and animation tick rate in Hz for Strategy units at LOD 2."),
+	ECVF_Default);
+
+static int32 GStrategyUnitLODChangesPerFrame = 64;
+static FAutoConsoleVariableRef CVarStrategyUnitLODChangesPerFrame(
+	TEXT("DreamEating.Strategy.UnitLODChangesPerFrame"),
+	GStrategyUnitLODChangesPerFrame,
+	TEXT("Max number of Strategy units that change LOD level per frame."),
+	ECVF_Default);
+
+bool UStrategyUnitLODSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStrategyUnitLODSubsystem::Tick(float DeltaTime)
+{
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyUnitLOD);
+	DREAMEATING_PERF_SCOPE(Movement);
+
+	UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>();
+
+	if (!Registry)
+	{
+		return;
+	}
+
+	FVector Focus = FVector::ZeroVector;
+	float OrthoWidth = 0.0f;
+
+	// without a view, keep everything at full detail
+	const bool bHasView = GStrategyUnitLODEnabled && GetViewInfo(Focus, OrthoWidth);
+
+	Promotions.Reset();
+	Demotions.Reset();
+
+	int32 UnitsPerLOD[NumUnitLODs] = { 0, 0, 0 };
+
+	for (AStrategyUnit* Unit : Registry->GetUnits())
+	{
+		if (!IsValid(Unit))
+		{
+			continue;
+		}
+
+		const int32 CurrentLOD = Unit->GetSimulationLOD();
+		const float DistanceSquared = FVector::DistSquared2D(Unit->GetActorLocation(), Focus);
+
+		const int32 DesiredLOD = bHasView ? GetDesiredLOD(CurrentLOD, OrthoWidth, FMath::Sqrt(DistanceSquared) / OrthoWidth) : 0;
+
+		++UnitsPerLOD[CurrentLOD];
+
+		if (DesiredLOD < CurrentLOD)
+		{
+			Promotions.Add({ Unit, DesiredLOD, DistanceSquared });
+		}
+		else if (DesiredLOD > CurrentLOD)
+		{
+			Demotions.Add({ Unit, DesiredLOD, DistanceSquared });
+		}
+	}
+
+	SET_DWORD_STAT(STAT_StrategyUnitLOD0, UnitsPerLOD[0]);
+	SET_DWORD_STAT(STAT_StrategyUnitLOD1, UnitsPerLOD[1]);
+	SET_DWORD_STAT(STAT_StrategyUnitLOD2, UnitsPerLOD[2]);
+
+	int32 Budget = FMath::Max(GStrategyUnitLODChangesPerFrame, 1);
+
+	// restore the units closest to the view first, so zooming in sharpens from the center out
+	if (Promotions.Num() > Budget)
+	{
+		Algo::Sort(Promotions, [](const FStrategyUnitLODChange& A, const FStrategyUnitLODChange& B) { return A.DistanceSquared < B.DistanceSquared; });
+	}
+
+	for (int32 Index = 0; Index < Promotions.Num() && Budget > 0; ++Index, --Budget)
+	{
+		ApplyLOD(Promotions[Index].Unit, Promotions[Index].LOD);
+		INC_DWORD_STAT(STAT_StrategyUnitLODChanges);
+	}
+
+	// demotions only save time, so they get whatever budget is left
+	for (int32 Index = 0; Index < Demotions.Num() && Budget > 0; ++Index, --Budget)
+	{
+		ApplyLOD(Demotions[Index].Unit, Demotions[Index].LOD);
+		INC_DWORD_STAT(STAT_StrategyUnitLODChanges);
+	}
+}
+
+TStatId UStrategyUnitLODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStrategyUnitLODSubsystem, STATGROUP_Tickables);
+}
+
+bool UStrategyUnitLODSubsystem::GetViewInfo(FVector& OutFocus, float& OutOrthoWidth) const
+{
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+
+	if (!PC || !PC->PlayerCameraManager)
+	{
+		return false;
+	}
+
+	const FMinimalViewInfo& View = PC->PlayerCameraManager->GetCameraCacheView();
+
+	// the Strategy camera is orthographic, so the ortho width is our zoom level
+	if (View.ProjectionMode != ECameraProjectionMode::Orthographic || View.OrthoWidth <= 0.0f)
+	{
+		return false;
+	}
+
+	OutOrthoWidth = View.OrthoWidth;
+
+	// project the view direction onto the ground plane to find what the camera is looking at
+	const FVector Forward = View.Rotation.Vector();
+
+	if (Forward.Z < -UE_KINDA_SMALL_NUMBER)
+	{
+		OutFocus = View.Location + Forward * (-View.Location.Z / Forward.Z);
+	}
+	else
+	{
+		OutFocus = View.Location;
+	}
+
+	return true;
+}
+
+int32 UStrategyUnitLODSubsystem::GetDesiredLOD(int32 CurrentLOD, float OrthoWidth, float DistanceRatio)
+{
+	// thresholds are lowered for levels we're already at, so a unit has to clearly cross back to be promoted
+	const auto Threshold = [CurrentLOD](float Value, int32 Level)
+	{
+		return CurrentLOD >= Level ? Value * (1.0f - GStrategyUnitLODHysteresis) : Value;
+	};
+
+	int32 LOD = 0;
+
+	if (OrthoWidth > Threshold(GStrategyUnitLOD2OrthoWidth, 2))
+	{
+		LOD = 2;
+	}
+	else if (OrthoWidth > Threshold(GStrategyUnitLOD1OrthoWidth, 1))
+	{
+		LOD = 1;
+	}
+
+	// units well outside the view drop one extra level
+	const float FarRatio = CurrentLOD > LOD ? GStrategyUnitLODFarRatio * (1.0f - GStrategyUnitLODHysteresis) : GStrategyUnitLODFarRatio;
+
+	if (DistanceRatio > FarRatio)
+	{
+		++LOD;
+	}
+
+	return FMath::Min(LOD, NumUnitLODs - 1);
+}
+
+void UStrategyUnitLODSubsystem::ApplyLOD(AStrategyUnit* Unit, int32 LOD)
+{
+	switch (LOD)
+	{
+	case 0:
+		Unit->SetSimulationLOD(0, 0.0f, false);
+		break;
+
+	case 1:
+		Unit->SetSimulationLOD(1, 1.0f / FMath::Max(GStrategyUnitLOD1TickRate, 1.0f), false);
+		break;
+
+	default:
+		Unit->SetSimulationLOD(2, 1.0f / FMath::Max(GStrategyUnitLOD2TickRate, 1.0f), true);
+		break;
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StrategyUnitLODSubsystem.generated.h"
+
+class AStrategyUnit;
+
+/**
+ *  A pending simulation LOD change for a unit
+ */
+struct FStrategyUnitLODChange
+{
+	/** Unit to update */
+	AStrategyUnit* Unit = nullptr;
+
+	/** LOD level to apply */
+	int32 LOD = 0;
+
+	/** Squared distance from the unit to the view focus, used to promote the closest units first */
+	float DistanceSquared = 0.0f;
+};
+
+/**
+ *  Simulation LOD policy for Strategy units.
+ *  Picks a LOD level for each unit from the camera's ortho width and the unit's distance
+ *  to the view focus, with hysteresis so units don't flicker between levels while zooming.
+ *  Lower levels throttle movement and animation ticks and snap rotation instead of smoothing it.
+ *  LOD changes are spread over several frames, and units closest to the view are
+ *  restored to full detail first when zooming back in.
+ */
+UCLASS()
+class UStrategyUnitLODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Units waiting to be promoted to a more detailed level */
+	TArray<FStrategyUnitLODChange> Promotions;
+
+	/** Units waiting to be demoted to a less detailed level */
+	TArray<FStrategyUnitLODChange> Demotions;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Updates the LOD level of each unit */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/** Gets the local player's view focus on the ground and ortho width. Returns false if there's no view */
+	bool GetViewInfo(FVector& OutFocus, float& OutOrthoWidth) const;
+
+	/** Returns the LOD level the unit should use, given its current level */
+	static int32 GetDesiredLOD(int32 CurrentLOD, float OrthoWidth, float DistanceRatio);
+
+	/** Applies the given LOD level to a unit */
+	static void ApplyLOD(AStrategyUnit* Unit, int32 LOD);
+};
@@ -0,0 +1,99 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "StrategyUnitRegistry.h"
+#include "StrategyUnit.h"
+#include "HAL/IConsoleManager.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Unit Grid Update"), STAT_StrategyUnitGridUpdate, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Units"), STAT_StrategyRegisteredUnits, STATGROUP_DreamEating);
+
+static float GStrategyUnitGridCellSize = 500.0f;
+static FAutoConsoleVariableRef CVarStrategyUnitGridCellSize(
+	TEXT("DreamEating.Strategy.UnitGridCellSize"),
+	GStrategyUnitGridCellSize,
+	TEXT("Cell size in cm of the grid used for Strategy unit proximity queries."),
+	ECVF_Default);
+
+bool UStrategyUnitRegistry::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStrategyUnitRegistry::RegisterUnit(AStrategyUnit* Unit)
+{
+	if (IsValid(Unit))
+	{
+		Units.AddUnique(Unit);
+		MaxInteractionReach = FMath::Max(MaxInteractionReach, Unit->GetInteractionReach());
+
+		// force a grid rebuild on the next query
+		GridFrame = MAX_uint64;
+
+		SET_DWORD_STAT(STAT_StrategyRegisteredUnits, Units.Num());
+	}
+}
+
+void UStrategyUnitRegistry::UnregisterUnit(AStrategyUnit* Unit)
+{
+	const int32 Index = Units.Find(Unit);
+
+	if (Index != INDEX_NONE)
+	{
+		// keep the order so scan cursors into the list don't skip or repeat units
+		Units.RemoveAt(Index, EAllowShrinking::No);
+
+		// force a grid rebuild on the next query
+		GridFrame = MAX_uint64;
+
+		OnUnitRemoved.Broadcast(Index);
+
+		SET_DWORD_STAT(STAT_StrategyRegisteredUnits, Units.Num());
+	}
+}
+
+void UStrategyUnitRegistry::QueryUnitsInRadius(const FVector& Center, float Radius, TArray<AStrategyUnit*>& OutUnits)
+{
+	UpdateGrid();
+
+	QueryScratch.Reset();
+	Grid.QueryRadius(Center, Radius, QueryScratch);
+
+	// units may have been destroyed since the grid was built
+	for (const int32 UnitIndex : QueryScratch)
+	{
+		AStrategyUnit* Unit = Units[UnitIndex];
+
+		if (IsValid(Unit))
+		{
+			OutUnits.Add(Unit);
+		}
+	}
+}
+
+void UStrategyUnitRegistry::UpdateGrid()
+{
+	if (GridFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyUnitGridUpdate);
+	DREAMEATING_PERF_SCOPE(Movement);
+
+	GridFrame = GFrameCounter;
+
+	// empty the cells but keep their allocations
+	Grid.Reset(GStrategyUnitGridCellSize);
+
+	// bucket the units
+	for (int32 UnitIndex = 0; UnitIndex < Units.Num(); ++UnitIndex)
+	{
+		if (IsValid(Units[UnitIndex]))
+		{
+			Grid.Add(UnitIndex, Units[UnitIndex]->GetActorLocation());
+		}
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DreamEatingSpatialGrid.h"
+#include "StrategyUnitRegistry.generated.h"
+
+class AStrategyUnit;
+
+/** Delegate to report that the unit at an index was removed, and every unit after it moved down one slot */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnStrategyUnitRemoved, int32 /* Index */);
+
+/**
+ *  Keeps track of every Strategy unit in the world.
+ *  Units are bucketed into a uniform 2D grid that is rebuilt at most once per frame,
+ *  so proximity queries don't need to go through the physics scene.
+ */
+UCLASS()
+class UStrategyUnitRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Registered units */
+	UPROPERTY()
+	TArray<TObjectPtr<AStrategyUnit>> Units;
+
+	/** Indices into the unit list, bucketed by grid cell */
+	FDreamEatingSpatialGrid Grid;
+
+	/** Scratch list of unit indices returned by grid queries */
+	TArray<int32> QueryScratch;
+
+	/** Frame counter when the grid was last rebuilt */
+	uint64 GridFrame = MAX_uint64;
+
+	/** Largest interaction reach of any registered unit */
+	float MaxInteractionReach = 0.0f;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/** Called when a unit is removed from the unit list, so cursors into it can be adjusted */
+	FOnStrategyUnitRemoved OnUnitRemoved;
+
+	/** Adds a unit to the registry */
+	void RegisterUnit(AStrategyUnit* Unit);
+
+	/** Removes a unit from the registry. Keeps the order of the remaining units */
+	void UnregisterUnit(AStrategyUnit* Unit);
+
+	/** Returns every registered unit, in registration order */
+	const TArray<TObjectPtr<AStrategyUnit>>& GetUnits() const { return Units; }
+
+	/** Returns the largest interaction reach of any registered unit */
+	float GetMaxInteractionReach() const { return MaxInteractionReach; }
+
+	/** Finds every unit within the given 2D radius of a location */
+	void QueryUnitsInRadius(const FVector& Center, float Radius, TArray<AStrategyUnit*>& OutUnits);
+
+protected:
+
+	/** Rebuilds the grid if it hasn't been rebuilt this frame */
+	void UpdateGrid();
+};
@@ -5,6 +5,70 @@
 #include "StrategyUnit.h"
 #include "StrategyPlayerController.h"
 #include "StrategyUI.h"
+#include "StrategyUnitRegistry.h"
+#include "DreamEatingPerfMonitor.h"
+#include "Engine/Canvas.h"
+#include "CanvasItem.h"
+#include "SceneView.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Selection Overlay"), STAT_StrategySelectionOverlay, STATGROUP_DreamEating);
+DECLARE_CYCLE_STAT(TEXT("Box Selection"), STAT_StrategyBoxSelection, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Selected Units"), STAT_StrategySelectedUnits, STATGROUP_DreamEating);
+
+/** Accumulated selection overlay cost, used by the benchmark command */
+static double GStrategySelectionOverlayTime = 0.0;
+
+/** Number of selection overlay updates accumulated */
+static int64 GStrategySelectionOverlayCount = 0;
+
+static FAutoConsoleCommandWithWorldAndArgs CmdStrategySelectionOverlayBenchmark(
+	TEXT("DreamEating.Strategy.SelectionOverlayBenchmark"),
+	TEXT("Selects up to the given number of units and measures the HUD selection overlay cost. Usage: DreamEating.Strategy.SelectionOverlayBenchmark [Units=500] [Seconds=5]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		AStrategyPlayerController* PC = World ? Cast<AStrategyPlayerController>(UGameplayStatics::GetPlayerController(World, 0)) : nullptr;
+		UStrategyUnitRegistry* Registry = World ? World->GetSubsystem<UStrategyUnitRegistry>() : nullptr;
+
+		if (!PC || !Registry)
+		{
+			return;
+		}
+
+		const int32 NumUnits = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 500, 1);
+		const float Seconds = FMath::Max(Args.Num() > 1 ? FCString::Atof(*Args[1]) : 5.0f, 0.5f);
+
+		// select the first registered units
+		TArray<AStrategyUnit*> Units;
+
+		for (AStrategyUnit* Unit : Registry->GetUnits())
+		{
+			if (IsValid(Unit) && Units.Num() < NumUnits)
+			{
+				Units.Add(Unit);
+			}
+		}
+
+		PC->DragSelectUnits(Units);
+
+		GStrategySelectionOverlayTime = 0.0;
+		GStrategySelectionOverlayCount = 0;
+
+		FTimerHandle TimerHandle;
+		World->GetTimerManager().SetTimer(TimerHandle, FTimerDelegate::CreateLambda([SelectedCount = PC->GetSelectedUnits().Num()]()
+		{
+			const double AverageCost = GStrategySelectionOverlayCount > 0 ? GStrategySelectionOverlayTime * 1000000.0 / GStrategySelectionOverlayCount : 0.0;
+
+			UE_LOG(LogDreamEating, Display, TEXT("Selection overlay benchmark: %d selected units, %.2f us per frame over %lld frames"),
+				SelectedCount, AverageCost, GStrategySelectionOverlayCount);
+
+		}), Seconds, false);
+
+		UE_LOG(LogDreamEating, Display, TEXT("Selection overlay benchmark started, %.1f seconds"), Seconds);
+	}));
 
 void AStrategyHUD::BeginPlay()
 {
@@ -30,6 +94,8 @@ void AStrategyHUD::DragSelectUpdate(FVector2D Start, FVector2D WidthAndHeight, F
 
 void AStrategyHUD::DrawHUD()
 {
+	DREAMEATING_PERF_SCOPE(UI);
+
 	// draw all debug information, etc.
 	Super::DrawHUD();
 
@@ -39,6 +105,9 @@ void AStrategyHUD::DrawHUD()
 		// draw the selection box
 		if (bDrawBox)
 		{
+			DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategyBoxSelection);
+			DREAMEATING_PERF_SCOPE(Selection);
+
 			DrawRect(SelectionBoxColor, BoxStart.X, BoxStart.Y, BoxSize.X, BoxSize.Y);
 
 			// get all the units in the selection box
@@ -49,29 +118,125 @@ void AStrategyHUD::DrawHUD()
 			PC->DragSelectUnits(BoxedUnits);
 		}
 
-		// get the currently selected units
-		TArray<AStrategyUnit*> SelectedUnits = PC->GetSelectedUnits();
+		const double StartTime = FPlatformTime::Seconds();
+
+		{
+			DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StrategySelectionOverlay);
+			DREAMEATING_PERF_SCOPE(Selection);
+
+			const TArray<AStrategyUnit*>& SelectedUnits = PC->GetSelectedUnits();
+			SET_DWORD_STAT(STAT_StrategySelectedUnits, SelectedUnits.Num());
+			const uint32 SelectionVersion = PC->GetSelectionVersion();
+
+			// update the selection count on the UI widget
+			if (SelectionVersion != CachedSelectionVersion)
+			{
+				UIWidget->SetSelectedUnitsCount(SelectedUnits.Num());
+			}
+
+			UpdateSelectionMarkers(SelectedUnits, SelectionVersion);
+
+			// draw every marker in a single batch
+			if (MarkerTriangles.Num() > 0)
+			{
+				FCanvasTriangleItem MarkerItem(MarkerTriangles, nullptr);
+				MarkerItem.BlendMode = SE_BLEND_Translucent;
+				Canvas->DrawItem(MarkerItem);
+			}
+		}
 
-		// update the selection count on the UI widget
-		UIWidget->SetSelectedUnitsCount(SelectedUnits.Num());
+		GStrategySelectionOverlayTime += FPlatformTime::Seconds() - StartTime;
+		++GStrategySelectionOverlayCount;
 
-		// process each selected unit
-		for (AStrategyUnit* CurrentUnit : SelectedUnits)
+		// draw the performance overlay if enabled
+		if (UDreamEatingPerfMonitor::IsOverlayEnabled())
 		{
-			if (IsValid(CurrentUnit))
+			if (UDreamEatingPerfMonitor* PerfMonitor = GetWorld()->GetSubsystem<UDreamEatingPerfMonitor>())
 			{
-				// project the unit's location to screen coordinates
-				FVector2D ScreenCoords;
+				const UStrategyUnitRegistry* Registry = GetWorld()->GetSubsystem<UStrategyUnitRegistry>();
 
-				if (PC->ProjectWorldLocationToScreen(CurrentUnit->GetActorLocation(), ScreenCoords, true))
+				const FDreamEatingPerfEntityCount EntityCounts[] =
 				{
-					// draw a selection string near the unit
-					const FString SelectionString = "Selected";
-					DrawText(SelectionString, FColor::White, ScreenCoords.X - 25.0f, ScreenCoords.Y + 25.0f, nullptr, 1.5f);
-				}
+					{ TEXT("Units"), Registry ? Registry->GetUnits().Num() : 0 },
+					{ TEXT("Selected units"), PC->GetSelectedUnits().Num() }
+				};
+
+				PerfMonitor->DrawOverlay(Canvas, EntityCounts);
 			}
-			
 		}
 	}
 
 }
+
+void AStrategyHUD::UpdateSelectionMarkers(const TArray<AStrategyUnit*>& SelectedUnits, uint32 SelectionVersion)
+{
+	if (!Canvas || !Canvas->SceneView)
+	{
+		MarkerTriangles.Reset();
+		return;
+	}
+
+	// gather the selected unit locations
+	UnitLocations.Reset(SelectedUnits.Num());
+
+	for (AStrategyUnit* CurrentUnit : SelectedUnits)
+	{
+		if (IsValid(CurrentUnit))
+		{
+			UnitLocations.Add(CurrentUnit->GetActorLocation());
+		}
+	}
+
+	const FMatrix ViewProjection = Canvas->SceneView->ViewMatrices.GetViewProjectionMatrix();
+
+	// skip the rebuild if nothing moved since the last frame
+	if (SelectionVersion == CachedSelectionVersion && ViewProjection.Equals(CachedViewProjection, 0.0f) && UnitLocations == CachedUnitLocations)
+	{
+		return;
+	}
+
+	CachedSelectionVersion = SelectionVersion;
+	CachedViewProjection = ViewProjection;
+	Swap(CachedUnitLocations, UnitLocations);
+
+	// project every location in one pass, the same way UCanvas::Project does
+	const double HalfX = Canvas->ClipX * 0.5;
+	const double HalfY = Canvas->ClipY * 0.5;
+	const FLinearColor Color = SelectionMarkerColor;
+	const float Size = SelectionMarkerSize;
+
+	MarkerTriangles.Reset(CachedUnitLocations.Num() * 2);
+
+	for (const FVector& Location : CachedUnitLocations)
+	{
+		const FVector4 Clip = ViewProjection.TransformFVector4(FVector4(Location, 1.0));
+
+		// skip units behind the view
+		if (Clip.W <= UE_SMALL_NUMBER)
+		{
+			continue;
+		}
+
+		const double InvW = 1.0 / Clip.W;
+		const FVector2D Center(HalfX + Clip.X * InvW * HalfX + SelectionMarkerOffset.X, HalfY - Clip.Y * InvW * HalfY + SelectionMarkerOffset.Y);
+
+		// skip markers outside the canvas
+		if (Center.X < -Size || Center.Y < -Size || Center.X > Canvas->ClipX + Size || Center.Y > Canvas->ClipY + Size)
+		{
+			continue;
+		}
+
+		// each marker is a diamond made of two triangles
+		const FVector2D Top = Center + FVector2D(0.0f, -Size);
+		const FVector2D Bottom = Center + FVector2D(0.0f, Size);
+
+		for (const float Side : { -Size, Size })
+		{
+			FCanvasUVTri& Triangle = MarkerTriangles.AddDefaulted_GetRef();
+			Triangle.V0_Pos = Top;
+			Triangle.V1_Pos = Center + FVector2D(Side, 0.0f);
+			Triangle.V2_Pos = Bottom;
+			Triangle.V0_Color = Triangle.V1_Color = Triangle.V2_Color = Color;
+		}
+	}
+}
@@ -4,13 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/HUD.h"
+#include "CanvasTypes.h"
 #include "StrategyHUD.generated.h"
 
 class UStrategyUI;
+class AStrategyUnit;
 
 /**
  *  Simple strategy game HUD
- *  Draws the selection box and unit selected overlays
+ *  Draws the selection box and unit selected overlays.
+ *  Selection markers are projected in a single pass and drawn as one batched triangle list,
+ *  and are only rebuilt when the selection, the camera or a selected unit's location changes.
  */
 UCLASS(abstract)
 class AStrategyHUD : public AHUD
@@ -42,6 +46,33 @@ protected:
 	UPROPERTY(EditAnywhere, Category="UI")
 	FLinearColor SelectionBoxColor;
 
+	/** Color of the selected unit markers */
+	UPROPERTY(EditAnywhere, Category="UI")
+	FLinearColor SelectionMarkerColor = FLinearColor::White;
+
+	/** Half size of the selected unit markers, in pixels */
+	UPROPERTY(EditAnywhere, Category="UI", meta = (ClampMin = 1, ClampMax = 100))
+	float SelectionMarkerSize = 6.0f;
+
+	/** Screen offset from each selected unit to its marker, in pixels */
+	UPROPERTY(EditAnywhere, Category="UI")
+	FVector2D SelectionMarkerOffset = FVector2D(0.0f, 25.0f);
+
+	/** Selection version the markers were built for */
+	uint32 CachedSelectionVersion = MAX_uint32;
+
+	/** View projection the markers were built for */
+	FMatrix CachedViewProjection = FMatrix::Identity;
+
+	/** Selected unit locations the markers were built for */
+	TArray<FVector> CachedUnitLocations;
+
+	/** Scratch list of selected unit locations for the current frame */
+	TArray<FVector> UnitLocations;
+
+	/** Batched selection marker triangles */
+	TArray<FCanvasUVTri> MarkerTriangles;
+
 public:
 
 	/** Initialization */
@@ -54,4 +85,7 @@ protected:
 
 	/** Draws the HUD */
 	virtual void DrawHUD() override;
+
+	/** Rebuilds the selection markers if the selection, camera or unit locations changed since the last frame */
+	void UpdateSelectionMarkers(const TArray<AStrategyUnit*>& SelectedUnits, uint32 SelectionVersion);
 };
@@ -11,10 +11,18 @@
 #include "Engine/World.h"
 #include "TwinStickNPCDestruction.h"
 #include "TimerManager.h"
+#include "DreamEatingNavMovementComponent.h"
+#include "DreamEatingDeterminism.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEatingHitchMonitor.h"
+#include "DreamEating.h"
 
-ATwinStickNPC::ATwinStickNPC()
+DECLARE_CYCLE_STAT(TEXT("Twin Stick Projectile Impact"), STAT_TwinStickProjectileImpact, STATGROUP_DreamEating);
+
+ATwinStickNPC::ATwinStickNPC(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UDreamEatingNavMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	// ensure we spawn an AI controller when we're spawned
 	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
@@ -49,6 +57,14 @@ void ATwinStickNPC::BeginPlay()
 		GM->IncreaseNPCs();
 	}
 
+	// natively we don't tick, so only Blueprints with an Event Tick need batching
+	if (bUseAggregatedTick && PrimaryActorTick.bCanEverTick)
+	{
+		if (UDreamEatingTickManager* TickManager = GetWorld()->GetSubsystem<UDreamEatingTickManager>())
+		{
+			TickManager->RegisterActor(this, this);
+		}
+	}
 }
 
 void ATwinStickNPC::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -57,6 +73,18 @@ void ATwinStickNPC::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	// clear the destruction timer
 	GetWorld()->GetTimerManager().ClearTimer(DestructionTimer);
+
+	// leave the tick batch
+	if (UDreamEatingTickManager* TickManager = GetWorld()->GetSubsystem<UDreamEatingTickManager>())
+	{
+		TickManager->Unregister(this);
+	}
+}
+
+void ATwinStickNPC::AggregatedTick(float DeltaTime)
+{
+	// match the time dilation the actor tick function would have applied
+	Tick(DeltaTime * CustomTimeDilation);
 }
 
 void ATwinStickNPC::Destroyed()
@@ -82,6 +110,9 @@ void ATwinStickNPC::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other,
 
 void ATwinStickNPC::ProjectileImpact(const FVector& ForwardVector)
 {
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_TwinStickProjectileImpact);
+	DREAMEATING_PERF_SCOPE(Projectiles);
+
 	// only handle damage if we haven't been hit yet
 	if (bHit)
 	{
@@ -91,6 +122,8 @@ void ATwinStickNPC::ProjectileImpact(const FVector& ForwardVector)
 	// raise the hit flag
 	bHit = true;
 
+	FDreamEatingGameplayEvents::Record(EDreamEatingGameplayEvent::Kill, Score, GetActorLocation());
+
 	// deactivate character movement
 	GetCharacterMovement()->Deactivate();
 
@@ -101,7 +134,7 @@ void ATwinStickNPC::ProjectileImpact(const FVector& ForwardVector)
 	}
 
 	// randomly spawn a pickup
-	if (FMath::RandRange(0, 100) < PickupSpawnChance)
+	if (UDreamEatingDeterminism::GetRandomStream(this, EDreamEatingRandomStream::Drops).RandRange(0, 100) < PickupSpawnChance)
 	{
 		ATwinStickPickup* Pickup = GetWorld()->SpawnActor<ATwinStickPickup>(PickupClass, GetActorTransform());
 	}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "DreamEatingTickManager.h"
 #include "TwinStickNPC.generated.h"
 
 class ATwinStickPickup;
@@ -15,7 +16,7 @@ class ATwinStickNPCDestruction;
  *  Awards points and randomly spawns pickups on death
  */
 UCLASS(abstract)
-class ATwinStickNPC : public ACharacter
+class ATwinStickNPC : public ACharacter, public FDreamEatingAggregatedTickable
 {
 	GENERATED_BODY()
 
@@ -44,6 +45,10 @@ protected:
 	/** Deferred destruction timer */
 	FTimerHandle DestructionTimer;
 
+	/** If true, a Blueprint Event Tick on this NPC is batched with every other NPC of the same class instead of ticking on its own */
+	UPROPERTY(EditAnywhere, Category="Ticking")
+	bool bUseAggregatedTick = true;
+
 public:
 
 	/** If true, this NPC has already been hit by a projectile and is being destroyed. Exposed to BP so it can be read by StateTree */
@@ -53,7 +58,7 @@ public:
 public:
 
 	/** Constructor */
-	ATwinStickNPC();
+	ATwinStickNPC(const FObjectInitializer& ObjectInitializer);
 
 protected:
 
@@ -74,6 +79,15 @@ public:
 	/** Tells the NPC to process a projectile impact */
 	void ProjectileImpact(const FVector& ForwardVector);
 
+	/** Returns the pickup drop chance */
+	int32 GetPickupSpawnChance() const { return PickupSpawnChance; }
+
+	/** Overrides the pickup drop chance. Used by balance sweeps */
+	void SetPickupSpawnChance(int32 InPickupSpawnChance) { PickupSpawnChance = FMath::Clamp(InPickupSpawnChance, 0, 100); }
+
+	/** Runs the actor's own tick from the aggregated tick manager */
+	virtual void AggregatedTick(float DeltaTime) override;
+
 protected:
 
 	/** Called from timer to complete the destruction process for this NPC */
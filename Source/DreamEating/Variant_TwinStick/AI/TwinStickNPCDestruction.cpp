@@ -2,9 +2,22 @@
 
 
 #include "TwinStickNPCDestruction.h"
+#include "DreamEatingEffects.h"
+#include "Engine/World.h"
 
 ATwinStickNPCDestruction::ATwinStickNPCDestruction()
 {
- 	PrimaryActorTick.bCanEverTick = true;
+ 	PrimaryActorTick.bCanEverTick = false;
 
-}
\ No newline at end of file
+}
+
+void ATwinStickNPCDestruction::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// destruction effects are cosmetic, so they can be dropped when many NPCs die at once
+	if (UDreamEatingEffects* Effects = GetWorld()->GetSubsystem<UDreamEatingEffects>())
+	{
+		Effects->SpawnEffect(DestructionFX, GetActorLocation(), GetActorRotation(), GetActorScale3D(), EDreamEatingEffectPriority::Cosmetic);
+	}
+}
@@ -6,6 +6,8 @@
 #include "GameFramework/Actor.h"
 #include "TwinStickNPCDestruction.generated.h"
 
+class UNiagaraSystem;
+
 /**
  *  A NPC destruction proxy for a Twin Stick Shooter game
  *  Replaces the NPC when it is destroyed,
@@ -15,10 +17,21 @@ UCLASS(abstract)
 class ATwinStickNPCDestruction : public AActor
 {
 	GENERATED_BODY()
+
+protected:
+
+	/** Effect to spawn through the pooled effects service when the proxy appears */
+	UPROPERTY(EditAnywhere, Category="Destruction")
+	UNiagaraSystem* DestructionFX;
 	
 public:
 
 	/** Constructor */
 	ATwinStickNPCDestruction();
 
+protected:
+
+	/** Initialization */
+	virtual void BeginPlay() override;
+
 };
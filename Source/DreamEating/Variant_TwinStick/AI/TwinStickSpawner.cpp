@@ -9,10 +9,21 @@
 #include "Kismet/GameplayStatics.h"
 #include "TwinStickNPC.h"
 #include "TwinStickGameMode.h"
+#include "DreamEatingDeterminism.h"
+#include "DreamEatingFormation.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEatingHitchMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Twin Stick Spawn NPC"), STAT_TwinStickSpawnNPC, STATGROUP_DreamEating);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Twin Stick NPC Spawns"), STAT_TwinStickNPCSpawns, STATGROUP_DreamEating);
+
+/** Number of random points to try before a spawn attempt fails */
+static constexpr int32 TwinStickSpawnerMaxSampleAttempts = 8;
 
 ATwinStickSpawner::ATwinStickSpawner()
 {
- 	PrimaryActorTick.bCanEverTick = true;
+ 	PrimaryActorTick.bCanEverTick = false;
 
 }
 
@@ -49,10 +60,23 @@ void ATwinStickSpawner::EndPlay(EEndPlayReason::Type EndPlayReason)
 	GetWorld()->GetTimerManager().ClearTimer(SpawnNPCTimer);
 }
 
+void ATwinStickSpawner::SetSpawnSettings(float InSpawnGroupDelay, int32 InSpawnGroupSize, float InMinSpawnDelay, float InMaxSpawnDelay)
+{
+	// timers with a zero rate are cleared instead of set, so keep the delays positive
+	SpawnGroupDelay = FMath::Max(InSpawnGroupDelay, 0.01f);
+	SpawnGroupSize = FMath::Max(InSpawnGroupSize, 1);
+	MinSpawnDelay = FMath::Max(InMinSpawnDelay, 0.01f);
+	MaxSpawnDelay = FMath::Max(InMaxSpawnDelay, MinSpawnDelay);
+
+	// restart the group timer with the new delay
+	GetWorld()->GetTimerManager().SetTimer(SpawnGroupTimer, this, &ATwinStickSpawner::SpawnNPCGroup, SpawnGroupDelay, true);
+}
+
 void ATwinStickSpawner::SpawnNPCGroup()
 {
-	// reset the group spawn counter
+	// reset the group spawn counters
 	SpawnCount = 0;
+	SpawnFailures = 0;
 
 	// check if we're still under the max NPC cap
 	if (ATwinStickGameMode* GM = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
@@ -66,25 +90,63 @@ void ATwinStickSpawner::SpawnNPCGroup()
 
 void ATwinStickSpawner::SpawnNPC()
 {
-	FTransform SpawnTransform;
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_TwinStickSpawnNPC);
+	DREAMEATING_PERF_SCOPE(Spawning);
+
+	// find a random point around the spawner. Use the seeded spawning stream and project it,
+	// since the navigation system's own random point queries can't be seeded
+	FRandomStream& RandomStream = UDreamEatingDeterminism::GetRandomStream(this, EDreamEatingRandomStream::Spawning);
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	FNavLocation OriginLoc;
+	const bool bOriginOnNav = NavSys && NavData && NavSys->ProjectPointToNavigation(GetActorLocation(), OriginLoc, INVALID_NAVEXTENT, NavData);
 
-	// find a random point around the spawner
-	FVector SpawnLoc;
-	if (UNavigationSystemV1::K2_GetRandomReachablePointInRadius(GetWorld(), GetActorLocation(), SpawnLoc, SpawnRadius, NavData))
+	bool bSpawned = false;
+
+	for (int32 Attempt = 0; bOriginOnNav && Attempt < TwinStickSpawnerMaxSampleAttempts && !bSpawned; ++Attempt)
 	{
-		SpawnTransform.SetLocation(SpawnLoc);
+		const FVector SampleLoc = FDreamEatingFormation::SampleDisc(RandomStream, GetActorLocation(), SpawnRadius);
+		FNavLocation SpawnLoc;
+
+		if (!NavSys->ProjectPointToNavigation(SampleLoc, SpawnLoc, INVALID_NAVEXTENT, NavData))
+		{
+			continue;
+		}
+
+		// reject points on navmesh islands the spawner can't reach, like the old reachable point query did.
+		// A path test only checks that the goal is reachable, so it skips building the path's points
+		const FPathFindingQuery Query(this, *NavData, OriginLoc.Location, SpawnLoc.Location);
+
+		if (!NavSys->TestPathSync(Query, EPathFindingMode::Regular))
+		{
+			continue;
+		}
 
 		// spawn the NPC
-		ATwinStickNPC* NPC = GetWorld()->SpawnActor<ATwinStickNPC>(NPCClass, SpawnTransform);
+		if (GetWorld()->SpawnActor<ATwinStickNPC>(NPCClass, FTransform(SpawnLoc.Location)))
+		{
+			bSpawned = true;
+
+			INC_DWORD_STAT(STAT_TwinStickNPCSpawns);
+			FDreamEatingGameplayEvents::Record(EDreamEatingGameplayEvent::Spawn, 1, SpawnLoc.Location);
+		}
 	}
 
-	// increase the spawn counter
-	++SpawnCount;
+	// only a spawned NPC uses up a slot in the group. Give up on the rest of the group if it keeps failing
+	if (bSpawned)
+	{
+		++SpawnCount;
+	}
+	else if (++SpawnFailures >= SpawnGroupSize)
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("%s couldn't find a reachable spawn point within %.0f cm, skipping the rest of the group"), *GetName(), SpawnRadius);
+		return;
+	}
 
 	// do we still have enemies left to spawn?
 	if (SpawnCount < SpawnGroupSize)
 	{
-		GetWorld()->GetTimerManager().SetTimer(SpawnNPCTimer, this, &ATwinStickSpawner::SpawnNPC, FMath::RandRange(MinSpawnDelay, MaxSpawnDelay), false);
+		GetWorld()->GetTimerManager().SetTimer(SpawnNPCTimer, this, &ATwinStickSpawner::SpawnNPC, RandomStream.FRandRange(MinSpawnDelay, MaxSpawnDelay), false);
 	}
 
 }
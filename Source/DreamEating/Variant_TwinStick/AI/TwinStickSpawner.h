@@ -46,6 +46,9 @@ protected:
 	/** Number of NPCs spawned in the current group */
 	int32 SpawnCount = 0;
 
+	/** Number of spawn attempts in the current group that found no reachable point */
+	int32 SpawnFailures = 0;
+
 	/** NPC group spawn timer */
 	FTimerHandle SpawnGroupTimer;
 
@@ -68,6 +71,23 @@ protected:
 	/** Gameplay cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
+public:
+
+	/** Overrides the spawn group settings and restarts the group timer. Used by benchmarks to force a spawn rate */
+	void SetSpawnSettings(float InSpawnGroupDelay, int32 InSpawnGroupSize, float InMinSpawnDelay, float InMaxSpawnDelay);
+
+	/** Returns the time delay between enemy group spawns */
+	float GetSpawnGroupDelay() const { return SpawnGroupDelay; }
+
+	/** Returns the number of NPCs to spawn per group */
+	int32 GetSpawnGroupSize() const { return SpawnGroupSize; }
+
+	/** Returns the min time delay between individual NPC spawns */
+	float GetMinSpawnDelay() const { return MinSpawnDelay; }
+
+	/** Returns the max time delay between individual NPC spawns */
+	float GetMaxSpawnDelay() const { return MaxSpawnDelay; }
+
 protected:
 
 	/** Spawns a new NPC group */
@@ -6,11 +6,18 @@
 #include "StateTreeExecutionTypes.h"
 #include "GameFramework/Character.h"
 #include "Kismet/GameplayStatics.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("StateTree Get Player Task"), STAT_StateTreeGetPlayerTask, STATGROUP_DreamEating);
 
 #define LOCTEXT_NAMESPACE "TopDownTemplate"
 
 EStateTreeRunStatus FStateTreeGetPlayerTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
 {
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_StateTreeGetPlayerTask);
+	DREAMEATING_PERF_SCOPE(AI);
+
 	// get the instance data
 	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
@@ -8,10 +8,15 @@
 #include "Engine/World.h"
 #include "TimerManager.h"
 #include "TwinStickNPC.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEatingHitchMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Twin Stick AoE Tick"), STAT_TwinStickAoETick, STATGROUP_DreamEating);
 
 ATwinStickAoEAttack::ATwinStickAoEAttack()
 {
- 	PrimaryActorTick.bCanEverTick = true;
+ 	PrimaryActorTick.bCanEverTick = false;
 
 	// create the root component
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
@@ -55,10 +60,15 @@ void ATwinStickAoEAttack::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 void ATwinStickAoEAttack::TickAoE()
 {
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_TwinStickAoETick);
+	DREAMEATING_PERF_SCOPE(Projectiles);
+
 	// find all actors overlapping the NPC
 	TArray<AActor*> Overlaps;
 	CollisionSphere->GetOverlappingActors(Overlaps, ATwinStickNPC::StaticClass());
 
+	FDreamEatingGameplayEvents::Record(EDreamEatingGameplayEvent::AoE, Overlaps.Num(), GetActorLocation());
+
 	// process each overlapping actor
 	for (AActor* Current : Overlaps)
 	{
@@ -9,7 +9,7 @@
 
 ATwinStickPickup::ATwinStickPickup()
 {
- 	PrimaryActorTick.bCanEverTick = true;
+ 	PrimaryActorTick.bCanEverTick = false;
 
 	// create the root component
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
@@ -6,10 +6,12 @@
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "TwinStickNPC.h"
+#include "TwinStickGameMode.h"
+#include "DreamEating.h"
 
 ATwinStickProjectile::ATwinStickProjectile()
 {
- 	PrimaryActorTick.bCanEverTick = true;
+ 	PrimaryActorTick.bCanEverTick = false;
 
 	// this actor will be destroyed automatically once InitialLifeSpan expires
 	InitialLifeSpan = 2.0f;
@@ -43,6 +45,27 @@ ATwinStickProjectile::ATwinStickProjectile()
 	ProjectileMovement->OnProjectileStop.AddDynamic(this, &ATwinStickProjectile::OnProjectileStop);
 }
 
+void ATwinStickProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// count the projectile so the HUD doesn't have to look for them
+	if (ATwinStickGameMode* GM = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GM->IncreaseProjectiles();
+	}
+}
+
+void ATwinStickProjectile::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	if (ATwinStickGameMode* GM = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GM->DecreaseProjectiles();
+	}
+}
+
 void ATwinStickProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
 {
 	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
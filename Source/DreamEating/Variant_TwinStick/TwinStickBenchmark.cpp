@@ -0,0 +1,395 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "TwinStickBenchmark.h"
+#include "TwinStickCharacter.h"
+#include "TwinStickGameMode.h"
+#include "TwinStickSpawner.h"
+#include "TwinStickProjectile.h"
+#include "TwinStickAoEAttack.h"
+#include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "DreamEating.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTwinStickBenchmark(
+	TEXT("DreamEating.TwinStick.Benchmark"),
+	TEXT("Runs the Twin Stick load scenarios and writes a JSON report. Scenarios: NPCs100, NPCs500, NPCs1000, ProjectileStorm, MassAoE. Usage: DreamEating.TwinStick.Benchmark [Scenario=All] [Seconds=10]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTwinStickBenchmark* Benchmark = World ? World->GetSubsystem<UTwinStickBenchmark>() : nullptr)
+		{
+			const FString Scenario = Args.Num() > 0 ? Args[0] : TEXT("All");
+			const float Seconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 10.0f;
+
+			Benchmark->StartBenchmark(Scenario, Seconds);
+		}
+	}));
+
+/** Longest time to wait for a scenario's population to fill up */
+static constexpr float TwinStickBenchmarkMaxWarmUp = 30.0f;
+
+/** Seed for the scripted input, so every run drops AoEs in the same places */
+static constexpr int32 TwinStickBenchmarkSeed = 1337;
+
+bool UTwinStickBenchmark::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTwinStickBenchmark::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+		World->RemoveOnActorDestroyededHandler(ActorDestroyedHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void UTwinStickBenchmark::Tick(float DeltaTime)
+{
+	if (Phase == EPhase::Idle)
+	{
+		return;
+	}
+
+	Elapsed += DeltaTime;
+
+	ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode());
+	const int32 NumNPCs = GameMode ? GameMode->GetNPCCount() : 0;
+
+	DriveInput(DeltaTime);
+
+	if (Phase == EPhase::WarmUp)
+	{
+		// start measuring once the population is close to its target
+		if ((NumNPCs >= Queue[ScenarioIndex].NumNPCs * 0.9f && Elapsed >= 1.0f) || Elapsed >= TwinStickBenchmarkMaxWarmUp)
+		{
+			FDreamEatingBenchmarkScenario& Scenario = Report->AddScenario(Queue[ScenarioIndex].Name);
+			Scenario.SetMetric(TEXT("npc_target"), Queue[ScenarioIndex].NumNPCs);
+			Scenario.SetMetric(TEXT("warmup_seconds"), Elapsed);
+
+			Phase = EPhase::Measure;
+			Elapsed = 0.0f;
+			TotalSpawns = 0;
+			TotalDestroys = 0;
+		}
+	}
+	else if (FDreamEatingBenchmarkScenario* Scenario = Report->GetCurrentScenario())
+	{
+		Scenario->SampleFrame();
+		Scenario->SampleCounter(TEXT("npcs"), NumNPCs);
+		Scenario->SampleCounter(TEXT("projectiles"), LiveProjectiles);
+		Scenario->SampleCounter(TEXT("aoe_attacks"), LiveAoEs);
+		Scenario->SampleCounter(TEXT("spawns"), SpawnsThisFrame);
+		Scenario->SampleCounter(TEXT("destroys"), DestroysThisFrame);
+
+		TotalSpawns += SpawnsThisFrame;
+		TotalDestroys += DestroysThisFrame;
+
+		if (Elapsed >= Duration)
+		{
+			FinishScenario();
+		}
+	}
+
+	SpawnsThisFrame = 0;
+	DestroysThisFrame = 0;
+}
+
+TStatId UTwinStickBenchmark::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTwinStickBenchmark, STATGROUP_Tickables);
+}
+
+bool UTwinStickBenchmark::StartBenchmark(const FString& ScenarioName, float InDuration)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Twin Stick benchmark is already running"));
+		return false;
+	}
+
+	ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode());
+	Player = Cast<ATwinStickCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
+
+	if (!GameMode || !Player.IsValid())
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Twin Stick benchmark needs a Twin Stick game mode and player character"));
+		return false;
+	}
+
+	static const FScenario Scenarios[] =
+	{
+		{ TEXT("NPCs100"), 100, false, false },
+		{ TEXT("NPCs500"), 500, false, false },
+		{ TEXT("NPCs1000"), 1000, false, false },
+		{ TEXT("ProjectileStorm"), 100, true, false },
+		{ TEXT("MassAoE"), 500, false, true }
+	};
+
+	Queue.Reset();
+
+	for (const FScenario& Scenario : Scenarios)
+	{
+		if (ScenarioName == TEXT("All") || ScenarioName == Scenario.Name)
+		{
+			Queue.Add(Scenario);
+		}
+	}
+
+	if (Queue.Num() == 0)
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Twin Stick benchmark has no scenario named %s"), *ScenarioName);
+		return false;
+	}
+
+	Duration = FMath::Max(InDuration, 1.0f);
+	ScenarioIndex = 0;
+	PreviousNPCCap = GameMode->GetNPCCap();
+
+	// every scenario overrides the spawn rates, so keep the level's own to put back afterwards
+	PreviousSpawnerSettings.Reset();
+
+	for (TActorIterator<ATwinStickSpawner> It(GetWorld()); It; ++It)
+	{
+		PreviousSpawnerSettings.Add({ *It, It->GetSpawnGroupDelay(), It->GetSpawnGroupSize(), It->GetMinSpawnDelay(), It->GetMaxSpawnDelay() });
+	}
+	RandomStream.Initialize(TwinStickBenchmarkSeed);
+	Report = MakeUnique<FDreamEatingBenchmarkReport>(TEXT("TwinStickBenchmark"));
+
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UTwinStickBenchmark::OnActorSpawned));
+	ActorDestroyedHandle = GetWorld()->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &UTwinStickBenchmark::OnActorDestroyed));
+
+	StartScenario();
+
+	return true;
+}
+
+void UTwinStickBenchmark::StartScenario()
+{
+	const FScenario& Scenario = Queue[ScenarioIndex];
+
+	Phase = EPhase::WarmUp;
+	Elapsed = 0.0f;
+	AoECountdown = 0.0f;
+	LiveProjectiles = 0;
+	LiveAoEs = 0;
+
+	// start from an empty arena and force the population
+	if (ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GameMode->ClearArena();
+		GameMode->SetNPCCap(Scenario.NumNPCs);
+	}
+
+	TArray<ATwinStickSpawner*> Spawners;
+
+	for (TActorIterator<ATwinStickSpawner> It(GetWorld()); It; ++It)
+	{
+		Spawners.Add(*It);
+	}
+
+	if (Spawners.Num() == 0)
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Twin Stick benchmark: no spawners in the level, %s will run without NPCs"), Scenario.Name);
+	}
+
+	// split the population across the spawners so it fills within a few seconds
+	const int32 GroupSize = FMath::DivideAndRoundUp(Scenario.NumNPCs, FMath::Max(Spawners.Num(), 1));
+
+	for (ATwinStickSpawner* Spawner : Spawners)
+	{
+		Spawner->SetSpawnSettings(1.0f, GroupSize, 0.01f, 0.01f);
+	}
+
+	UE_LOG(LogDreamEating, Display, TEXT("Twin Stick benchmark: warming up %s"), Scenario.Name);
+}
+
+void UTwinStickBenchmark::FinishScenario()
+{
+	if (FDreamEatingBenchmarkScenario* Scenario = Report->GetCurrentScenario())
+	{
+		Scenario->SetMetric(TEXT("total_spawns"), TotalSpawns);
+		Scenario->SetMetric(TEXT("total_destroys"), TotalDestroys);
+	}
+
+	if (++ScenarioIndex < Queue.Num())
+	{
+		StartScenario();
+	}
+	else
+	{
+		FinishBenchmark();
+	}
+}
+
+void UTwinStickBenchmark::FinishBenchmark()
+{
+	Phase = EPhase::Idle;
+
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	GetWorld()->RemoveOnActorDestroyededHandler(ActorDestroyedHandle);
+
+	if (ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GameMode->ClearArena();
+		GameMode->SetNPCCap(PreviousNPCCap);
+	}
+
+	for (const FSpawnerSettings& Settings : PreviousSpawnerSettings)
+	{
+		if (ATwinStickSpawner* Spawner = Settings.Spawner.Get())
+		{
+			Spawner->SetSpawnSettings(Settings.SpawnGroupDelay, Settings.SpawnGroupSize, Settings.MinSpawnDelay, Settings.MaxSpawnDelay);
+		}
+	}
+
+	PreviousSpawnerSettings.Reset();
+
+	Report->Finish();
+	Report.Reset();
+}
+
+void UTwinStickBenchmark::DriveInput(float DeltaTime)
+{
+	ATwinStickCharacter* PlayerCharacter = Player.Get();
+
+	if (!PlayerCharacter)
+	{
+		return;
+	}
+
+	const FScenario& Scenario = Queue[ScenarioIndex];
+	const float Time = GetWorld()->GetTimeSeconds();
+
+	// circle the arena while sweeping the aim, which also fires on autofire
+	PlayerCharacter->DoMove(FMath::Cos(Time * 0.5f), FMath::Sin(Time * 0.5f));
+	PlayerCharacter->DoAim(FMath::Cos(Time * 2.0f), FMath::Sin(Time * 2.0f));
+
+	if (Scenario.bProjectileStorm)
+	{
+		PlayerCharacter->DoShoot();
+	}
+
+	AoECountdown -= DeltaTime;
+
+	if (AoECountdown > 0.0f)
+	{
+		return;
+	}
+
+	if (Scenario.bMassAoE)
+	{
+		// drop AoEs around the player, where the NPCs converge
+		AoECountdown = 0.25f;
+
+		const FVector Offset = FVector(RandomStream.FRandRange(-1.0f, 1.0f), RandomStream.FRandRange(-1.0f, 1.0f), 0.0f) * 1500.0f;
+
+		GetWorld()->SpawnActor<ATwinStickAoEAttack>(PlayerCharacter->GetAoEAttackClass(), FTransform(PlayerCharacter->GetActorLocation() + Offset));
+	}
+	else
+	{
+		// the regular AoE input, topped up with an item so it's never blocked
+		AoECountdown = 1.0f;
+
+		PlayerCharacter->AddPickup();
+		PlayerCharacter->DoAoEAttack();
+	}
+}
+
+void UTwinStickBenchmark::OnActorSpawned(AActor* Actor)
+{
+	++SpawnsThisFrame;
+
+	if (Actor->IsA<ATwinStickProjectile>())
+	{
+		++LiveProjectiles;
+	}
+	else if (Actor->IsA<ATwinStickAoEAttack>())
+	{
+		++LiveAoEs;
+	}
+}
+
+void UTwinStickBenchmark::OnActorDestroyed(AActor* Actor)
+{
+	++DestroysThisFrame;
+
+	if (Actor->IsA<ATwinStickProjectile>())
+	{
+		LiveProjectiles = FMath::Max(LiveProjectiles - 1, 0);
+	}
+	else if (Actor->IsA<ATwinStickAoEAttack>())
+	{
+		LiveAoEs = FMath::Max(LiveAoEs - 1, 0);
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Longest time the automation test waits for every scenario to finish, warm ups included */
+static constexpr double TwinStickBenchmarkTestTimeout = 600.0;
+
+/** Returns the benchmark subsystem of the running game world, if any */
+static UTwinStickBenchmark* GetTwinStickBenchmark()
+{
+	UWorld* World = AutomationCommon::GetAnyGameWorld();
+	return World ? World->GetSubsystem<UTwinStickBenchmark>() : nullptr;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FStartTwinStickBenchmarkCommand, FAutomationTestBase*, Test, FString, ScenarioName, float, Seconds);
+
+bool FStartTwinStickBenchmarkCommand::Update()
+{
+	UTwinStickBenchmark* Benchmark = GetTwinStickBenchmark();
+
+	if (!Benchmark || !Benchmark->StartBenchmark(ScenarioName, Seconds))
+	{
+		Test->AddError(TEXT("Could not start the Twin Stick benchmark, see the log for details"));
+	}
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FWaitForTwinStickBenchmarkCommand, FAutomationTestBase*, Test);
+
+bool FWaitForTwinStickBenchmarkCommand::Update()
+{
+	UTwinStickBenchmark* Benchmark = GetTwinStickBenchmark();
+
+	if (!Benchmark || !Benchmark->IsRunning())
+	{
+		return true;
+	}
+
+	if (GetCurrentRunTime() > TwinStickBenchmarkTestTimeout)
+	{
+		Test->AddError(TEXT("Twin Stick benchmark timed out"));
+		return true;
+	}
+
+	return false;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwinStickBenchmarkTest, "DreamEating.Bench.TwinStick",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FTwinStickBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// run every scenario in the arena, the report is written by the benchmark itself
+	AutomationOpenMap(TEXT("/Game/Variant_TwinStick/LVL_TwinStick"));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.0f));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartTwinStickBenchmarkCommand(this, TEXT("All"), 10.0f));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitForTwinStickBenchmarkCommand(this));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,169 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DreamEatingBenchmarkReport.h"
+#include "TwinStickBenchmark.generated.h"
+
+class ATwinStickCharacter;
+class ATwinStickSpawner;
+
+/**
+ *  Headless load benchmark for the Twin Stick Shooter variant.
+ *  Runs fixed duration scenarios in the loaded arena: forces the NPC cap and spawner rates, drives the player
+ *  with scripted move, aim, autofire and AoE inputs, and samples game thread time and actor counts every frame.
+ *  Results are written as JSON through the shared benchmark report.
+ *  Run with DreamEating.TwinStick.Benchmark [Scenario=All] [Seconds=10], or headless through the automation test with
+ *  -game -nullrhi -ExecCmds="Automation RunTests DreamEating.Bench.TwinStick; Quit"
+ */
+UCLASS()
+class UTwinStickBenchmark : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Settings for a single scenario */
+	struct FScenario
+	{
+		/** Scenario name */
+		const TCHAR* Name;
+
+		/** NPC population to hold during the scenario */
+		int32 NumNPCs;
+
+		/** If true, the player fires a projectile every frame instead of on autofire */
+		bool bProjectileStorm;
+
+		/** If true, AoE attacks are dropped at random points around the player several times a second */
+		bool bMassAoE;
+	};
+
+	/** Spawner settings to restore once the benchmark is done */
+	struct FSpawnerSettings
+	{
+		/** Spawner the settings belong to */
+		TWeakObjectPtr<ATwinStickSpawner> Spawner;
+
+		/** Time delay between enemy group spawns */
+		float SpawnGroupDelay = 0.0f;
+
+		/** Number of NPCs to spawn per group */
+		int32 SpawnGroupSize = 0;
+
+		/** Min time delay between individual NPC spawns */
+		float MinSpawnDelay = 0.0f;
+
+		/** Max time delay between individual NPC spawns */
+		float MaxSpawnDelay = 0.0f;
+	};
+
+	/** Benchmark phases */
+	enum class EPhase : uint8
+	{
+		Idle,
+		WarmUp,
+		Measure
+	};
+
+	/** Current phase */
+	EPhase Phase = EPhase::Idle;
+
+	/** Scenarios queued for this run */
+	TArray<FScenario> Queue;
+
+	/** Index of the scenario being run */
+	int32 ScenarioIndex = 0;
+
+	/** Report the scenarios are written to */
+	TUniquePtr<FDreamEatingBenchmarkReport> Report;
+
+	/** Player character driven by the scripted input */
+	TWeakObjectPtr<ATwinStickCharacter> Player;
+
+	/** Duration of each measured scenario, in seconds */
+	float Duration = 10.0f;
+
+	/** Time elapsed in the current phase */
+	float Elapsed = 0.0f;
+
+	/** Time until the next mass AoE drop */
+	float AoECountdown = 0.0f;
+
+	/** Random stream for the scripted input */
+	FRandomStream RandomStream;
+
+	/** NPC cap before the benchmark started */
+	int32 PreviousNPCCap = 0;
+
+	/** Spawner settings before the benchmark started */
+	TArray<FSpawnerSettings> PreviousSpawnerSettings;
+
+	/** Actors spawned this frame */
+	int32 SpawnsThisFrame = 0;
+
+	/** Actors destroyed this frame */
+	int32 DestroysThisFrame = 0;
+
+	/** Projectiles currently alive */
+	int32 LiveProjectiles = 0;
+
+	/** AoE attacks currently alive */
+	int32 LiveAoEs = 0;
+
+	/** Total actors spawned while measuring */
+	int64 TotalSpawns = 0;
+
+	/** Total actors destroyed while measuring */
+	int64 TotalDestroys = 0;
+
+	/** World actor spawn listener */
+	FDelegateHandle ActorSpawnedHandle;
+
+	/** World actor destruction listener */
+	FDelegateHandle ActorDestroyedHandle;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+	/** Drives the player and samples the current scenario */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Starts the benchmark. Runs every scenario, or only the one with the given name. Returns false if it couldn't start */
+	bool StartBenchmark(const FString& ScenarioName, float InDuration);
+
+	/** Returns true while the benchmark is running */
+	bool IsRunning() const { return Phase != EPhase::Idle; }
+
+protected:
+
+	/** Forces the population for the current scenario and waits for it to fill up */
+	void StartScenario();
+
+	/** Records the results of the current scenario and moves on to the next one */
+	void FinishScenario();
+
+	/** Restores the level settings and writes the report */
+	void FinishBenchmark();
+
+	/** Applies the scripted player input for this frame */
+	void DriveInput(float DeltaTime);
+
+	/** Counts spawned actors */
+	void OnActorSpawned(AActor* Actor);
+
+	/** Counts destroyed actors */
+	void OnActorDestroyed(AActor* Actor);
+};
@@ -13,6 +13,12 @@
 #include "TwinStickProjectile.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
+#include "DreamEatingGroundGrid.h"
+#include "DreamEatingSceneQueries.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_CYCLE_STAT(TEXT("Twin Stick Character Tick"), STAT_TwinStickCharacterTick, STATGROUP_DreamEating);
 
 ATwinStickCharacter::ATwinStickCharacter()
 {
@@ -52,6 +58,15 @@ void ATwinStickCharacter::BeginPlay()
 	
 	// update the items count
 	UpdateItems();
+
+	// optionally batch our tick with the aggregated tick manager
+	if (bUseAggregatedTick)
+	{
+		if (UDreamEatingTickManager* TickManager = GetWorld()->GetSubsystem<UDreamEatingTickManager>())
+		{
+			TickManager->RegisterActor(this, this);
+		}
+	}
 }
 
 void ATwinStickCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -60,6 +75,12 @@ void ATwinStickCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	/** Clear the autofire timer */
 	GetWorld()->GetTimerManager().ClearTimer(AutoFireTimer);
+
+	/** Leave the tick batch */
+	if (UDreamEatingTickManager* TickManager = GetWorld()->GetSubsystem<UDreamEatingTickManager>())
+	{
+		TickManager->Unregister(this);
+	}
 }
 
 void ATwinStickCharacter::NotifyControllerChanged()
@@ -72,6 +93,9 @@ void ATwinStickCharacter::NotifyControllerChanged()
 
 void ATwinStickCharacter::Tick(float DeltaTime)
 {
+	DREAMEATING_SCOPE_CYCLE_COUNTER(STAT_TwinStickCharacterTick);
+	DREAMEATING_PERF_SCOPE(Movement);
+
 	Super::Tick(DeltaTime);
 
 	// get the current rotation
@@ -82,12 +106,31 @@ void ATwinStickCharacter::Tick(float DeltaTime)
 	{
 		if (PlayerController)
 		{
-			// get the cursor world location
-			FHitResult OutHit; 
-			PlayerController->GetHitResultUnderCursorByChannel(MouseAimTraceChannel, true, OutHit);
+			// get the cursor world location, from the baked ground grid if the level has one
+			UDreamEatingGroundGrid* GroundGrid = GetWorld()->GetSubsystem<UDreamEatingGroundGrid>();
+
+			if (!GroundGrid || !GroundGrid->GetGroundUnderCursor(PlayerController, MouseAimLocation))
+			{
+				// aiming can lag a frame behind the cursor, so let the trace run with the async batch
+				if (UDreamEatingSceneQueries* SceneQueries = GetWorld()->GetSubsystem<UDreamEatingSceneQueries>())
+				{
+					SceneQueries->TraceUnderCursor(EDreamEatingQueryLatency::NextFrame, PlayerController, UEngineTypes::ConvertToCollisionChannel(MouseAimTraceChannel), true,
+						FDreamEatingQueryDelegate::CreateWeakLambda(this, [this](bool bBlockingHit, const FHitResult& OutHit)
+						{
+							MouseAimLocation = OutHit.Location;
+						}));
+				}
+				else
+				{
+					FHitResult OutHit; 
+					PlayerController->GetHitResultUnderCursorByChannel(MouseAimTraceChannel, true, OutHit);
+
+					MouseAimLocation = OutHit.Location;
+				}
+			}
 
 			// find the aim rotation 
-			const FRotator AimRot = UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), OutHit.Location);
+			const FRotator AimRot = UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), MouseAimLocation);
 
 			// save the aim angle
 			AimAngle = AimRot.Yaw;
@@ -109,6 +152,12 @@ void ATwinStickCharacter::Tick(float DeltaTime)
 	}
 }
 
+void ATwinStickCharacter::AggregatedTick(float DeltaTime)
+{
+	// match the time dilation the actor tick function would have applied
+	Tick(DeltaTime * CustomTimeDilation);
+}
+
 void ATwinStickCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
@@ -273,6 +322,9 @@ void ATwinStickCharacter::DoAoEAttack()
 
 void ATwinStickCharacter::HandleDamage(float Damage, const FVector& DamageDirection)
 {
+	// count the hit
+	++HitsTaken;
+
 	// calculate the knockback vector
 	FVector LaunchVector = DamageDirection;
 	LaunchVector.Z = 0.0f;
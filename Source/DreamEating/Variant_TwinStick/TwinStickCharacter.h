@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/PlayerController.h"
+#include "DreamEatingTickManager.h"
 #include "TwinStickCharacter.generated.h"
 
 class USpringArmComponent;
@@ -21,7 +22,7 @@ class ATwinStickProjectile;
  *  Fires projectiles and spawns AoE attacks.
  */
 UCLASS(abstract)
-class ATwinStickCharacter : public ACharacter
+class ATwinStickCharacter : public ACharacter, public FDreamEatingAggregatedTickable
 {
 	GENERATED_BODY()
 
@@ -83,6 +84,9 @@ protected:
 	UPROPERTY(EditAnywhere, Category="AoE")
 	int32 Items = 1;
 
+	/** Number of hits taken so far */
+	int32 HitsTaken = 0;
+
 	/** Knockback impulse to apply to the character when they're damaged */
 	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm"))
 	float KnockbackStrength = 2500.0f;
@@ -101,6 +105,9 @@ protected:
 	/** Aim Yaw Angle in degrees */
 	float AimAngle = 0.0f;
 
+	/** Last world location found under the mouse cursor */
+	FVector MouseAimLocation = FVector::ZeroVector;
+
 	/** Pointer to the player controller assigned to this character */
 	TObjectPtr<APlayerController> PlayerController;
 
@@ -120,6 +127,10 @@ protected:
 	/** Timer to handle stick autofire */
 	FTimerHandle AutoFireTimer;
 
+	/** If true, the aim update runs from the aggregated tick manager instead of this character's own tick */
+	UPROPERTY(EditAnywhere, Category="Ticking")
+	bool bUseAggregatedTick = false;
+
 public:
 	
 	/** Constructor */
@@ -141,6 +152,9 @@ public:
 	/** Updates the character's rotation to face the aim direction */
 	virtual void Tick(float DeltaTime) override;
 
+	/** Runs the actor's own tick from the aggregated tick manager */
+	virtual void AggregatedTick(float DeltaTime) override;
+
 	/** Adds input bindings */
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
@@ -191,6 +205,9 @@ public:
 	/** Applies collision impact to the player */
 	void HandleDamage(float Damage, const FVector& DamageDirection);
 
+	/** Returns the number of hits this character has taken */
+	int32 GetHitsTaken() const { return HitsTaken; }
+
 protected:
 
 	/** Allows Blueprint code to react to damage */
@@ -202,6 +219,9 @@ public:
 	/** Gives the player a pickup item */
 	void AddPickup();
 
+	/** Returns the type of AoE attack this character spawns */
+	TSubclassOf<ATwinStickAoEAttack> GetAoEAttackClass() const { return AoEAttackClass; }
+
 protected:
 
 	/** Updates the items counter on the Game Mode */
@@ -3,9 +3,28 @@
 
 #include "TwinStickGameMode.h"
 #include "TwinStickUI.h"
+#include "TwinStickHUD.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "GameFramework/Controller.h"
+#include "EngineUtils.h"
+#include "TwinStickNPC.h"
+#include "TwinStickNPCDestruction.h"
+#include "TwinStickProjectile.h"
+#include "TwinStickAoEAttack.h"
+#include "TwinStickPickup.h"
+#include "DreamEatingPerfMonitor.h"
+#include "DreamEating.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Twin Stick Live NPCs"), STAT_TwinStickLiveNPCs, STATGROUP_DreamEating);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Twin Stick Live Projectiles"), STAT_TwinStickLiveProjectiles, STATGROUP_DreamEating);
+
+ATwinStickGameMode::ATwinStickGameMode()
+{
+	// use the HUD that draws the debug overlays
+	HUDClass = ATwinStickHUD::StaticClass();
+}
 
 void ATwinStickGameMode::BeginPlay()
 {
@@ -24,49 +43,35 @@ void ATwinStickGameMode::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 void ATwinStickGameMode::ItemUsed(int32 Value)
 {
+	DREAMEATING_PERF_SCOPE(UI);
+
 	// update the UI
 	UIWidget->UpdateItems(Value);
 }
 
 void ATwinStickGameMode::ScoreUpdate(int32 Value)
 {
-	// multiply the base score by the combo multiplier and add it to the score
-	Score += Value * Combo;
+	// add the score multiplied by the combo
+	bool bMultiplierChanged = false;
+	const bool bCounted = Combo.AddHit(Value, ComboIncrementMax, ComboCap, bMultiplierChanged);
 
 	// update the UI
-	UIWidget->UpdateScore(Score);
+	{
+		DREAMEATING_PERF_SCOPE(UI);
 
-	// update the combo multiplier
-	ComboUpdate();
-}
+		UIWidget->UpdateScore(Combo.Score);
 
-void ATwinStickGameMode::ComboUpdate()
-{
-	// return
-	if (Combo > ComboCap)
-	{
-		return;
+		if (bMultiplierChanged)
+		{
+			UIWidget->UpdateCombo(Combo.Multiplier);
+		}
 	}
 
-	// update the combo increment
-	++ComboIncrement;
-
-	// is it time to increase the multiplier?
-	if (ComboIncrement > ComboIncrementMax)
+	// reset the cooldown timer if the hit counted toward the combo
+	if (bCounted)
 	{
-		// reset the combo increment
-		ComboIncrement = 0;
-
-		// increase the combo multiplier
-		++Combo;
-
-		// update the UI
-		UIWidget->UpdateCombo(Combo);
-
+		ResetComboCooldown();
 	}
-
-	// reset the cooldown timer
-	ResetComboCooldown();
 }
 
 void ATwinStickGameMode::ResetComboCooldown()
@@ -77,17 +82,11 @@ void ATwinStickGameMode::ResetComboCooldown()
 
 void ATwinStickGameMode::ResetCombo()
 {
-	// is the combo multiplier above min?
-	if (Combo > 1)
+	// tick down the multiplier
+	if (Combo.Decay())
 	{
-		// reset the combo increment
-		ComboIncrement = 0;
-
-		// tick down the multiplier
-		--Combo;
-
 		// update the UI
-		UIWidget->UpdateCombo(Combo);
+		UIWidget->UpdateCombo(Combo.Multiplier);
 
 		// reset the cooldown timer
 		ResetComboCooldown();
@@ -104,10 +103,71 @@ void ATwinStickGameMode::IncreaseNPCs()
 {
 	// increase the NPC counter
 	++NPCCount;
+
+	SET_DWORD_STAT(STAT_TwinStickLiveNPCs, NPCCount);
 }
 
 void ATwinStickGameMode::DecreaseNPCs()
 {
 	// decrease the NPC counter
 	--NPCCount;
+
+	SET_DWORD_STAT(STAT_TwinStickLiveNPCs, NPCCount);
+}
+
+void ATwinStickGameMode::IncreaseProjectiles()
+{
+	++ProjectileCount;
+
+	SET_DWORD_STAT(STAT_TwinStickLiveProjectiles, ProjectileCount);
+}
+
+void ATwinStickGameMode::DecreaseProjectiles()
+{
+	ProjectileCount = FMath::Max(ProjectileCount - 1, 0);
+
+	SET_DWORD_STAT(STAT_TwinStickLiveProjectiles, ProjectileCount);
+}
+
+void ATwinStickGameMode::SetComboSettings(int32 InComboIncrementMax, float InComboCooldown)
+{
+	ComboIncrementMax = FMath::Max(InComboIncrementMax, 0);
+
+	// timers with a zero rate are cleared instead of set, so keep the cooldown positive
+	ComboCooldown = FMath::Max(InComboCooldown, 0.01f);
+}
+
+void ATwinStickGameMode::ResetScore()
+{
+	// reset the score and multiplier
+	Combo = FDreamEatingCombo();
+
+	// stop any pending combo decay
+	GetWorld()->GetTimerManager().ClearTimer(ComboTimer);
+
+	// update the UI
+	UIWidget->UpdateScore(Combo.Score);
+	UIWidget->UpdateCombo(Combo.Multiplier);
+}
+
+void ATwinStickGameMode::ClearArena()
+{
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		AActor* Actor = *It;
+
+		if (Actor->IsA<ATwinStickNPC>())
+		{
+			if (AController* Controller = Cast<APawn>(Actor)->GetController())
+			{
+				Controller->Destroy();
+			}
+
+			Actor->Destroy();
+		}
+		else if (Actor->IsA<ATwinStickProjectile>() || Actor->IsA<ATwinStickAoEAttack>() || Actor->IsA<ATwinStickPickup>() || Actor->IsA<ATwinStickNPCDestruction>())
+		{
+			Actor->Destroy();
+		}
+	}
 }
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "DreamEatingCombo.h"
 #include "TwinStickGameMode.generated.h"
 
 class UTwinStickUI;
@@ -26,14 +27,8 @@ protected:
 	/** Pointer to the spawned UI Widget */
 	TObjectPtr<UTwinStickUI> UIWidget;
 
-	/** Current game score */
-	int32 Score = 0;
-
-	/** Current combo multiplier */
-	int32 Combo = 1;
-
-	/** Current combo increment value */
-	int32 ComboIncrement = 0;
+	/** Current score and combo multiplier */
+	FDreamEatingCombo Combo;
 
 	/** Number of combo hits to process before incrementing the combo multiplier */
 	UPROPERTY(EditAnywhere, Category="Twin Stick", meta=(ClampMin = 0, ClampMax = 10))
@@ -59,8 +54,14 @@ protected:
 	/** Current number of NPCs in the level */
 	int32 NPCCount = 0;
 
+	/** Current number of projectiles in the level */
+	int32 ProjectileCount = 0;
+
 public:
 
+	/** Constructor */
+	ATwinStickGameMode();
+
 	/** Gameplay initialization */
 	virtual void BeginPlay() override;
 
@@ -77,9 +78,6 @@ public:
 
 protected:
 
-	/** Updates the combo multiplier */
-	void ComboUpdate();
-
 	/** Resets the combo cooldown timer */
 	void ResetComboCooldown();
 
@@ -96,4 +94,45 @@ public:
 
 	/** Decreases the NPC count */
 	void DecreaseNPCs();
+
+	/** Returns the current number of NPCs in the level */
+	int32 GetNPCCount() const { return NPCCount; }
+
+	/** Returns the max number of NPCs allowed in the level */
+	int32 GetNPCCap() const { return NPCCap; }
+
+	/** Overrides the max number of NPCs allowed in the level. Used by benchmarks to force a population */
+	void SetNPCCap(int32 InNPCCap) { NPCCap = FMath::Max(InNPCCap, 0); }
+
+	/** Increases the projectile count */
+	void IncreaseProjectiles();
+
+	/** Decreases the projectile count */
+	void DecreaseProjectiles();
+
+	/** Returns the current number of projectiles in the level */
+	int32 GetProjectileCount() const { return ProjectileCount; }
+
+public:
+
+	/** Returns the current score */
+	int32 GetScore() const { return Combo.Score; }
+
+	/** Returns the current combo multiplier */
+	int32 GetComboMultiplier() const { return Combo.Multiplier; }
+
+	/** Returns the number of combo hits needed to increase the multiplier */
+	int32 GetComboIncrementMax() const { return ComboIncrementMax; }
+
+	/** Returns the max time between kills before the combo multiplier resets */
+	float GetComboCooldown() const { return ComboCooldown; }
+
+	/** Overrides the combo tuning. Used by balance sweeps */
+	void SetComboSettings(int32 InComboIncrementMax, float InComboCooldown);
+
+	/** Resets the score and combo multiplier. Used by balance sweeps between sessions */
+	void ResetScore();
+
+	/** Destroys every NPC, projectile, AoE attack and pickup so benchmarks and sweeps start from the same state */
+	void ClearArena();
 };
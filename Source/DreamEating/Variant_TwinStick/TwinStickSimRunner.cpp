@@ -0,0 +1,382 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "TwinStickSimRunner.h"
+#include "TwinStickCharacter.h"
+#include "TwinStickGameMode.h"
+#include "TwinStickSpawner.h"
+#include "TwinStickNPC.h"
+#include "TwinStickNPCDestruction.h"
+#include "DreamEatingBenchmarkReport.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "CoreGlobals.h"
+#include "DreamEating.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTwinStickSim(
+	TEXT("DreamEating.TwinStick.Sim"),
+	TEXT("Plays bot sessions with the current tuning and appends the results to a CSV in Saved/Sweeps. Usage: DreamEating.TwinStick.Sim [Sessions=1] [Seconds=120]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTwinStickSimRunner* Runner = World ? World->GetSubsystem<UTwinStickSimRunner>() : nullptr)
+		{
+			const int32 Sessions = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1;
+			const float Seconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 120.0f;
+
+			Runner->StartSessions(Runner->GetCurrentSettings(), Sessions, Seconds, FString());
+		}
+	}));
+
+/** Distance under which the bot backs away from an NPC */
+static constexpr float TwinStickSimKiteDistance = 800.0f;
+
+/** Distance under which NPCs count toward the bot's AoE decision */
+static constexpr float TwinStickSimCrowdDistance = 500.0f;
+
+/** Number of nearby NPCs that makes the bot drop an AoE attack */
+static constexpr int32 TwinStickSimCrowdSize = 3;
+
+const TCHAR* const FTwinStickSimSettings::Names[7] =
+{
+	TEXT("ComboIncrementMax"),
+	TEXT("ComboCooldown"),
+	TEXT("NPCCap"),
+	TEXT("SpawnGroupDelay"),
+	TEXT("SpawnGroupSize"),
+	TEXT("SpawnDelay"),
+	TEXT("PickupSpawnChance")
+};
+
+void FTwinStickSimSettings::ParseCommandLine(const TCHAR* CommandLine)
+{
+	FParse::Value(CommandLine, TEXT("ComboIncrementMax="), ComboIncrementMax);
+	FParse::Value(CommandLine, TEXT("ComboCooldown="), ComboCooldown);
+	FParse::Value(CommandLine, TEXT("NPCCap="), NPCCap);
+	FParse::Value(CommandLine, TEXT("SpawnGroupDelay="), SpawnGroupDelay);
+	FParse::Value(CommandLine, TEXT("SpawnGroupSize="), SpawnGroupSize);
+	FParse::Value(CommandLine, TEXT("SpawnDelay="), SpawnDelay);
+	FParse::Value(CommandLine, TEXT("PickupSpawnChance="), PickupSpawnChance);
+}
+
+FString FTwinStickSimSettings::ToCsv() const
+{
+	return FString::Printf(TEXT("%d,%g,%d,%g,%d,%g,%d"), ComboIncrementMax, ComboCooldown, NPCCap, SpawnGroupDelay, SpawnGroupSize, SpawnDelay, PickupSpawnChance);
+}
+
+bool UTwinStickSimRunner::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTwinStickSimRunner::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	bStartFromCommandLine = FParse::Param(FCommandLine::Get(), TEXT("TwinStickSim"));
+}
+
+void UTwinStickSimRunner::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void UTwinStickSimRunner::Tick(float DeltaTime)
+{
+	if (bStartFromCommandLine)
+	{
+		bStartFromCommandLine = false;
+
+		FTwinStickSimSettings CommandLineSettings = GetCurrentSettings();
+		CommandLineSettings.ParseCommandLine(FCommandLine::Get());
+
+		int32 Sessions = 1;
+		float Seconds = 120.0f;
+		FString Path;
+
+		FParse::Value(FCommandLine::Get(), TEXT("SimSessions="), Sessions);
+		FParse::Value(FCommandLine::Get(), TEXT("SimSeconds="), Seconds);
+		FParse::Value(FCommandLine::Get(), TEXT("SimCsv="), Path);
+		FParse::Value(FCommandLine::Get(), TEXT("SimPoint="), PointIndex);
+
+		StartSessions(CommandLineSettings, Sessions, Seconds, Path);
+	}
+
+	if (!bRunning)
+	{
+		return;
+	}
+
+	ATwinStickCharacter* PlayerCharacter = Player.Get();
+
+	// the player controller respawns the character as soon as it's destroyed
+	if (!PlayerCharacter)
+	{
+		// pick up the killing hit if the character hasn't been collected yet
+		if (const ATwinStickCharacter* DeadCharacter = Player.Get(true))
+		{
+			HitsTaken = DeadCharacter->GetHitsTaken() - StartHitsTaken;
+		}
+
+		FinishSession(true);
+		return;
+	}
+
+	HitsTaken = PlayerCharacter->GetHitsTaken() - StartHitsTaken;
+
+	SessionTime += DeltaTime;
+	GameThreadTimes.Add(static_cast<float>(FPlatformTime::ToMilliseconds(GGameThreadTime)));
+
+	if (const ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		MaxCombo = FMath::Max(MaxCombo, GameMode->GetComboMultiplier());
+	}
+
+	if (SessionTime >= SessionLength)
+	{
+		FinishSession(false);
+		return;
+	}
+
+	DriveBot(PlayerCharacter);
+}
+
+TStatId UTwinStickSimRunner::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTwinStickSimRunner, STATGROUP_Tickables);
+}
+
+void UTwinStickSimRunner::StartSessions(const FTwinStickSimSettings& InSettings, int32 InNumSessions, float InSessionLength, const FString& InCsvPath)
+{
+	if (bRunning)
+	{
+		UE_LOG(LogDreamEating, Warning, TEXT("Twin Stick sim: sessions are already running"));
+		return;
+	}
+
+	Settings = InSettings;
+	NumSessions = FMath::Max(InNumSessions, 1);
+	SessionLength = FMath::Max(InSessionLength, 1.0f);
+	SessionIndex = 0;
+	CsvPath = !InCsvPath.IsEmpty() ? InCsvPath : FPaths::ProjectSavedDir() / TEXT("Sweeps") / FString::Printf(TEXT("Sim-%s.csv"), *FDateTime::Now().ToString());
+
+	// write the header for new files
+	if (!IFileManager::Get().FileExists(*CsvPath))
+	{
+		const FString Header = TEXT("point,session,") + FString::Join(TArrayView<const TCHAR* const>(FTwinStickSimSettings::Names), TEXT(",")) +
+			TEXT(",score,max_combo,kills,hits_taken,died,survival_s,wall_s,realtime_factor,frames,avg_game_thread_ms,p95_game_thread_ms\n");
+
+		FFileHelper::SaveStringToFile(Header, *CsvPath);
+	}
+
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UTwinStickSimRunner::OnActorSpawned));
+
+	bRunning = true;
+
+	UE_LOG(LogDreamEating, Display, TEXT("Twin Stick sim: running %d sessions of %.0f s, writing to %s"), NumSessions, SessionLength, *FPaths::ConvertRelativePathToFull(CsvPath));
+
+	StartSession();
+}
+
+FTwinStickSimSettings UTwinStickSimRunner::GetCurrentSettings() const
+{
+	FTwinStickSimSettings CurrentSettings;
+
+	if (const ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		CurrentSettings.ComboIncrementMax = GameMode->GetComboIncrementMax();
+		CurrentSettings.ComboCooldown = GameMode->GetComboCooldown();
+		CurrentSettings.NPCCap = GameMode->GetNPCCap();
+	}
+
+	if (TActorIterator<ATwinStickSpawner> It(GetWorld()); It)
+	{
+		CurrentSettings.SpawnGroupDelay = It->GetSpawnGroupDelay();
+		CurrentSettings.SpawnGroupSize = It->GetSpawnGroupSize();
+		CurrentSettings.SpawnDelay = It->GetMinSpawnDelay();
+	}
+
+	if (TActorIterator<ATwinStickNPC> It(GetWorld()); It)
+	{
+		CurrentSettings.PickupSpawnChance = It->GetPickupSpawnChance();
+	}
+
+	return CurrentSettings;
+}
+
+void UTwinStickSimRunner::StartSession()
+{
+	SessionTime = 0.0f;
+	SessionWallStart = FPlatformTime::Seconds();
+	MaxCombo = 1;
+	Kills = 0;
+	GameThreadTimes.Reset();
+
+	// start from an empty arena with a fresh score and the session's tuning
+	if (ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GameMode->ClearArena();
+		GameMode->ResetScore();
+		GameMode->SetComboSettings(Settings.ComboIncrementMax, Settings.ComboCooldown);
+		GameMode->SetNPCCap(Settings.NPCCap);
+	}
+
+	for (TActorIterator<ATwinStickSpawner> It(GetWorld()); It; ++It)
+	{
+		It->SetSpawnSettings(Settings.SpawnGroupDelay, Settings.SpawnGroupSize, Settings.SpawnDelay, Settings.SpawnDelay);
+	}
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	Player = PlayerController ? Cast<ATwinStickCharacter>(PlayerController->GetPawn()) : nullptr;
+
+	StartHitsTaken = Player.IsValid() ? Player->GetHitsTaken() : 0;
+	HitsTaken = 0;
+
+	if (!Player.IsValid())
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Twin Stick sim: no Twin Stick player character to drive"));
+
+		bRunning = false;
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+}
+
+void UTwinStickSimRunner::FinishSession(bool bDied)
+{
+	const double WallTime = FPlatformTime::Seconds() - SessionWallStart;
+
+	int32 Score = 0;
+
+	if (const ATwinStickGameMode* GameMode = Cast<ATwinStickGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		Score = GameMode->GetScore();
+	}
+
+	float AverageGameThread = 0.0f;
+
+	for (float Sample : GameThreadTimes)
+	{
+		AverageGameThread += Sample;
+	}
+
+	AverageGameThread /= FMath::Max(GameThreadTimes.Num(), 1);
+
+	const FString Row = FString::Printf(TEXT("%d,%d,%s,%d,%d,%d,%d,%d,%.3f,%.3f,%.2f,%d,%.3f,%.3f\n"),
+		PointIndex,
+		SessionIndex,
+		*Settings.ToCsv(),
+		Score,
+		MaxCombo,
+		Kills,
+		HitsTaken,
+		bDied ? 1 : 0,
+		SessionTime,
+		WallTime,
+		WallTime > 0.0 ? SessionTime / WallTime : 0.0,
+		GameThreadTimes.Num(),
+		AverageGameThread,
+		FDreamEatingBenchmarkReport::Percentile(GameThreadTimes, 0.95f));
+
+	FFileHelper::SaveStringToFile(Row, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	UE_LOG(LogDreamEating, Display, TEXT("Twin Stick sim: session %d/%d, score %d, %s after %.1f s, %.1fx real time"),
+		SessionIndex + 1, NumSessions, Score, bDied ? TEXT("died") : TEXT("survived"), SessionTime, WallTime > 0.0 ? SessionTime / WallTime : 0.0);
+
+	if (++SessionIndex < NumSessions)
+	{
+		StartSession();
+		return;
+	}
+
+	bRunning = false;
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	// processes launched by the sweep quit once their sessions are done
+	if (FParse::Param(FCommandLine::Get(), TEXT("TwinStickSim")))
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UTwinStickSimRunner::DriveBot(ATwinStickCharacter* PlayerCharacter)
+{
+	const FVector PlayerLocation = PlayerCharacter->GetActorLocation();
+
+	// find the closest live NPC and count the ones crowding the player
+	const ATwinStickNPC* Closest = nullptr;
+	double ClosestDistance = TNumericLimits<double>::Max();
+	int32 Crowd = 0;
+
+	for (TActorIterator<ATwinStickNPC> It(GetWorld()); It; ++It)
+	{
+		if (It->bHit)
+		{
+			continue;
+		}
+
+		const double Distance = FVector::DistSquared2D(PlayerLocation, It->GetActorLocation());
+
+		if (Distance < FMath::Square(TwinStickSimCrowdDistance))
+		{
+			++Crowd;
+		}
+
+		if (Distance < ClosestDistance)
+		{
+			Closest = *It;
+			ClosestDistance = Distance;
+		}
+	}
+
+	if (!Closest)
+	{
+		PlayerCharacter->DoMove(0.0f, 0.0f);
+		return;
+	}
+
+	// aim at the closest NPC, which also fires on autofire
+	const FVector ToClosest = (Closest->GetActorLocation() - PlayerLocation).GetSafeNormal2D();
+	PlayerCharacter->DoAim(ToClosest.X, ToClosest.Y);
+
+	// strafe around it, and back away when it gets close
+	FVector Move(-ToClosest.Y, ToClosest.X, 0.0f);
+
+	if (ClosestDistance < FMath::Square(TwinStickSimKiteDistance))
+	{
+		Move -= ToClosest * 1.5f;
+	}
+
+	Move = Move.GetSafeNormal2D();
+	PlayerCharacter->DoMove(Move.X, Move.Y);
+
+	// clear the crowd when surrounded. Items and cooldown are checked by the character
+	if (Crowd >= TwinStickSimCrowdSize)
+	{
+		PlayerCharacter->DoAoEAttack();
+	}
+}
+
+void UTwinStickSimRunner::OnActorSpawned(AActor* Actor)
+{
+	if (ATwinStickNPC* NPC = Cast<ATwinStickNPC>(Actor))
+	{
+		NPC->SetPickupSpawnChance(Settings.PickupSpawnChance);
+	}
+	else if (Actor->IsA<ATwinStickNPCDestruction>())
+	{
+		// every destroyed NPC leaves a destruction proxy behind
+		++Kills;
+	}
+}
@@ -0,0 +1,154 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TwinStickSimRunner.generated.h"
+
+class ATwinStickCharacter;
+
+/**
+ *  Tuning values applied to a balance sweep session
+ */
+struct FTwinStickSimSettings
+{
+	/** Number of combo hits needed to increase the multiplier */
+	int32 ComboIncrementMax = 5;
+
+	/** Max time between kills before the combo multiplier resets */
+	float ComboCooldown = 3.0f;
+
+	/** Max number of NPCs allowed in the level */
+	int32 NPCCap = 20;
+
+	/** Time delay between enemy group spawns */
+	float SpawnGroupDelay = 5.0f;
+
+	/** Number of NPCs to spawn per group */
+	int32 SpawnGroupSize = 3;
+
+	/** Time delay between individual NPC spawns */
+	float SpawnDelay = 0.33f;
+
+	/** Percentage chance of an NPC dropping a pickup */
+	int32 PickupSpawnChance = 10;
+
+	/** Names of the settings, as used on the command line and in the CSV header */
+	static const TCHAR* const Names[7];
+
+	/** Overrides the settings with any values passed on the command line as -Name=Value */
+	void ParseCommandLine(const TCHAR* CommandLine);
+
+	/** Returns the settings as comma separated values, in the order of Names */
+	FString ToCsv() const;
+};
+
+/**
+ *  Headless balance sweep runner for the Twin Stick Shooter variant.
+ *  Plays a number of fixed length sessions back to back with a simple bot: it aims and autofires at the closest NPC,
+ *  kites away from it and drops AoE attacks when crowded. A session ends when the player dies or time runs out.
+ *  Each session appends its score, survival and performance metrics to a CSV file.
+ *  Meant to be launched by the TwinStickSweep commandlet with -game -nullrhi -benchmark -fps=N, so the game runs
+ *  uncapped at a fixed step instead of real time. Can also be started from the console with DreamEating.TwinStick.Sim.
+ */
+UCLASS()
+class UTwinStickSimRunner : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** If true, sessions are running */
+	bool bRunning = false;
+
+	/** If true, sessions were requested on the command line and start on the first tick, once the arena has begun play */
+	bool bStartFromCommandLine = false;
+
+	/** Tuning applied to every session */
+	FTwinStickSimSettings Settings;
+
+	/** Number of sessions to run */
+	int32 NumSessions = 1;
+
+	/** Longest session, in simulated seconds */
+	float SessionLength = 120.0f;
+
+	/** Index of the current session */
+	int32 SessionIndex = 0;
+
+	/** Grid point this process runs, copied to the CSV */
+	int32 PointIndex = 0;
+
+	/** CSV file the sessions are appended to */
+	FString CsvPath;
+
+	/** Player character the bot drives in the current session */
+	TWeakObjectPtr<ATwinStickCharacter> Player;
+
+	/** Simulated time elapsed in the current session */
+	float SessionTime = 0.0f;
+
+	/** Wall clock time the current session started at */
+	double SessionWallStart = 0.0;
+
+	/** Highest combo multiplier reached in the current session */
+	int32 MaxCombo = 1;
+
+	/** NPCs destroyed in the current session */
+	int32 Kills = 0;
+
+	/** Player hit count when the current session started. The character keeps counting across sessions it survives */
+	int32 StartHitsTaken = 0;
+
+	/** Hits the player took in the current session, updated every frame while the player is alive */
+	int32 HitsTaken = 0;
+
+	/** Game thread time samples of the current session, in milliseconds */
+	TArray<float> GameThreadTimes;
+
+	/** World actor spawn listener */
+	FDelegateHandle ActorSpawnedHandle;
+
+public:
+
+	/** Only create this subsystem for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Starts the sessions if requested on the command line */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Cleanup */
+	virtual void Deinitialize() override;
+
+	/** Drives the bot and tracks the current session */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Runs the given number of sessions with the given tuning, appending the results to a CSV file */
+	void StartSessions(const FTwinStickSimSettings& InSettings, int32 InNumSessions, float InSessionLength, const FString& InCsvPath);
+
+	/** Returns true while sessions are running */
+	bool IsRunning() const { return bRunning; }
+
+	/** Returns the tuning currently set on the game mode and the first spawner */
+	FTwinStickSimSettings GetCurrentSettings() const;
+
+protected:
+
+	/** Resets the arena and score, and applies the tuning for a new session */
+	void StartSession();
+
+	/** Appends the results of the current session and moves on to the next one */
+	void FinishSession(bool bDied);
+
+	/** Applies the bot's input for this frame */
+	void DriveBot(ATwinStickCharacter* PlayerCharacter);
+
+	/** Applies the drop chance to new NPCs and counts kills */
+	void OnActorSpawned(AActor* Actor);
+};
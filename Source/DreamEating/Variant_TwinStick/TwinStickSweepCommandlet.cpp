@@ -0,0 +1,268 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "TwinStickSweepCommandlet.h"
+#include "TwinStickSimRunner.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "DreamEating.h"
+
+/** Child process running a single grid point */
+struct FTwinStickSweepProcess
+{
+	/** Process handle */
+	FProcHandle Handle;
+
+	/** Grid point the process runs */
+	int32 PointIndex = INDEX_NONE;
+};
+
+UTwinStickSweepCommandlet::UTwinStickSweepCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UTwinStickSweepCommandlet::Main(const FString& Params)
+{
+	FString Map;
+	FString GridDesc;
+	int32 SessionsPerPoint = 10;
+	float SessionSeconds = 120.0f;
+	int32 MaxProcesses = FPlatformMisc::NumberOfCores();
+	int32 StepRate = 30;
+	FString Output = FPaths::ProjectSavedDir() / TEXT("Sweeps") / FString::Printf(TEXT("TwinStickSweep-%s.csv"), *FDateTime::Now().ToString());
+
+	FParse::Value(*Params, TEXT("Map="), Map);
+	FParse::Value(*Params, TEXT("Grid="), GridDesc, false);
+	FParse::Value(*Params, TEXT("SessionsPerPoint="), SessionsPerPoint);
+	FParse::Value(*Params, TEXT("SessionSeconds="), SessionSeconds);
+	FParse::Value(*Params, TEXT("Processes="), MaxProcesses);
+	FParse::Value(*Params, TEXT("StepRate="), StepRate);
+	FParse::Value(*Params, TEXT("Output="), Output);
+
+	if (Map.IsEmpty())
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("No map to sweep. Usage: -run=TwinStickSweep -Map=/Game/Variant_TwinStick/LVL_TwinStick -Grid=\"ComboIncrementMax=3,5,8;NPCCap=20,50\" [-SessionsPerPoint=10] [-SessionSeconds=120] [-Processes=N] [-StepRate=30] [-Output=Path]"));
+		return 1;
+	}
+
+	// parse the grid into a list of values per setting
+	TArray<TPair<FString, TArray<FString>>> Axes;
+
+	TArray<FString> AxisDescs;
+	GridDesc.TrimQuotes().ParseIntoArray(AxisDescs, TEXT(";"));
+
+	for (const FString& AxisDesc : AxisDescs)
+	{
+		FString Name;
+		FString Values;
+
+		if (!AxisDesc.Split(TEXT("="), &Name, &Values))
+		{
+			UE_LOG(LogDreamEating, Error, TEXT("Invalid grid axis '%s', expected Name=Value1,Value2"), *AxisDesc);
+			return 1;
+		}
+
+		Name.TrimStartAndEndInline();
+
+		bool bKnownSetting = false;
+
+		for (const TCHAR* SettingName : FTwinStickSimSettings::Names)
+		{
+			bKnownSetting |= Name.Equals(SettingName, ESearchCase::IgnoreCase);
+		}
+
+		if (!bKnownSetting)
+		{
+			UE_LOG(LogDreamEating, Error, TEXT("Unknown grid setting '%s', expected one of %s"), *Name,
+				*FString::Join(TArrayView<const TCHAR* const>(FTwinStickSimSettings::Names), TEXT(", ")));
+			return 1;
+		}
+
+		TPair<FString, TArray<FString>>& Axis = Axes.Emplace_GetRef(Name, TArray<FString>());
+		Values.ParseIntoArray(Axis.Value, TEXT(","));
+
+		if (Axis.Value.Num() == 0)
+		{
+			UE_LOG(LogDreamEating, Error, TEXT("Grid setting '%s' has no values"), *Name);
+			return 1;
+		}
+	}
+
+	// build the overrides for every point of the cartesian product. An empty grid runs the map's own tuning once
+	TArray<FString> Points = { FString() };
+
+	for (const TPair<FString, TArray<FString>>& Axis : Axes)
+	{
+		TArray<FString> Expanded;
+		Expanded.Reserve(Points.Num() * Axis.Value.Num());
+
+		for (const FString& Point : Points)
+		{
+			for (const FString& Value : Axis.Value)
+			{
+				Expanded.Add(Point + FString::Printf(TEXT(" -%s=%s"), *Axis.Key, *Value.TrimStartAndEnd()));
+			}
+		}
+
+		Points = MoveTemp(Expanded);
+	}
+
+	const FString PointDir = FPaths::ConvertRelativePathToFull(FPaths::GetPath(Output) / FPaths::GetBaseFilename(Output));
+	IFileManager::Get().MakeDirectory(*PointDir, true);
+
+	UE_LOG(LogDreamEating, Display, TEXT("Twin Stick sweep: %d points x %d sessions of %.0f s, %d processes at a time"), Points.Num(), SessionsPerPoint, SessionSeconds, MaxProcesses);
+
+	// run every point in its own headless game process. -benchmark with -fps steps the game by a fixed time as fast as it can
+	const FString Executable = FPlatformProcess::ExecutablePath();
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+
+	TArray<FTwinStickSweepProcess> Running;
+	int32 NextPoint = 0;
+	int32 NumFailed = 0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	while (NextPoint < Points.Num() || Running.Num() > 0)
+	{
+		// reap finished processes
+		for (int32 Index = Running.Num() - 1; Index >= 0; --Index)
+		{
+			FTwinStickSweepProcess& Process = Running[Index];
+
+			if (FPlatformProcess::IsProcRunning(Process.Handle))
+			{
+				continue;
+			}
+
+			int32 ReturnCode = 0;
+			FPlatformProcess::GetProcReturnCode(Process.Handle, &ReturnCode);
+			FPlatformProcess::CloseProc(Process.Handle);
+
+			if (ReturnCode != 0)
+			{
+				UE_LOG(LogDreamEating, Error, TEXT("Twin Stick sweep: point %d exited with code %d"), Process.PointIndex, ReturnCode);
+				++NumFailed;
+			}
+			else
+			{
+				UE_LOG(LogDreamEating, Display, TEXT("Twin Stick sweep: point %d done"), Process.PointIndex);
+			}
+
+			Running.RemoveAtSwap(Index);
+		}
+
+		// launch new ones while there are free slots
+		while (NextPoint < Points.Num() && Running.Num() < FMath::Max(MaxProcesses, 1))
+		{
+			const FString PointCsv = PointDir / FString::Printf(TEXT("point_%d.csv"), NextPoint);
+			IFileManager::Get().Delete(*PointCsv, false, true, true);
+
+			// the deterministic seed differs per point, so every point doesn't replay the same spawns
+			const FString Args = FString::Printf(TEXT("\"%s\" %s -game -nullrhi -nosound -unattended -nosplash -benchmark -fps=%d -ini:Engine:[ConsoleVariables]:DreamEating.Determinism.StepRate=%d -TwinStickSim -SimSessions=%d -SimSeconds=%g -SimCsv=\"%s\" -SimPoint=%d -Deterministic -DeterministicSeed=%d%s"),
+				*ProjectFile, *Map, StepRate, StepRate, SessionsPerPoint, SessionSeconds, *PointCsv, NextPoint, 1337 + NextPoint, *Points[NextPoint]);
+
+			FTwinStickSweepProcess& Process = Running.AddDefaulted_GetRef();
+			Process.Handle = FPlatformProcess::CreateProc(*Executable, *Args, true, true, true, nullptr, 0, nullptr, nullptr);
+			Process.PointIndex = NextPoint;
+
+			if (!Process.Handle.IsValid())
+			{
+				UE_LOG(LogDreamEating, Error, TEXT("Twin Stick sweep: couldn't launch point %d"), NextPoint);
+				Running.Pop();
+				++NumFailed;
+			}
+
+			++NextPoint;
+		}
+
+		FPlatformProcess::Sleep(0.1f);
+	}
+
+	// merge the point CSVs, keeping a single header, and summarize each point
+	TArray<FString> Merged;
+	TArray<FString> Summary = { TEXT("point,") + FString::Join(TArrayView<const TCHAR* const>(FTwinStickSimSettings::Names), TEXT(",")) +
+		TEXT(",sessions,mean_score,mean_max_combo,mean_kills,mean_survival_s,death_rate,mean_realtime_factor,mean_p95_game_thread_ms") };
+
+	for (int32 PointIndex = 0; PointIndex < Points.Num(); ++PointIndex)
+	{
+		TArray<FString> Lines;
+
+		if (!FFileHelper::LoadFileToStringArray(Lines, *(PointDir / FString::Printf(TEXT("point_%d.csv"), PointIndex))) || Lines.Num() < 2)
+		{
+			UE_LOG(LogDreamEating, Warning, TEXT("Twin Stick sweep: no results for point %d"), PointIndex);
+			continue;
+		}
+
+		if (Merged.Num() == 0)
+		{
+			Merged.Add(Lines[0]);
+		}
+
+		// columns follow the UTwinStickSimRunner CSV layout
+		constexpr int32 NumSettings = UE_ARRAY_COUNT(FTwinStickSimSettings::Names);
+		constexpr int32 ResultsStart = 2 + NumSettings;
+
+		TArray<FString> Settings;
+		double Sums[7] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		int32 NumSessions = 0;
+
+		for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			TArray<FString> Columns;
+			Lines[LineIndex].ParseIntoArray(Columns, TEXT(","), false);
+
+			if (Columns.Num() < ResultsStart + 11)
+			{
+				continue;
+			}
+
+			Merged.Add(Lines[LineIndex]);
+
+			if (Settings.Num() == 0)
+			{
+				Settings.Append(&Columns[2], NumSettings);
+			}
+
+			// score, max_combo, kills, survival_s, died, realtime_factor, p95_game_thread_ms
+			Sums[0] += FCString::Atod(*Columns[ResultsStart]);
+			Sums[1] += FCString::Atod(*Columns[ResultsStart + 1]);
+			Sums[2] += FCString::Atod(*Columns[ResultsStart + 2]);
+			Sums[3] += FCString::Atod(*Columns[ResultsStart + 5]);
+			Sums[4] += FCString::Atod(*Columns[ResultsStart + 4]);
+			Sums[5] += FCString::Atod(*Columns[ResultsStart + 7]);
+			Sums[6] += FCString::Atod(*Columns[ResultsStart + 10]);
+			++NumSessions;
+		}
+
+		if (NumSessions == 0)
+		{
+			continue;
+		}
+
+		Summary.Add(FString::Printf(TEXT("%d,%s,%d,%.1f,%.2f,%.1f,%.1f,%.3f,%.2f,%.3f"),
+			PointIndex, *FString::Join(Settings, TEXT(",")), NumSessions,
+			Sums[0] / NumSessions, Sums[1] / NumSessions, Sums[2] / NumSessions, Sums[3] / NumSessions,
+			Sums[4] / NumSessions, Sums[5] / NumSessions, Sums[6] / NumSessions));
+	}
+
+	const FString SummaryPath = FPaths::GetPath(Output) / FPaths::GetBaseFilename(Output) + TEXT("_summary.csv");
+
+	if (!FFileHelper::SaveStringArrayToFile(Merged, *Output) || !FFileHelper::SaveStringArrayToFile(Summary, *SummaryPath))
+	{
+		UE_LOG(LogDreamEating, Error, TEXT("Twin Stick sweep: couldn't write %s"), *Output);
+		return 1;
+	}
+
+	UE_LOG(LogDreamEating, Display, TEXT("Twin Stick sweep: %d points in %.1f s, %d failed. Results in %s, summary in %s"),
+		Points.Num(), FPlatformTime::Seconds() - StartTime, NumFailed, *FPaths::ConvertRelativePathToFull(Output), *FPaths::ConvertRelativePathToFull(SummaryPath));
+
+	return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TwinStickSweepCommandlet.generated.h"
+
+/**
+ *  Runs a Twin Stick balance sweep over a grid of tuning values.
+ *  Every grid point is played by its own headless game process running the UTwinStickSimRunner bot at a fixed,
+ *  uncapped step, with up to one process per core at a time. The per-session CSVs are merged once all points are done,
+ *  along with a summary of the mean results per point.
+ *  UnrealEditor-Cmd DreamEating -run=TwinStickSweep -Map=/Game/Variant_TwinStick/LVL_TwinStick
+ *  -Grid="ComboIncrementMax=3,5,8;NPCCap=20,50" [-SessionsPerPoint=10] [-SessionSeconds=120] [-Processes=N] [-StepRate=30] [-Output=Path]
+ */
+UCLASS()
+class UTwinStickSweepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Constructor */
+	UTwinStickSweepCommandlet();
+
+	/** Runs the sweep described on the command line */
+	virtual int32 Main(const FString& Params) override;
+};
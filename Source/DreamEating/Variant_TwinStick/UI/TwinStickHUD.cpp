@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "TwinStickHUD.h"
+#include "TwinStickGameMode.h"
+#include "Engine/World.h"
+#include "DreamEatingPerfMonitor.h"
+
+void ATwinStickHUD::DrawHUD()
+{
+	{
+		DREAMEATING_PERF_SCOPE(UI);
+
+		// draw all debug information, etc.
+		Super::DrawHUD();
+	}
+
+	// draw the performance overlay if enabled
+	if (UDreamEatingPerfMonitor::IsOverlayEnabled())
+	{
+		if (UDreamEatingPerfMonitor* PerfMonitor = GetWorld()->GetSubsystem<UDreamEatingPerfMonitor>())
+		{
+			const ATwinStickGameMode* GameMode = GetWorld()->GetAuthGameMode<ATwinStickGameMode>();
+
+			const FDreamEatingPerfEntityCount EntityCounts[] =
+			{
+				{ TEXT("NPCs"), GameMode ? GameMode->GetNPCCount() : 0 },
+				{ TEXT("Projectiles"), GameMode ? GameMode->GetProjectileCount() : 0 }
+			};
+
+			PerfMonitor->DrawOverlay(Canvas, EntityCounts);
+		}
+	}
+}
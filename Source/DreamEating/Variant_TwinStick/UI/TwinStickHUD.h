@@ -0,0 +1,22 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/HUD.h"
+#include "TwinStickHUD.generated.h"
+
+/**
+ *  Simple Twin Stick Shooter HUD
+ *  The score and combo UI is a widget owned by the game mode, so this only draws the debug overlays.
+ */
+UCLASS()
+class ATwinStickHUD : public AHUD
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Draws the HUD */
+	virtual void DrawHUD() override;
+};
@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "RequiredProgramMainCPPInclude.h"
+#include "DreamEatingMicrobenchmark.h"
+#include "DreamEatingBenchCases.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+IMPLEMENT_APPLICATION(DreamEatingBench, "DreamEatingBench");
+
+/**
+ *  Runs the gameplay logic microbenchmarks without booting the engine.
+ *  Usage: DreamEatingBench [-Samples=200] [-Filter=Name] [-Json=Path]
+ */
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	FTaskTagScope Scope(ETaskTag::EGameThread);
+
+	ON_SCOPE_EXIT
+	{
+		RequestEngineExit(TEXT("Exiting"));
+		FEngineLoop::AppPreExit();
+		FModuleManager::Get().UnloadModulesAtShutdown();
+		FEngineLoop::AppExit();
+	};
+
+	if (const int32 Result = GEngineLoop.PreInit(ArgC, ArgV))
+	{
+		return Result;
+	}
+
+	int32 NumSamples = 200;
+	FParse::Value(FCommandLine::Get(), TEXT("Samples="), NumSamples);
+
+	FString Filter;
+	FParse::Value(FCommandLine::Get(), TEXT("Filter="), Filter);
+
+	FDreamEatingMicrobenchmark Benchmark(NumSamples, Filter);
+	DreamEatingBenchCases::RunAll(Benchmark);
+	Benchmark.LogResults();
+
+	FString JsonPath;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("Json="), JsonPath))
+	{
+		if (!Benchmark.WriteJson(JsonPath))
+		{
+			UE_LOG(LogDreamEatingBench, Error, TEXT("Could not write results to %s"), *JsonPath);
+			return 1;
+		}
+
+		UE_LOG(LogDreamEatingBench, Display, TEXT("Results written to %s"), *FPaths::ConvertRelativePathToFull(JsonPath));
+	}
+
+	return 0;
+}
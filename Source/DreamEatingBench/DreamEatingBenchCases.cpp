@@ -0,0 +1,198 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingBenchCases.h"
+#include "DreamEatingMicrobenchmark.h"
+#include "DreamEatingCombo.h"
+#include "DreamEatingFormation.h"
+#include "DreamEatingSelection.h"
+#include "DreamEatingSpatialGrid.h"
+#include "Math/RandomStream.h"
+
+namespace DreamEatingBenchCases
+{
+	/** Army sizes matching the Strategy army benchmark */
+	static constexpr int32 ArmySizes[] = { 50, 500, 2000 };
+
+	/** Returns a seeded set of unit locations spread at roughly the Strategy unit density */
+	static TArray<FVector> MakeUnitLocations(int32 NumUnits)
+	{
+		FRandomStream RandomStream(1337);
+		const float Radius = FMath::Sqrt(static_cast<float>(NumUnits)) * 150.0f;
+
+		TArray<FVector> Locations;
+		Locations.Reserve(NumUnits);
+
+		for (int32 Index = 0; Index < NumUnits; ++Index)
+		{
+			Locations.Add(FDreamEatingFormation::SampleDisc(RandomStream, FVector::ZeroVector, Radius));
+		}
+
+		return Locations;
+	}
+
+	/** Closest selected unit to a move goal */
+	static void RunSelection(FDreamEatingMicrobenchmark& Benchmark)
+	{
+		for (const int32 NumUnits : ArmySizes)
+		{
+			const TArray<FVector> Locations = MakeUnitLocations(NumUnits);
+
+			Benchmark.Run(*FString::Printf(TEXT("Selection.FindClosest2D.%d"), NumUnits), 1, [&Locations]()
+			{
+				const int32 Closest = FDreamEatingSelection::FindClosest2D(TConstArrayView<FVector>(Locations), FVector(123.0f, 456.0f, 0.0f), [](const FVector& Location, FVector& OutLocation)
+				{
+					OutLocation = Location;
+					return true;
+				});
+
+				FDreamEatingMicrobenchmark::DoNotOptimize(Closest);
+			});
+
+			// select all against a selection set, and against the plain array it replaced
+			TArray<int32> Elements;
+
+			for (int32 Index = 0; Index < NumUnits; ++Index)
+			{
+				Elements.Add(Index);
+			}
+
+			TDreamEatingSelectionSet<int32> SelectionSet;
+
+			Benchmark.Run(*FString::Printf(TEXT("Selection.SelectAllSet.%d"), NumUnits), 1, [&Elements, &SelectionSet]()
+			{
+				SelectionSet.Reset();
+
+				for (const int32 Element : Elements)
+				{
+					SelectionSet.Add(Element);
+				}
+
+				FDreamEatingMicrobenchmark::DoNotOptimize(SelectionSet.Num());
+			});
+
+			TArray<int32> SelectionArray;
+
+			Benchmark.Run(*FString::Printf(TEXT("Selection.SelectAllArray.%d"), NumUnits), 1, [&Elements, &SelectionArray]()
+			{
+				SelectionArray.Reset();
+
+				for (const int32 Element : Elements)
+				{
+					SelectionArray.AddUnique(Element);
+				}
+
+				FDreamEatingMicrobenchmark::DoNotOptimize(SelectionArray.Num());
+			});
+		}
+	}
+
+	/** Score and combo updates from a stream of kills */
+	static void RunCombo(FDreamEatingMicrobenchmark& Benchmark)
+	{
+		constexpr int32 NumHits = 1000;
+
+		Benchmark.Run(TEXT("Combo.AddHitAndDecay"), NumHits, []()
+		{
+			FDreamEatingCombo Combo;
+			bool bMultiplierChanged = false;
+
+			for (int32 Hit = 0; Hit < NumHits; ++Hit)
+			{
+				Combo.AddHit(1, 5, 4, bMultiplierChanged);
+
+				// let the cooldown expire every so often
+				if (Hit % 50 == 49)
+				{
+					Combo.Decay();
+				}
+			}
+
+			FDreamEatingMicrobenchmark::DoNotOptimize(Combo.Score);
+		});
+	}
+
+	/** Grid rebuilds and proximity queries at the Strategy unit registry's cell size */
+	static void RunSpatialGrid(FDreamEatingMicrobenchmark& Benchmark)
+	{
+		for (const int32 NumUnits : ArmySizes)
+		{
+			const TArray<FVector> Locations = MakeUnitLocations(NumUnits);
+			FDreamEatingSpatialGrid Grid;
+
+			Benchmark.Run(*FString::Printf(TEXT("SpatialGrid.Rebuild.%d"), NumUnits), NumUnits, [&Locations, &Grid]()
+			{
+				Grid.Reset(500.0f);
+
+				for (int32 Index = 0; Index < Locations.Num(); ++Index)
+				{
+					Grid.Add(Index, Locations[Index]);
+				}
+
+				FDreamEatingMicrobenchmark::DoNotOptimize(Grid.Num());
+			});
+
+			// query around every unit, as the awareness checks do
+			TArray<int32> Found;
+
+			Benchmark.Run(*FString::Printf(TEXT("SpatialGrid.QueryRadius.%d"), NumUnits), NumUnits, [&Locations, &Grid, &Found]()
+			{
+				for (const FVector& Location : Locations)
+				{
+					Found.Reset();
+					Grid.QueryRadius(Location, 600.0f, Found);
+				}
+
+				FDreamEatingMicrobenchmark::DoNotOptimize(Found.Num());
+			});
+		}
+	}
+
+	/** Formation slots and spawn point sampling */
+	static void RunFormation(FDreamEatingMicrobenchmark& Benchmark)
+	{
+		for (const int32 NumUnits : ArmySizes)
+		{
+			TArray<FVector> Slots;
+
+			Benchmark.Run(*FString::Printf(TEXT("Formation.MakeGrid.%d"), NumUnits), NumUnits, [NumUnits, &Slots]()
+			{
+				Slots.Reset();
+				FDreamEatingFormation::MakeGrid(FVector::ZeroVector, NumUnits, 150.0f, Slots);
+
+				FDreamEatingMicrobenchmark::DoNotOptimize(Slots.Num());
+			});
+
+			Benchmark.Run(*FString::Printf(TEXT("Formation.MakeRings.%d"), NumUnits), NumUnits, [NumUnits, &Slots]()
+			{
+				Slots.Reset();
+				FDreamEatingFormation::MakeRings(FVector::ZeroVector, NumUnits, 2000.0f, 150.0f, Slots);
+
+				FDreamEatingMicrobenchmark::DoNotOptimize(Slots.Num());
+			});
+		}
+
+		constexpr int32 NumSamples = 1000;
+		FRandomStream RandomStream(1337);
+
+		Benchmark.Run(TEXT("Formation.SampleDisc"), NumSamples, [&RandomStream]()
+		{
+			FVector Sum = FVector::ZeroVector;
+
+			for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+			{
+				Sum += FDreamEatingFormation::SampleDisc(RandomStream, FVector::ZeroVector, 1000.0f);
+			}
+
+			FDreamEatingMicrobenchmark::DoNotOptimize(Sum);
+		});
+	}
+
+	void RunAll(FDreamEatingMicrobenchmark& Benchmark)
+	{
+		RunSelection(Benchmark);
+		RunCombo(Benchmark);
+		RunSpatialGrid(Benchmark);
+		RunFormation(Benchmark);
+	}
+}
@@ -0,0 +1,14 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FDreamEatingMicrobenchmark;
+
+/** Microbenchmarks for the logic in DreamEatingCore */
+namespace DreamEatingBenchCases
+{
+	/** Runs every benchmark case */
+	void RunAll(FDreamEatingMicrobenchmark& Benchmark);
+}
@@ -0,0 +1,87 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingMicrobenchmark.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+
+DEFINE_LOG_CATEGORY(LogDreamEatingBench);
+
+volatile uint64 FDreamEatingMicrobenchmark::Sink = 0;
+
+/** Minimum time spent warming up each benchmark, in seconds */
+static constexpr double MicrobenchmarkWarmUpTime = 0.05;
+
+FDreamEatingMicrobenchmark::FDreamEatingMicrobenchmark(int32 InNumSamples, const FString& InFilter)
+	: NumSamples(FMath::Max(InNumSamples, 1))
+	, Filter(InFilter)
+{
+}
+
+void FDreamEatingMicrobenchmark::Run(const TCHAR* Name, int32 OpsPerCall, TFunctionRef<void()> Body)
+{
+	if (!Filter.IsEmpty() && !FCString::Stristr(Name, *Filter))
+	{
+		return;
+	}
+
+	OpsPerCall = FMath::Max(OpsPerCall, 1);
+
+	// warm up caches and allocations before timing anything
+	const double WarmUpStart = FPlatformTime::Seconds();
+
+	for (int32 Call = 0; Call < 3 || FPlatformTime::Seconds() - WarmUpStart < MicrobenchmarkWarmUpTime; ++Call)
+	{
+		Body();
+	}
+
+	// time each call separately so the percentiles show the spread
+	TArray<double> Samples;
+	Samples.Reserve(NumSamples);
+
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Body();
+		const uint64 EndCycles = FPlatformTime::Cycles64();
+
+		Samples.Add(FPlatformTime::ToSeconds64(EndCycles - StartCycles) * 1.0e9 / OpsPerCall);
+	}
+
+	Samples.Sort();
+
+	FResult& Result = Results.AddDefaulted_GetRef();
+	Result.Name = Name;
+	Result.Min = Samples[0];
+	Result.Median = Samples[Samples.Num() / 2];
+	Result.P99 = Samples[FMath::Min(FMath::FloorToInt32(Samples.Num() * 0.99), Samples.Num() - 1)];
+	Result.OpsPerSecond = Result.Median > 0.0 ? 1.0e9 / Result.Median : 0.0;
+
+}
+
+void FDreamEatingMicrobenchmark::LogResults() const
+{
+	UE_LOG(LogDreamEatingBench, Display, TEXT("%d benchmarks, %d samples each"), Results.Num(), NumSamples);
+
+	for (const FResult& Result : Results)
+	{
+		UE_LOG(LogDreamEatingBench, Display, TEXT("%-40s min %10.1f ns  median %10.1f ns  p99 %10.1f ns  %14.0f ops/s"), *Result.Name, Result.Min, Result.Median, Result.P99, Result.OpsPerSecond);
+	}
+}
+
+bool FDreamEatingMicrobenchmark::WriteJson(const FString& Path) const
+{
+	FString Output = TEXT("{\n\t\"benchmarks\": [\n");
+
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const FResult& Result = Results[Index];
+
+		Output += FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"samples\": %d, \"min_ns\": %.3f, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"ops_per_sec\": %.1f }%s\n"),
+			*Result.Name, NumSamples, Result.Min, Result.Median, Result.P99, Result.OpsPerSecond, Index + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+
+	Output += TEXT("\t]\n}\n");
+
+	return FFileHelper::SaveStringToFile(Output, *Path);
+}
@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Log category for the benchmark program */
+DECLARE_LOG_CATEGORY_EXTERN(LogDreamEatingBench, Log, All);
+
+/**
+ *  Minimal microbenchmark runner.
+ *  Each benchmark body runs a batch of operations per call. The runner warms it up, takes a number of timed samples
+ *  and reports the min, median and p99 time per operation along with the median throughput.
+ */
+class FDreamEatingMicrobenchmark
+{
+public:
+
+	/** Results of a single benchmark */
+	struct FResult
+	{
+		/** Benchmark name */
+		FString Name;
+
+		/** Fastest sample, in nanoseconds per operation */
+		double Min = 0.0;
+
+		/** Median sample, in nanoseconds per operation */
+		double Median = 0.0;
+
+		/** 99th percentile sample, in nanoseconds per operation */
+		double P99 = 0.0;
+
+		/** Operations per second at the median */
+		double OpsPerSecond = 0.0;
+	};
+
+	/** Constructor. Only benchmarks whose name contains the filter are run */
+	FDreamEatingMicrobenchmark(int32 InNumSamples, const FString& InFilter);
+
+	/** Runs a benchmark. Body is timed once per sample and must perform OpsPerCall operations */
+	void Run(const TCHAR* Name, int32 OpsPerCall, TFunctionRef<void()> Body);
+
+	/** Logs the results table */
+	void LogResults() const;
+
+	/** Writes the results as JSON to the given path. Returns false if the file couldn't be written */
+	bool WriteJson(const FString& Path) const;
+
+	/** Returns the results gathered so far */
+	const TArray<FResult>& GetResults() const { return Results; }
+
+	/** Keeps the compiler from optimizing away a result */
+	template<typename ValueType>
+	static void DoNotOptimize(const ValueType& Value)
+	{
+		// a volatile read forces the value to be materialized
+		Sink = Sink + *reinterpret_cast<const volatile uint8*>(&Value);
+	}
+
+protected:
+
+	/** Number of timed samples per benchmark */
+	int32 NumSamples;
+
+	/** Benchmark name filter */
+	FString Filter;
+
+	/** Results in the order the benchmarks were run */
+	TArray<FResult> Results;
+
+	/** Sink for DoNotOptimize */
+	static volatile uint64 Sink;
+};
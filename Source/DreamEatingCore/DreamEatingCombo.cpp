@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingCombo.h"
+
+bool FDreamEatingCombo::AddHit(int32 Value, int32 IncrementMax, int32 Cap, bool& bOutMultiplierChanged)
+{
+	bOutMultiplierChanged = false;
+
+	// multiply the base score by the combo multiplier and add it to the score
+	Score += Value * Multiplier;
+
+	// past the cap, hits only add score
+	if (Multiplier > Cap)
+	{
+		return false;
+	}
+
+	// is it time to increase the multiplier?
+	if (++Increment > IncrementMax)
+	{
+		Increment = 0;
+		++Multiplier;
+
+		bOutMultiplierChanged = true;
+	}
+
+	return true;
+}
+
+bool FDreamEatingCombo::Decay()
+{
+	// is the combo multiplier above min?
+	if (Multiplier > 1)
+	{
+		Increment = 0;
+		--Multiplier;
+
+		return true;
+	}
+
+	return false;
+}
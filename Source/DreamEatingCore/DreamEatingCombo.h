@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Score and combo multiplier rules for the Twin Stick Shooter variant.
+ *  Every hit adds its value times the multiplier to the score and counts toward the next multiplier increase.
+ *  The owner is responsible for timing the cooldown and calling Decay once it expires.
+ */
+struct DREAMEATINGCORE_API FDreamEatingCombo
+{
+	/** Current score */
+	int32 Score = 0;
+
+	/** Current combo multiplier */
+	int32 Multiplier = 1;
+
+	/** Hits counted toward the next multiplier increase */
+	int32 Increment = 0;
+
+	/**
+	 *  Adds a hit worth the given base value to the score.
+	 *  Returns false if the multiplier is already past the cap and the hit didn't count toward the combo.
+	 *  Sets bOutMultiplierChanged if the hit raised the multiplier.
+	 */
+	bool AddHit(int32 Value, int32 IncrementMax, int32 Cap, bool& bOutMultiplierChanged);
+
+	/** Ticks the multiplier down after the cooldown expires. Returns true if it dropped and the cooldown should restart */
+	bool Decay();
+};
@@ -0,0 +1,20 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class DreamEatingCore : ModuleRules
+{
+	public DreamEatingCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// engine-light on purpose, so the logic here can be benchmarked without booting the engine
+		PublicDependencyModuleNames.AddRange(new string[] {
+			"Core"
+		});
+
+		PublicIncludePaths.AddRange(new string[] {
+			"DreamEatingCore"
+		});
+	}
+}
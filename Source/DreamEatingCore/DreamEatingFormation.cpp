@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingFormation.h"
+
+void FDreamEatingFormation::MakeGrid(const FVector& Center, int32 NumSlots, float Spacing, TArray<FVector>& OutSlots)
+{
+	if (NumSlots <= 0)
+	{
+		return;
+	}
+
+	const int32 Columns = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumSlots)));
+	const FVector Origin = Center - FVector(Columns - 1, Columns - 1, 0.0f) * Spacing * 0.5f;
+
+	OutSlots.Reserve(OutSlots.Num() + NumSlots);
+
+	for (int32 Index = 0; Index < NumSlots; ++Index)
+	{
+		OutSlots.Add(Origin + FVector(Index % Columns, Index / Columns, 0.0f) * Spacing);
+	}
+}
+
+void FDreamEatingFormation::MakeRings(const FVector& Center, int32 NumSlots, float BaseRadius, float Spacing, TArray<FVector>& OutSlots)
+{
+	if (NumSlots <= 0)
+	{
+		return;
+	}
+
+	Spacing = FMath::Max(Spacing, 1.0f);
+	OutSlots.Reserve(OutSlots.Num() + NumSlots);
+
+	int32 Placed = 0;
+
+	// fill each ring as far as its circumference allows before moving out to the next one
+	for (int32 Ring = 0; Placed < NumSlots; ++Ring)
+	{
+		const float Radius = BaseRadius + Ring * Spacing;
+		const int32 RingCount = FMath::Min(FMath::Max(FMath::FloorToInt32(2.0f * PI * Radius / Spacing), 1), NumSlots - Placed);
+
+		for (int32 Index = 0; Index < RingCount; ++Index, ++Placed)
+		{
+			const float Angle = 2.0f * PI * Index / RingCount;
+			OutSlots.Add(Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Radius);
+		}
+	}
+}
+
+FVector FDreamEatingFormation::SampleDisc(const FRandomStream& RandomStream, const FVector& Center, float Radius)
+{
+	// the square root keeps the density uniform instead of bunching points at the center
+	const float Distance = Radius * FMath::Sqrt(RandomStream.FRand());
+	const float Angle = RandomStream.FRandRange(0.0f, 2.0f * PI);
+
+	return Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Distance;
+}
@@ -0,0 +1,20 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Slot layouts and point sampling for placing groups of units
+ */
+struct DREAMEATINGCORE_API FDreamEatingFormation
+{
+	/** Appends slots on a square grid centered on the given location */
+	static void MakeGrid(const FVector& Center, int32 NumSlots, float Spacing, TArray<FVector>& OutSlots);
+
+	/** Appends slots on concentric rings around the given location, starting at the base radius */
+	static void MakeRings(const FVector& Center, int32 NumSlots, float BaseRadius, float Spacing, TArray<FVector>& OutSlots);
+
+	/** Returns a uniformly distributed point inside the disc of the given radius on the XY plane */
+	static FVector SampleDisc(const FRandomStream& RandomStream, const FVector& Center, float Radius);
+};
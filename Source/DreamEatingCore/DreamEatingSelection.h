@@ -0,0 +1,109 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Ordered set of selected elements.
+ *  Keeps the selection order for iteration while answering membership queries in constant time,
+ *  so selecting every unit on screen doesn't scan the selection once per unit.
+ */
+template<typename ElementType>
+class TDreamEatingSelectionSet
+{
+public:
+
+	/** Adds an element. Returns false if it was already selected */
+	bool Add(ElementType Element)
+	{
+		bool bAlreadySelected = false;
+		Lookup.Add(Element, &bAlreadySelected);
+
+		if (bAlreadySelected)
+		{
+			return false;
+		}
+
+		Items.Add(Element);
+		return true;
+	}
+
+	/** Removes an element, keeping the order of the rest. Returns false if it wasn't selected */
+	bool Remove(ElementType Element)
+	{
+		if (Lookup.Remove(Element) == 0)
+		{
+			return false;
+		}
+
+		Items.RemoveSingle(Element);
+		return true;
+	}
+
+	/** Returns true if the element is selected */
+	bool Contains(ElementType Element) const { return Lookup.Contains(Element); }
+
+	/** Empties the selection but keeps its allocations */
+	void Reset()
+	{
+		Items.Reset();
+		Lookup.Reset();
+	}
+
+	/** Returns the number of selected elements */
+	int32 Num() const { return Items.Num(); }
+
+	/** Returns the selected elements in selection order */
+	const TArray<ElementType>& GetItems() const { return Items; }
+
+	/** Range for support */
+	auto begin() const { return Items.begin(); }
+	auto end() const { return Items.end(); }
+
+protected:
+
+	/** Selected elements in selection order */
+	TArray<ElementType> Items;
+
+	/** Selected elements for membership queries */
+	TSet<ElementType> Lookup;
+};
+
+/**
+ *  Selection queries shared by the game variants
+ */
+struct FDreamEatingSelection
+{
+	/**
+	 *  Returns the index of the element closest to the target on the XY plane, or INDEX_NONE if there is none.
+	 *  GetLocation is called as bool(const ElementType&, FVector&) and returns false to skip an element.
+	 *  Ties go to the earliest element.
+	 */
+	template<typename ElementType, typename LocationGetterType>
+	static int32 FindClosest2D(TConstArrayView<ElementType> Elements, const FVector& Target, LocationGetterType&& GetLocation)
+	{
+		int32 ClosestIndex = INDEX_NONE;
+		double ClosestDistance = 0.0;
+
+		for (int32 Index = 0; Index < Elements.Num(); ++Index)
+		{
+			FVector Location;
+
+			if (!GetLocation(Elements[Index], Location))
+			{
+				continue;
+			}
+
+			const double Distance = FVector::DistSquared2D(Target, Location);
+
+			if (ClosestIndex == INDEX_NONE || Distance < ClosestDistance)
+			{
+				ClosestIndex = Index;
+				ClosestDistance = Distance;
+			}
+		}
+
+		return ClosestIndex;
+	}
+};
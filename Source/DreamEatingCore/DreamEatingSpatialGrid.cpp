@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "DreamEatingSpatialGrid.h"
+
+void FDreamEatingSpatialGrid::Reset(float InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	NumPoints = 0;
+
+	// empty the cells but keep their allocations
+	for (TPair<FIntPoint, TArray<FPoint>>& Cell : Cells)
+	{
+		Cell.Value.Reset();
+	}
+}
+
+void FDreamEatingSpatialGrid::Add(int32 Index, const FVector& Location)
+{
+	Cells.FindOrAdd(GetCell(Location)).Add({ Index, FVector2D(Location) });
+	++NumPoints;
+}
+
+void FDreamEatingSpatialGrid::QueryRadius(const FVector& Center, float Radius, TArray<int32>& OutIndices) const
+{
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius));
+	const FVector2D Center2D(Center);
+	const double RadiusSquared = FMath::Square(Radius);
+
+	// check every point in the cells overlapping the query radius
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<FPoint>* Cell = Cells.Find(FIntPoint(X, Y));
+
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (const FPoint& Point : *Cell)
+			{
+				if (FVector2D::DistSquared(Center2D, Point.Location) <= RadiusSquared)
+				{
+					OutIndices.Add(Point.Index);
+				}
+			}
+		}
+	}
+}
+
+FIntPoint FDreamEatingSpatialGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
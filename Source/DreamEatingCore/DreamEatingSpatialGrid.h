@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Uniform 2D grid for proximity queries over indexed points.
+ *  Meant to be rebuilt from scratch when the points move: Reset keeps the cell allocations,
+ *  so rebuilding every frame doesn't allocate once the grid has warmed up.
+ */
+class DREAMEATINGCORE_API FDreamEatingSpatialGrid
+{
+public:
+
+	/** Empties the grid and sets its cell size, keeping the cell allocations */
+	void Reset(float InCellSize);
+
+	/** Adds a point with the caller's index for it */
+	void Add(int32 Index, const FVector& Location);
+
+	/** Appends the index of every point within the given 2D radius of a location */
+	void QueryRadius(const FVector& Center, float Radius, TArray<int32>& OutIndices) const;
+
+	/** Returns the number of points in the grid */
+	int32 Num() const { return NumPoints; }
+
+	/** Returns the grid cell for a location */
+	FIntPoint GetCell(const FVector& Location) const;
+
+protected:
+
+	/** Point stored in a cell */
+	struct FPoint
+	{
+		/** Caller's index for the point */
+		int32 Index;
+
+		/** Location on the XY plane */
+		FVector2D Location;
+	};
+
+	/** Points bucketed by grid cell */
+	TMap<FIntPoint, TArray<FPoint>> Cells;
+
+	/** Size of a grid cell, in cm */
+	float CellSize = 500.0f;
+
+	/** Number of points in the grid */
+	int32 NumPoints = 0;
+};